@@ -0,0 +1,125 @@
+#include "ivy/log.h"
+#include "ivy/math/batch_transform.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace ivy;
+
+// Each path is timed this many times and the fastest run is reported
+constexpr u32 NUM_RUNS = 5;
+
+/**
+ * \brief The per-entity path the renderer used before batching, one transform at a time
+ */
+static void compute_per_entity(const std::vector<glm::vec3> &positions, const std::vector<glm::quat> &orientations,
+                               const std::vector<glm::vec3> &scales, glm::mat4 *out_model, glm::mat4 *out_normal) {
+    for (size_t i = 0; i < positions.size(); ++i) {
+        out_model[i] = glm::translate(glm::mat4(1), positions[i]) *
+                       glm::mat4_cast(orientations[i]) *
+                       glm::scale(glm::mat4(1), scales[i]);
+        out_normal[i] = glm::inverse(glm::transpose(out_model[i]));
+    }
+}
+
+/**
+ * \brief Time a function
+ * \param func The function to time
+ * \return The fastest of NUM_RUNS runs in milliseconds
+ */
+template <typename F>
+static f64 time_best_ms(const F &func) {
+    f64 best = 0.0;
+    for (u32 run = 0; run < NUM_RUNS; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        f64 ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best = run == 0 ? ms : std::min(best, ms);
+    }
+
+    return best;
+}
+
+/**
+ * \brief Get the largest difference between two matrices, relative to the size of their elements
+ * \param a First matrix
+ * \param b Second matrix
+ * \param num_columns How many columns to compare
+ * \param num_rows How many rows to compare
+ * \return The largest relative difference
+ */
+static f32 max_relative_difference(const glm::mat4 &a, const glm::mat4 &b, u32 num_columns, u32 num_rows) {
+    f32 difference = 0.0f;
+    for (u32 c = 0; c < num_columns; ++c) {
+        for (u32 r = 0; r < num_rows; ++r) {
+            f32 scale = std::max({1.0f, std::abs(a[c][r]), std::abs(b[c][r])});
+            difference = std::max(difference, std::abs(a[c][r] - b[c][r]) / scale);
+        }
+    }
+
+    return difference;
+}
+
+/**
+ * \brief Benchmark compute_transform_matrices against the per-entity glm path
+ * \param count The number of transforms
+ * \return Whether or not both paths computed the same matrices
+ */
+static bool run_benchmark(u32 count) {
+    std::mt19937 rng(count);
+    std::uniform_real_distribution<f32> positionDist(-100.0f, 100.0f);
+    std::uniform_real_distribution<f32> angleDist(-3.14159f, 3.14159f);
+    std::uniform_real_distribution<f32> scaleDist(0.25f, 4.0f);
+
+    std::vector<glm::vec3> positions(count), scales(count);
+    std::vector<glm::quat> orientations(count);
+    TransformBatch batch;
+    for (u32 i = 0; i < count; ++i) {
+        positions[i] = glm::vec3(positionDist(rng), positionDist(rng), positionDist(rng));
+        orientations[i] = glm::quat(glm::vec3(angleDist(rng), angleDist(rng), angleDist(rng)));
+        scales[i] = glm::vec3(scaleDist(rng), scaleDist(rng), scaleDist(rng));
+        batch.add(positions[i], orientations[i], scales[i]);
+    }
+
+    std::vector<glm::mat4> glmModel(count), glmNormal(count);
+    std::vector<glm::mat4> batchModel(count), batchNormal(count);
+
+    f64 glmMs = time_best_ms([&]() {
+        compute_per_entity(positions, orientations, scales, glmModel.data(), glmNormal.data());
+    });
+    f64 batchMs = time_best_ms([&]() {
+        compute_transform_matrices(batch, batchModel.data(), batchNormal.data());
+    });
+
+    // The normal matrices only agree in the upper 3x3, the batched one leaves out the translation terms that the
+    // full 4x4 inverse puts in its last row
+    f32 modelDifference = 0.0f;
+    f32 normalDifference = 0.0f;
+    for (u32 i = 0; i < count; ++i) {
+        modelDifference = std::max(modelDifference, max_relative_difference(glmModel[i], batchModel[i], 4, 4));
+        normalDifference = std::max(normalDifference, max_relative_difference(glmNormal[i], batchNormal[i], 3, 3));
+    }
+
+    Log::info("% transforms: per-entity glm %ms, batched %ms (%x), max difference model % normal %", count, glmMs,
+              batchMs, glmMs / batchMs, modelDifference, normalDifference);
+
+    constexpr f32 TOLERANCE = 1e-4f;
+    if (modelDifference > TOLERANCE || normalDifference > TOLERANCE) {
+        Log::warn("Batched matrices for % transforms don't match the per-entity glm path", count);
+        return false;
+    }
+
+    return true;
+}
+
+int main() {
+    bool matches = true;
+    for (u32 count : {10000u, 100000u, 1000000u}) {
+        matches &= run_benchmark(count);
+    }
+
+    return matches ? 0 : 1;
+}
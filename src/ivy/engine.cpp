@@ -4,8 +4,8 @@
 namespace ivy {
 
 Engine::Engine(const Options &options)
-    : options_(options), platform_(options_), renderDevice_(options, platform_),
-      resourceManager_(renderDevice_, "../assets") {
+    : options_(options), threadPool_(options_.numWorkerThreads), platform_(options_), renderDevice_(options, platform_),
+      resourceManager_(renderDevice_, threadPool_, "../assets") {
     LOG_CHECKPOINT();
 }
 
@@ -24,6 +24,9 @@ void Engine::run(const std::function<void()> &init_func, const std::function<voi
         // Poll events
         platform_.update();
 
+        // Finish resources that were loaded in the background
+        resourceManager_.update();
+
         // Update and render game
         update_func();
         render_func();
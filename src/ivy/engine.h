@@ -5,6 +5,7 @@
 #include "ivy/platform/platform.h"
 #include "ivy/graphics/render_device.h"
 #include "ivy/resources/resource_manager.h"
+#include "ivy/utils/thread_pool.h"
 
 namespace ivy {
 
@@ -40,8 +41,13 @@ public:
         return resourceManager_;
     }
 
+    ThreadPool &getThreadPool() {
+        return threadPool_;
+    }
+
 private:
     Options options_;
+    ThreadPool threadPool_;
     Platform platform_;
     gfx::RenderDevice renderDevice_;
     ResourceManager resourceManager_;
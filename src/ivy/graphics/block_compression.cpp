@@ -0,0 +1,277 @@
+#include "block_compression.h"
+#include "ivy/log.h"
+#include "ivy/graphics/mipmap.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ivy::gfx {
+
+constexpr u32 BLOCK_DIM = 4;
+constexpr u32 BLOCK_TEXELS = BLOCK_DIM * BLOCK_DIM;
+
+/**
+ * \brief Quantize a color to 5:6:5 bits, the way endpoints of BC1 blocks are stored
+ * \param color The color, each channel from 0 to 255
+ * \return The packed color
+ */
+static u16 pack_565(const f32 color[3]) {
+    u32 r = (u32) std::clamp(color[0] * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f);
+    u32 g = (u32) std::clamp(color[1] * 63.0f / 255.0f + 0.5f, 0.0f, 63.0f);
+    u32 b = (u32) std::clamp(color[2] * 31.0f / 255.0f + 0.5f, 0.0f, 31.0f);
+    return (u16) ((r << 11) | (g << 5) | b);
+}
+
+/**
+ * \brief Expand a 5:6:5 color to 8 bits per channel
+ * \param color The packed color
+ * \param out_color The channels are written here
+ */
+static void unpack_565(u16 color, i32 out_color[3]) {
+    i32 r = (color >> 11) & 31;
+    i32 g = (color >> 5) & 63;
+    i32 b = color & 31;
+    out_color[0] = (r << 3) | (r >> 2);
+    out_color[1] = (g << 2) | (g >> 4);
+    out_color[2] = (b << 3) | (b >> 2);
+}
+
+/**
+ * \brief Encode the colors of a block as BC1 with four colors, alpha is ignored
+ * \param texels The texels of the block in RGBA, row by row
+ * \param out The 8 byte block is written here
+ */
+static void encode_bc1_block(const u8 texels[BLOCK_TEXELS][4], u8 *out) {
+    f32 mean[3] = {};
+    f32 boxMin[3] = {255.0f, 255.0f, 255.0f};
+    f32 boxMax[3] = {};
+    for (u32 i = 0; i < BLOCK_TEXELS; ++i) {
+        for (u32 c = 0; c < 3; ++c) {
+            mean[c] += texels[i][c];
+            boxMin[c] = std::min(boxMin[c], (f32) texels[i][c]);
+            boxMax[c] = std::max(boxMax[c], (f32) texels[i][c]);
+        }
+    }
+    for (f32 &c : mean) {
+        c /= BLOCK_TEXELS;
+    }
+
+    // Covariance of the colors, stored as rr, rg, rb, gg, gb, bb
+    f32 covariance[6] = {};
+    for (u32 i = 0; i < BLOCK_TEXELS; ++i) {
+        f32 r = texels[i][0] - mean[0];
+        f32 g = texels[i][1] - mean[1];
+        f32 b = texels[i][2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    // The endpoints are on the principal axis, found with a few rounds of power iteration starting from the diagonal
+    // of the bounding box
+    f32 axis[3] = {boxMax[0] - boxMin[0], boxMax[1] - boxMin[1], boxMax[2] - boxMin[2]};
+    for (u32 iteration = 0; iteration < 4; ++iteration) {
+        f32 r = axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2];
+        f32 g = axis[0] * covariance[1] + axis[1] * covariance[3] + axis[2] * covariance[4];
+        f32 b = axis[0] * covariance[2] + axis[1] * covariance[4] + axis[2] * covariance[5];
+
+        f32 largest = std::max({std::abs(r), std::abs(g), std::abs(b)});
+        if (largest == 0.0f) {
+            break;
+        }
+
+        axis[0] = r / largest;
+        axis[1] = g / largest;
+        axis[2] = b / largest;
+    }
+
+    f32 length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    f32 minT = 0.0f;
+    f32 maxT = 0.0f;
+    if (length > 0.0f) {
+        for (f32 &c : axis) {
+            c /= length;
+        }
+
+        minT = maxT = (texels[0][0] - mean[0]) * axis[0] + (texels[0][1] - mean[1]) * axis[1] +
+                      (texels[0][2] - mean[2]) * axis[2];
+        for (u32 i = 1; i < BLOCK_TEXELS; ++i) {
+            f32 t = (texels[i][0] - mean[0]) * axis[0] + (texels[i][1] - mean[1]) * axis[1] +
+                    (texels[i][2] - mean[2]) * axis[2];
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+    }
+
+    f32 endpoint0[3], endpoint1[3];
+    for (u32 c = 0; c < 3; ++c) {
+        endpoint0[c] = mean[c] + axis[c] * maxT;
+        endpoint1[c] = mean[c] + axis[c] * minT;
+    }
+
+    // The first endpoint has to be larger for the block to use four colors
+    u16 color0 = pack_565(endpoint0);
+    u16 color1 = pack_565(endpoint1);
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    u32 indices = 0;
+    if (color0 != color1) {
+        i32 palette[4][3];
+        unpack_565(color0, palette[0]);
+        unpack_565(color1, palette[1]);
+        for (u32 c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (u32 i = 0; i < BLOCK_TEXELS; ++i) {
+            u32 best = 0;
+            i32 bestError = std::numeric_limits<i32>::max();
+            for (u32 p = 0; p < 4; ++p) {
+                i32 error = 0;
+                for (u32 c = 0; c < 3; ++c) {
+                    i32 d = texels[i][c] - palette[p][c];
+                    error += d * d;
+                }
+
+                if (error < bestError) {
+                    best = p;
+                    bestError = error;
+                }
+            }
+
+            indices |= best << (2 * i);
+        }
+    }
+
+    out[0] = (u8) color0;
+    out[1] = (u8) (color0 >> 8);
+    out[2] = (u8) color1;
+    out[3] = (u8) (color1 >> 8);
+    for (u32 i = 0; i < 4; ++i) {
+        out[4 + i] = (u8) (indices >> (8 * i));
+    }
+}
+
+/**
+ * \brief Encode a single channel block with eight values, the format of BC4 blocks and of the alpha of BC3 blocks
+ * \param values The values of the block, row by row
+ * \param out The 8 byte block is written here
+ */
+static void encode_bc4_block(const u8 values[BLOCK_TEXELS], u8 *out) {
+    u8 lowest = *std::min_element(values, values + BLOCK_TEXELS);
+    u8 highest = *std::max_element(values, values + BLOCK_TEXELS);
+
+    // The endpoints are exact, every other value is one of six steps between them
+    u64 indices = 0;
+    if (highest > lowest) {
+        i32 range = highest - lowest;
+        for (u32 i = 0; i < BLOCK_TEXELS; ++i) {
+            // Nearest step from the lowest value, in sevenths of the range
+            i32 step = ((values[i] - lowest) * 14 + range) / (2 * range);
+            u64 index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+            indices |= index << (3 * i);
+        }
+    }
+
+    out[0] = highest;
+    out[1] = lowest;
+    for (u32 i = 0; i < 6; ++i) {
+        out[2 + i] = (u8) (indices >> (8 * i));
+    }
+}
+
+/**
+ * \brief Compress a single level
+ * \param channels The number of channels of the source level
+ * \param dst_format The block compressed format
+ * \param width The width of the level
+ * \param height The height of the level
+ * \param src The source level
+ * \param dst The compressed level is written here
+ */
+static void compress_level(u32 channels, VkFormat dst_format, u32 width, u32 height, const u8 *src, u8 *dst) {
+    u32 blockSize = (u32) get_image_layer_size(dst_format, 1, 1);
+
+    for (u32 blockY = 0; blockY < height; blockY += BLOCK_DIM) {
+        for (u32 blockX = 0; blockX < width; blockX += BLOCK_DIM) {
+            // Edges of levels that aren't a multiple of the block size are clamped
+            u8 texels[BLOCK_TEXELS][4] = {};
+            for (u32 y = 0; y < BLOCK_DIM; ++y) {
+                for (u32 x = 0; x < BLOCK_DIM; ++x) {
+                    u32 srcX = std::min(blockX + x, width - 1);
+                    u32 srcY = std::min(blockY + y, height - 1);
+                    const u8 *texel = src + (srcY * width + srcX) * channels;
+                    std::copy(texel, texel + channels, texels[y * BLOCK_DIM + x]);
+                }
+            }
+
+            u8 values[2][BLOCK_TEXELS];
+            auto getChannel = [&](u32 channel, u8 *out_values) {
+                for (u32 i = 0; i < BLOCK_TEXELS; ++i) {
+                    out_values[i] = texels[i][channel];
+                }
+                return out_values;
+            };
+
+            switch (dst_format) {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                    encode_bc1_block(texels, dst);
+                    break;
+                case VK_FORMAT_BC3_UNORM_BLOCK:
+                    encode_bc4_block(getChannel(3, values[0]), dst);
+                    encode_bc1_block(texels, dst + 8);
+                    break;
+                case VK_FORMAT_BC4_UNORM_BLOCK:
+                    encode_bc4_block(getChannel(0, values[0]), dst);
+                    break;
+                case VK_FORMAT_BC5_UNORM_BLOCK:
+                    encode_bc4_block(getChannel(0, values[0]), dst);
+                    encode_bc4_block(getChannel(1, values[1]), dst + 8);
+                    break;
+                default:
+                    Log::fatal("Can't compress to image format: %", dst_format);
+            }
+
+            dst += blockSize;
+        }
+    }
+}
+
+bool can_compress(VkFormat src_format, VkFormat dst_format) {
+    switch (dst_format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            return src_format == VK_FORMAT_R8G8B8A8_UNORM;
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+            return src_format == VK_FORMAT_R8_UNORM;
+        default:
+            return false;
+    }
+}
+
+void compress_mip_chain(VkFormat src_format, VkFormat dst_format, u32 width, u32 height, u32 mip_levels,
+                        const u8 *src_data, std::vector<u8> &out_data) {
+    if (!can_compress(src_format, dst_format)) {
+        Log::fatal("Can't compress image format % to %", src_format, dst_format);
+    }
+
+    u32 channels = src_format == VK_FORMAT_R8_UNORM ? 1 : 4;
+
+    std::vector<VkDeviceSize> srcOffsets, dstOffsets;
+    get_mip_chain_layout(src_format, width, height, 1, mip_levels, &srcOffsets);
+    out_data.assign(get_mip_chain_layout(dst_format, width, height, 1, mip_levels, &dstOffsets), 0);
+
+    for (u32 level = 0; level < mip_levels; ++level) {
+        compress_level(channels, dst_format, std::max(width >> level, 1u), std::max(height >> level, 1u),
+                       src_data + srcOffsets[level], out_data.data() + dstOffsets[level]);
+    }
+}
+
+}
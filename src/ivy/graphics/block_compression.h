@@ -0,0 +1,39 @@
+#ifndef IVY_BLOCK_COMPRESSION_H
+#define IVY_BLOCK_COMPRESSION_H
+
+#include "ivy/types.h"
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace ivy::gfx {
+
+/**
+ * \brief Check if images can be compressed to a format by compress_mip_chain
+ * \param src_format The format of the uncompressed image
+ * \param dst_format The block compressed format
+ * \return Whether or not the conversion is supported
+ */
+bool can_compress(VkFormat src_format, VkFormat dst_format);
+
+/**
+ * \brief Compress every level of a mip chain to a block compressed format. Each 4x4 block is fit to the principal axis
+ * of its colors, which is fast and good enough for textures that are cooked once.
+ * Supported conversions:
+ *   VK_FORMAT_R8G8B8A8_UNORM to VK_FORMAT_BC1_RGB_UNORM_BLOCK, alpha is dropped
+ *   VK_FORMAT_R8G8B8A8_UNORM to VK_FORMAT_BC3_UNORM_BLOCK
+ *   VK_FORMAT_R8G8B8A8_UNORM to VK_FORMAT_BC5_UNORM_BLOCK, only red and green are kept
+ *   VK_FORMAT_R8_UNORM to VK_FORMAT_BC4_UNORM_BLOCK
+ * \param src_format The format of the mip chain, fatal error if the conversion isn't supported
+ * \param dst_format The block compressed format
+ * \param width The width of the largest level
+ * \param height The height of the largest level
+ * \param mip_levels The number of mip levels
+ * \param src_data The mip chain, laid out as described by get_mip_chain_layout
+ * \param out_data The compressed mip chain is written here, laid out as described by get_mip_chain_layout
+ */
+void compress_mip_chain(VkFormat src_format, VkFormat dst_format, u32 width, u32 height, u32 mip_levels,
+                        const u8 *src_data, std::vector<u8> &out_data);
+
+}
+
+#endif // IVY_BLOCK_COMPRESSION_H
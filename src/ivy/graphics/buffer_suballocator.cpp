@@ -0,0 +1,32 @@
+#include "buffer_suballocator.h"
+#include "ivy/log.h"
+#include <algorithm>
+#include <utility>
+
+namespace ivy::gfx {
+
+BufferSuballocator::BufferSuballocator(VkDeviceSize block_size, std::function<VkBuffer(VkDeviceSize)> create_buffer)
+    : blockSize_(block_size), createBuffer_(std::move(create_buffer)) {}
+
+BufferRange BufferSuballocator::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    if (size == 0 || alignment == 0) {
+        Log::fatal("Invalid buffer sub-allocation of % bytes with an alignment of %", size, alignment);
+    }
+
+    for (Block &block : blocks_) {
+        VkDeviceSize offset = (block.used + alignment - 1) / alignment * alignment;
+        if (offset <= block.size && size <= block.size - offset) {
+            block.used = offset + size;
+            return {block.buffer, offset};
+        }
+    }
+
+    // Nothing has room, start a new block that is large enough
+    VkDeviceSize newSize = std::max(blockSize_, size);
+    Log::debug("Creating a % byte buffer for sub-allocation", newSize);
+
+    blocks_.push_back({createBuffer_(newSize), newSize, size});
+    return {blocks_.back().buffer, 0};
+}
+
+}
@@ -0,0 +1,61 @@
+#ifndef IVY_BUFFER_SUBALLOCATOR_H
+#define IVY_BUFFER_SUBALLOCATOR_H
+
+#include "ivy/types.h"
+#include <vulkan/vulkan.h>
+#include <functional>
+#include <vector>
+
+namespace ivy::gfx {
+
+/**
+ * \brief A range of a buffer that was handed out by a BufferSuballocator
+ */
+struct BufferRange {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+};
+
+/**
+ * \brief Packs many small allocations into a few large buffers. Nothing is ever freed, allocations live as long as the
+ * buffers do, which suits static geometry that is loaded once.
+ */
+class BufferSuballocator {
+public:
+    /**
+     * \param block_size The size of the large buffers, allocations that don't fit get a buffer of their own
+     * \param create_buffer Creates a buffer of a given size in bytes
+     */
+    BufferSuballocator(VkDeviceSize block_size, std::function<VkBuffer(VkDeviceSize)> create_buffer);
+
+    /**
+     * \brief Allocate a range in the first buffer that has room for it, creates a new buffer if none do
+     * \param size Size in bytes
+     * \param alignment The offset will be a multiple of this, it doesn't have to be a power of two
+     * \return The range
+     */
+    BufferRange allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+    /**
+     * \brief Get the number of buffers that were created
+     * \return The number of buffers
+     */
+    [[nodiscard]] u32 getNumBuffers() const {
+        return (u32) blocks_.size();
+    }
+
+private:
+    struct Block {
+        VkBuffer buffer;
+        VkDeviceSize size;
+        VkDeviceSize used;
+    };
+
+    VkDeviceSize blockSize_;
+    std::function<VkBuffer(VkDeviceSize)> createBuffer_;
+    std::vector<Block> blocks_;
+};
+
+}
+
+#endif // IVY_BUFFER_SUBALLOCATOR_H
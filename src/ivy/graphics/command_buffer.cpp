@@ -1,6 +1,7 @@
 #include "command_buffer.h"
 #include "render_device.h"
 #include "ivy/consts.h"
+#include "ivy/log.h"
 
 namespace ivy::gfx {
 
@@ -64,25 +65,59 @@ void CommandBuffer::nextSubpass() {
 }
 
 void CommandBuffer::setDescriptorSet(RenderDevice &device, const GraphicsPass &pass, const DescriptorSet &set) {
-    if (consts::DEBUG) {
+    if constexpr (consts::DEBUG) {
         set.validate();
     }
 
-    VkDescriptorSet vkSet = device.getVkDescriptorSet(pass, set);
+    VkDescriptorSet vkSet = device.getVkDescriptorSet(pass, set, dynamicOffsets_);
 
     vkCmdBindDescriptorSets(commandBuffer_, VK_PIPELINE_BIND_POINT_GRAPHICS,
                             pass.getSubpass(set.getSubpassIndex()).getPipelineLayout(), set.getSetIndex(),
-                            1, &vkSet, 0, nullptr);
+                            1, &vkSet, (u32) dynamicOffsets_.size(), dynamicOffsets_.data());
+}
+
+void CommandBuffer::pushConstants(const GraphicsPass &pass, u32 subpass, VkShaderStageFlags stage_flags, u32 offset,
+                                  u32 size, const void *data) {
+    const Subpass &sp = pass.getSubpass(subpass);
+
+    if constexpr (consts::DEBUG) {
+        // The pushed bytes have to be inside a range that was declared for exactly these stages
+        bool found = false;
+        for (const VkPushConstantRange &range : sp.getPushConstantRanges()) {
+            if (range.stageFlags == stage_flags && offset >= range.offset &&
+                offset + size <= range.offset + range.size) {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            Log::fatal("% bytes of push constants at offset % are not in a range of subpass %", size, offset,
+                       sp.getName());
+        }
+    }
+
+    vkCmdPushConstants(commandBuffer_, sp.getPipelineLayout(), stage_flags, offset, size, data);
 }
 
 void CommandBuffer::bindVertexBuffer(VkBuffer buffer) {
+    if (buffer == boundVertexBuffer_) {
+        return;
+    }
+
     VkDeviceSize offsets[] = { 0 };
 
     vkCmdBindVertexBuffers(commandBuffer_, 0, 1, &buffer, offsets);
+    boundVertexBuffer_ = buffer;
 }
 
 void CommandBuffer::bindIndexBuffer(VkBuffer buffer) {
+    if (buffer == boundIndexBuffer_) {
+        return;
+    }
+
     vkCmdBindIndexBuffer(commandBuffer_, buffer, 0, VK_INDEX_TYPE_UINT32);
+    boundIndexBuffer_ = buffer;
 }
 
 void CommandBuffer::draw(u32 num_vertices, u32 num_instances, u32 first_vertex, u32 first_instance) {
@@ -135,6 +170,11 @@ void CommandBuffer::copyBufferToImage(VkBuffer src, VkImage dst, VkImageLayout d
     vkCmdCopyBufferToImage(commandBuffer_, src, dst, dst_layout, 1, &region);
 }
 
+void CommandBuffer::copyBufferToImage(VkBuffer src, VkImage dst, VkImageLayout dst_layout, u32 num_regions,
+                                      const VkBufferImageCopy *regions) {
+    vkCmdCopyBufferToImage(commandBuffer_, src, dst, dst_layout, num_regions, regions);
+}
+
 void CommandBuffer::copyImage(VkImage src, VkImageLayout src_layout, VkImage dst, VkImageLayout dst_layout,
                               u32 num_regions, const VkImageCopy *regions) {
     vkCmdCopyImage(commandBuffer_, src, src_layout, dst, dst_layout, num_regions, regions);
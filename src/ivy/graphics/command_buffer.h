@@ -7,6 +7,7 @@
 #include "ivy/graphics/descriptor_set.h"
 #include <vulkan/vulkan.h>
 #include <functional>
+#include <vector>
 
 namespace ivy::gfx {
 
@@ -28,6 +29,15 @@ public:
 
     void setDescriptorSet(RenderDevice &device, const GraphicsPass &pass, const DescriptorSet &set);
 
+    void pushConstants(const GraphicsPass &pass, u32 subpass, VkShaderStageFlags stage_flags, u32 offset, u32 size,
+                       const void *data);
+
+    template <typename T>
+    void pushConstants(const GraphicsPass &pass, u32 subpass, VkShaderStageFlags stage_flags, const T &data,
+                       u32 offset = 0) {
+        pushConstants(pass, subpass, stage_flags, offset, sizeof(T), &data);
+    }
+
     void bindVertexBuffer(VkBuffer buffer);
 
     void bindIndexBuffer(VkBuffer buffer);
@@ -47,6 +57,9 @@ public:
     void copyBufferToImage(VkBuffer src, VkImage dst, VkImageLayout dst_layout, VkImageAspectFlags image_aspect,
                            u32 width, u32 height, u32 depth, u32 layers);
 
+    void copyBufferToImage(VkBuffer src, VkImage dst, VkImageLayout dst_layout, u32 num_regions,
+                           const VkBufferImageCopy *regions);
+
     void copyImage(VkImage src, VkImageLayout src_layout, VkImage dst, VkImageLayout dst_layout, u32 num_regions,
                    const VkImageCopy *regions);
 
@@ -60,6 +73,13 @@ public:
 
 private:
     VkCommandBuffer commandBuffer_;
+
+    // Bindings persist for the whole command buffer, so binding the same buffers again can be skipped
+    VkBuffer boundVertexBuffer_ = VK_NULL_HANDLE;
+    VkBuffer boundIndexBuffer_ = VK_NULL_HANDLE;
+
+    // Reused between descriptor set binds to avoid allocating
+    std::vector<u32> dynamicOffsets_;
 };
 
 }
@@ -2,6 +2,7 @@
 #include "ivy/log.h"
 #include "ivy/graphics/graphics_pass.h"
 #include "ivy/graphics/vk_utils.h"
+#include <algorithm>
 #include <set>
 #include <unordered_map>
 #include <cstring>
@@ -26,6 +27,22 @@ void DescriptorSet::setUniformBuffer(u32 binding, const void *data, size_t size)
     uniformBufferInfos_.emplace_back(binding, offset, range);
 }
 
+void DescriptorSet::setDynamicUniformBuffer(u32 binding, const void *data, size_t size) {
+    u32 offset = uniformBufferData_.size();
+    u32 range = size;
+
+    uniformBufferData_.resize(offset + range);
+    std::memcpy(uniformBufferData_.data() + offset, data, range);
+
+    // Dynamic offsets are bound in binding order
+    auto byBinding = [](u32 b, const UniformBufferDescriptorInfo &info) {
+        return b < info.binding;
+    };
+    auto it = std::upper_bound(dynamicUniformBufferInfos_.begin(), dynamicUniformBufferInfos_.end(), binding,
+                               byBinding);
+    dynamicUniformBufferInfos_.emplace(it, binding, offset, range);
+}
+
 void DescriptorSet::setTexture(u32 binding, const Texture &texture, VkSampler sampler) {
     setTexture(binding, texture.getImageView(), sampler);
 }
@@ -74,6 +91,11 @@ void DescriptorSet::validate() const {
         validateBinding(info.binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
     }
 
+    // Check dynamic buffer bindings
+    for (const UniformBufferDescriptorInfo &info : dynamicUniformBufferInfos_) {
+        validateBinding(info.binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+    }
+
     // Check combined image sampler bindings
     for (const CombinedImageSamplerDescriptorInfo &info : combinedImageSamplerInfos_) {
         validateBinding(info.binding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
@@ -83,6 +83,25 @@ public:
         setUniformBuffer(binding, &data, sizeof(T));
     }
 
+    /**
+     * \brief Set a dynamic uniform buffer in the descriptor set
+     * \param binding The binding in the set for the dynamic uniform buffer
+     * \param data A pointer to the data to copy into the uniform buffer
+     * \param size Number of bytes
+     */
+    void setDynamicUniformBuffer(u32 binding, const void *data, size_t size);
+
+    /**
+     * \brief Set a dynamic uniform buffer in the descriptor set
+     * \tparam T The datatype for the data
+     * \param binding The binding in the set for the dynamic uniform buffer
+     * \param data The data to copy into the uniform buffer
+     */
+    template <typename T>
+    void setDynamicUniformBuffer(u32 binding, const T &data) {
+        setDynamicUniformBuffer(binding, &data, sizeof(T));
+    }
+
     /**
      * \brief Set a 2D texture in the descriptor set
      * \param binding The binding in the set for the texture
@@ -136,6 +155,15 @@ public:
         return uniformBufferInfos_;
     }
 
+    /**
+     * \brief Get the dynamic uniform buffer infos for this descriptor set, sorted by binding like the dynamic offsets
+     * they are bound with
+     * \return Vector of UniformBufferDescriptorInfo
+     */
+    [[nodiscard]] const std::vector<UniformBufferDescriptorInfo> &getDynamicUniformBufferInfos() const {
+        return dynamicUniformBufferInfos_;
+    }
+
     /**
      * \brief Get the combined image sampler infos for this descriptor set
      * \return Vector of CombinedImageSamplerDescriptorInfo
@@ -158,6 +186,7 @@ private:
 
     std::vector<InputAttachmentDescriptorInfo> inputAttachmentInfos_;
     std::vector<UniformBufferDescriptorInfo> uniformBufferInfos_;
+    std::vector<UniformBufferDescriptorInfo> dynamicUniformBufferInfos_;
     std::vector<CombinedImageSamplerDescriptorInfo> combinedImageSamplerInfos_;
     std::vector<u8> uniformBufferData_;
 };
@@ -1,7 +1,31 @@
 #include "descriptor_set_cache.h"
+#include "ivy/utils/utils.h"
+#include <utility>
 
 namespace ivy::gfx {
 
+size_t DescriptorSetCache::ContentsHash::operator()(const Contents_t &contents) const {
+    return (size_t) hash_bytes(contents.data(), contents.size() * sizeof(contents[0]));
+}
+
+DescriptorSetCache::DescriptorSetCache(u32 max_unused_frames)
+    : maxUnusedFrames_(max_unused_frames) {}
+
+VkDescriptorSet DescriptorSetCache::findSetWithContents(const Contents_t &contents) {
+    auto it = entries_.find(contents);
+    if (it == entries_.end()) {
+        return VK_NULL_HANDLE;
+    }
+
+    // Sets can be bound more than once a frame, only count them once
+    if (it->second.lastUsedFrame != frame_) {
+        it->second.lastUsedFrame = frame_;
+        ++numUsed_;
+    }
+
+    return it->second.set;
+}
+
 VkDescriptorSet DescriptorSetCache::findSetWithLayout(VkDescriptorSetLayout layout) {
     std::stack<VkDescriptorSet> &availableSets = availableSetStacks_[layout];
 
@@ -11,39 +35,58 @@ VkDescriptorSet DescriptorSetCache::findSetWithLayout(VkDescriptorSetLayout layo
 
     VkDescriptorSet set = availableSets.top();
     availableSets.pop();
-    usedSetStacks_[layout].push(set);
 
     return set;
 }
 
-void DescriptorSetCache::addToCache(VkDescriptorSetLayout layout, VkDescriptorSet set) {
-    usedSetStacks_[layout].push(set);
+void DescriptorSetCache::addToCache(VkDescriptorSetLayout layout, Contents_t contents, VkDescriptorSet set) {
+    entries_[std::move(contents)] = {layout, set, frame_};
+    ++numUsed_;
 }
 
-void DescriptorSetCache::markAllAsAvailable() {
-    for (auto &usedSetsPair : usedSetStacks_) {
-        VkDescriptorSetLayout layout = usedSetsPair.first;
+void DescriptorSetCache::addTransient(VkDescriptorSetLayout layout, VkDescriptorSet set) {
+    transientSetStacks_[layout].push(set);
+    ++numUsed_;
+}
+
+void DescriptorSetCache::nextFrame() {
+    ++frame_;
+    numUsed_ = 0;
+
+    for (auto &transientSetsPair : transientSetStacks_) {
+        VkDescriptorSetLayout layout = transientSetsPair.first;
 
-        std::stack<VkDescriptorSet> &used = usedSetsPair.second;
+        std::stack<VkDescriptorSet> &transient = transientSetsPair.second;
         std::stack<VkDescriptorSet> &available = availableSetStacks_[layout];
 
-        while (!used.empty()) {
-            available.push(used.top());
-            used.pop();
+        while (!transient.empty()) {
+            available.push(transient.top());
+            transient.pop();
+        }
+    }
+
+    // Evict sets that haven't been used in a while, their contents are probably not coming back
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        u64 numUnusedFrames = frame_ - it->second.lastUsedFrame - 1;
+        if (numUnusedFrames > maxUnusedFrames_) {
+            availableSetStacks_[it->second.layout].push(it->second.set);
+            it = entries_.erase(it);
+        } else {
+            ++it;
         }
     }
 }
 
 size_t DescriptorSetCache::countTotalCached() {
-    return countNumUsed() + countNumAvailable();
+    size_t numTransient = 0;
+    for (const auto &stacks : transientSetStacks_) {
+        numTransient += stacks.second.size();
+    }
+    return entries_.size() + numTransient + countNumAvailable();
 }
 
 size_t DescriptorSetCache::countNumUsed() {
-    size_t numUsed = 0;
-    for (const auto &stacks : usedSetStacks_) {
-        numUsed += stacks.second.size();
-    }
-    return numUsed;
+    return numUsed_;
 }
 
 size_t DescriptorSetCache::countNumAvailable() {
@@ -55,4 +98,3 @@ size_t DescriptorSetCache::countNumAvailable() {
 }
 
 }
-
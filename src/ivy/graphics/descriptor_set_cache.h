@@ -1,38 +1,64 @@
 #ifndef IVY_DESCRIPTOR_SET_CACHE_H
 #define IVY_DESCRIPTOR_SET_CACHE_H
 
+#include "ivy/types.h"
 #include <vulkan/vulkan.h>
 #include <unordered_map>
 #include <stack>
+#include <vector>
 
 namespace ivy::gfx {
 
 class RenderDevice;
 
 /**
- * \brief A cache for allocated descriptor sets
+ * \brief A cache for allocated descriptor sets. Sets are found by what was written to them, so a set that is bound with
+ * the same contents every frame is only written once.
  */
 class DescriptorSetCache {
 public:
+    // Everything that was written to a descriptor set, starting with its layout
+    using Contents_t = std::vector<u64>;
 
     /**
-     * \brief Find an available descriptor set with a given layout in the cache
+     * \param max_unused_frames Sets that weren't used for more than this many frames are evicted so they can be
+     * rewritten with other contents
+     */
+    explicit DescriptorSetCache(u32 max_unused_frames);
+
+    /**
+     * \brief Find a descriptor set with given contents in the cache and mark it as used this frame
+     * \param contents The contents the descriptor set should have
+     * \return The descriptor set if found, otherwise VK_NULL_HANDLE
+     */
+    VkDescriptorSet findSetWithContents(const Contents_t &contents);
+
+    /**
+     * \brief Find a descriptor set with a given layout that isn't in use and can be rewritten
      * \param layout The layout the descriptor set should have
      * \return The descriptor set if found, otherwise VK_NULL_HANDLE
      */
     VkDescriptorSet findSetWithLayout(VkDescriptorSetLayout layout);
 
     /**
-     * \brief Add a descriptor set of a given layout to the cache
+     * \brief Add a descriptor set to the cache so it can be found by its contents, it's marked as used this frame
      * \param layout The layout of the descriptor set
+     * \param contents What was written to the descriptor set
      * \param set The descriptor set
      */
-    void addToCache(VkDescriptorSetLayout layout, VkDescriptorSet set);
+    void addToCache(VkDescriptorSetLayout layout, Contents_t contents, VkDescriptorSet set);
 
     /**
-     * \brief Mark all descriptor sets in the cache as available
+     * \brief Add a descriptor set whose contents are only good for this frame, it can be rewritten next frame
+     * \param layout The layout of the descriptor set
+     * \param set The descriptor set
+     */
+    void addTransient(VkDescriptorSetLayout layout, VkDescriptorSet set);
+
+    /**
+     * \brief Start a new frame. Transient sets and sets that went unused for too long become available.
      */
-    void markAllAsAvailable();
+    void nextFrame();
 
     /**
      * \brief Count and return how many descriptor sets are cached
@@ -47,14 +73,29 @@ public:
     size_t countNumAvailable();
 
     /**
-     * \brief Count and return how many descriptor sets were retrieved from the cache
+     * \brief Count and return how many descriptor sets were retrieved from the cache this frame
      * \return Total used
      */
     size_t countNumUsed();
 
 private:
+    struct ContentsHash {
+        size_t operator()(const Contents_t &contents) const;
+    };
+
+    struct Entry {
+        VkDescriptorSetLayout layout;
+        VkDescriptorSet set;
+        u64 lastUsedFrame;
+    };
+
+    u32 maxUnusedFrames_;
+    u64 frame_ = 0;
+    size_t numUsed_ = 0;
+
+    std::unordered_map<Contents_t, Entry, ContentsHash> entries_;
     std::unordered_map<VkDescriptorSetLayout, std::stack<VkDescriptorSet>> availableSetStacks_;
-    std::unordered_map<VkDescriptorSetLayout, std::stack<VkDescriptorSet>> usedSetStacks_;
+    std::unordered_map<VkDescriptorSetLayout, std::stack<VkDescriptorSet>> transientSetStacks_;
 };
 
 }
@@ -5,7 +5,13 @@ namespace ivy::gfx {
 void Geometry::draw(CommandBuffer &cmd) const {
     cmd.bindVertexBuffer(vertexBuffer_);
     cmd.bindIndexBuffer(indexBuffer_);
-    cmd.drawIndexed(numIndices_, 1, 0, 0, 0);
+    cmd.drawIndexed(numIndices_, 1, firstIndex_, vertexOffset_, 0);
+}
+
+void Geometry::setIndices(RenderDevice &device, Span<const u32> indices) {
+    BufferRange indexRange = device.createIndexBuffer(indices.data(), sizeof(u32) * indices.size());
+    indexBuffer_ = indexRange.buffer;
+    firstIndex_ = (u32) (indexRange.offset / sizeof(u32));
 }
 
 }
@@ -4,6 +4,7 @@
 #include "ivy/types.h"
 #include "ivy/graphics/command_buffer.h"
 #include "ivy/graphics/render_device.h"
+#include "ivy/utils/span.h"
 #include <vulkan/vulkan.h>
 
 namespace ivy::gfx {
@@ -14,19 +15,33 @@ namespace ivy::gfx {
 class Geometry {
 public:
     template<typename T> Geometry(RenderDevice &device, const std::vector<T> &vertices, const std::vector<u32> &indices)
+        : Geometry(device, Span<const T>(vertices.data(), vertices.size()),
+                   Span<const u32>(indices.data(), indices.size())) {}
+
+    template<typename T> Geometry(RenderDevice &device, Span<const T> vertices, Span<const u32> indices)
         : numVertices_(vertices.size()), numIndices_(indices.size()) {
-        // Create vertex and index buffers
-        vertexBuffer_ = device.createVertexBuffer(vertices.data(), sizeof(vertices[0]) * numVertices_);
-        indexBuffer_ = device.createIndexBuffer(indices.data(), sizeof(indices[0]) * numIndices_);
+        // Pack vertices and indices into the device's shared buffers
+        BufferRange vertexRange = device.createVertexBuffer(vertices.data(), sizeof(T) * numVertices_, sizeof(T));
+        vertexBuffer_ = vertexRange.buffer;
+        vertexOffset_ = (u32) (vertexRange.offset / sizeof(T));
+
+        setIndices(device, indices);
     }
 
     // Create geometry and reuse already existing vertex buffer from another geometry, useful for LODs
-    Geometry(RenderDevice &device, const Geometry &vertex_src, const std::vector<u32> &indices)
-        : numVertices_(vertex_src.numVertices_), numIndices_(indices.size()), vertexBuffer_(vertex_src.vertexBuffer_) {
-        // Create index buffer
-        indexBuffer_ = device.createIndexBuffer(indices.data(), sizeof(indices[0]) * numIndices_);
+    Geometry(RenderDevice &device, const Geometry &vertex_src, Span<const u32> indices)
+        : numVertices_(vertex_src.numVertices_), numIndices_(indices.size()), vertexBuffer_(vertex_src.vertexBuffer_),
+          vertexOffset_(vertex_src.vertexOffset_) {
+        setIndices(device, indices);
     }
 
+    Geometry(RenderDevice &device, const Geometry &vertex_src, const std::vector<u32> &indices)
+        : Geometry(device, vertex_src, Span<const u32>(indices.data(), indices.size())) {}
+
+    /**
+     * \brief Draw the geometry, the buffers are only bound if the previous draw used different ones
+     * \param cmd The command buffer to record into
+     */
     void draw(CommandBuffer &cmd) const;
 
     [[nodiscard]] u32 getNumVertices() const {
@@ -37,12 +52,40 @@ public:
         return numIndices_;
     }
 
+    [[nodiscard]] VkBuffer getVertexBuffer() const {
+        return vertexBuffer_;
+    }
+
+    [[nodiscard]] VkBuffer getIndexBuffer() const {
+        return indexBuffer_;
+    }
+
+    /**
+     * \brief Get the index of the first vertex in the vertex buffer, the value indices are offset by
+     * \return Vertex offset
+     */
+    [[nodiscard]] u32 getVertexOffset() const {
+        return vertexOffset_;
+    }
+
+    /**
+     * \brief Get the position of the first index in the index buffer
+     * \return First index
+     */
+    [[nodiscard]] u32 getFirstIndex() const {
+        return firstIndex_;
+    }
+
 private:
+    void setIndices(RenderDevice &device, Span<const u32> indices);
+
     u32 numVertices_;
     u32 numIndices_;
 
     VkBuffer vertexBuffer_;
     VkBuffer indexBuffer_;
+    u32 vertexOffset_ = 0;
+    u32 firstIndex_ = 0;
 };
 
 }
@@ -273,7 +273,7 @@ GraphicsPass GraphicsPassBuilder::build() {
         }
 
         // Create layout
-        SubpassLayout layout = device_.createLayout(subpassInfo.descriptors_);
+        SubpassLayout layout = device_.createLayout(subpassInfo.descriptors_, subpassInfo.pushConstantRanges_);
 
         // Create pipeline
         subpasses.emplace_back(
@@ -424,11 +424,27 @@ SubpassBuilder &SubpassBuilder::addUniformBufferDescriptor(u32 set, u32 binding,
     return *this;
 }
 
+SubpassBuilder &SubpassBuilder::addDynamicUniformBufferDescriptor(u32 set, u32 binding,
+                                                                  VkShaderStageFlags stage_flags) {
+    addDescriptor(set, binding, stage_flags, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+    return *this;
+}
+
 SubpassBuilder &SubpassBuilder::addTextureDescriptor(u32 set, u32 binding, VkShaderStageFlags stage_flags) {
     addDescriptor(set, binding, stage_flags, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
     return *this;
 }
 
+SubpassBuilder &SubpassBuilder::addPushConstantRange(VkShaderStageFlags stage_flags, u32 offset, u32 size) {
+    VkPushConstantRange range = {};
+    range.stageFlags = stage_flags;
+    range.offset = offset;
+    range.size = size;
+
+    subpass_.pushConstantRanges_.emplace_back(range);
+    return *this;
+}
+
 SubpassBuilder &SubpassBuilder::addColorAttachment(const std::string &attachment_name, u32 location) {
     std::vector<std::string> &names = subpass_.colorAttachmentNames_;
 
@@ -17,8 +17,6 @@ namespace ivy::gfx {
 class RenderDevice;
 class Texture;
 
-// TODO: push constants
-
 /**
  * \brief Describes the state of a graphics pipeline for a subpass
  */
@@ -46,6 +44,7 @@ using LayoutBindingsMap_t = std::map<u32, std::map<u32, VkDescriptorSetLayoutBin
 struct SubpassLayout {
     VkPipelineLayout pipelineLayout;
     std::vector<VkDescriptorSetLayout> setLayouts;
+    std::vector<VkPushConstantRange> pushConstantRanges;
 };
 
 /**
@@ -77,10 +76,18 @@ public:
      * \param set_index Which set's layout should be gotten
      * \return VkDescriptorSetLayout
      */
-    [[nodiscard]] VkDescriptorSetLayout getSetLayout(u32 set_index) {
+    [[nodiscard]] VkDescriptorSetLayout getSetLayout(u32 set_index) const {
         return layout_.setLayouts.at(set_index);
     }
 
+    /**
+     * \brief Get the push constant ranges of the pipeline layout
+     * \return Vector of VkPushConstantRange
+     */
+    [[nodiscard]] const std::vector<VkPushConstantRange> &getPushConstantRanges() const {
+        return layout_.pushConstantRanges;
+    }
+
     /**
      * \brief Get the name of the subpass
      * \return Subpass name
@@ -138,7 +145,7 @@ public:
      * \param subpass_index The index of the subpass to get
      * \return Subpass
      */
-    [[nodiscard]] Subpass getSubpass(u32 subpass_index) const {
+    [[nodiscard]] const Subpass &getSubpass(u32 subpass_index) const {
         return subpasses_.at(subpass_index);
     }
 
@@ -209,6 +216,7 @@ private:
     std::optional<std::string> depthAttachmentName_;
 
     LayoutBindingsMap_t descriptors_;
+    std::vector<VkPushConstantRange> pushConstantRanges_;
     GraphicsPipelineState pipelineState_;
 };
 
@@ -254,6 +262,16 @@ public:
      */
     SubpassBuilder &addUniformBufferDescriptor(u32 set, u32 binding, VkShaderStageFlags stage_flags);
 
+    /**
+     * \brief Add a dynamic uniform buffer to the subpass. Its data can change every draw without having to write to
+     * the descriptor set, only the offset that is bound changes.
+     * \param set Which descriptor set the descriptor should belong to
+     * \param binding Which binding in the descriptor set the descriptor should belong to
+     * \param stage_flags Which shader stage the descriptor set belongs to
+     * \return SubpassBuilder
+     */
+    SubpassBuilder &addDynamicUniformBufferDescriptor(u32 set, u32 binding, VkShaderStageFlags stage_flags);
+
     /**
      * \brief Add a texture to sample to the subpass
      * \param set Which descriptor set the descriptor should belong to
@@ -263,6 +281,15 @@ public:
      */
     SubpassBuilder &addTextureDescriptor(u32 set, u32 binding, VkShaderStageFlags stage_flags);
 
+    /**
+     * \brief Add a push constant range to the subpass, small data that is pushed straight into the command buffer
+     * \param stage_flags Which shader stages can access the range
+     * \param offset Offset of the range in bytes, a multiple of 4
+     * \param size Size of the range in bytes, a multiple of 4
+     * \return SubpassBuilder
+     */
+    SubpassBuilder &addPushConstantRange(VkShaderStageFlags stage_flags, u32 offset, u32 size);
+
     /**
      * \brief Add a color attachment to the subpass
      * \param attachment_name Name of the attachment to reference
@@ -0,0 +1,56 @@
+#include "lod_policy.h"
+#include "ivy/resources/resource_manager.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ivy::gfx {
+
+LodPolicy::LodPolicy(f32 full_detail_size, f32 hysteresis)
+    : fullDetailSize_(full_detail_size), hysteresis_(hysteresis) {}
+
+f32 LodPolicy::calculateLod(f32 projected_size) const {
+    if (projected_size >= fullDetailSize_) {
+        return 0.0f;
+    }
+
+    // Triangles scale with the projected area, so halving the area is one LOD level
+    f32 size = std::max(projected_size, std::numeric_limits<f32>::min());
+    return 2.0f * std::log2(fullDetailSize_ / size);
+}
+
+u32 LodPolicy::selectLod(f32 projected_size) const {
+    f32 lod = calculateLod(projected_size);
+    return (u32) std::min(lod, (f32) ResourceManager::MAX_LOD);
+}
+
+u32 LodPolicy::selectLod(f32 projected_size, u32 current_lod) const {
+    f32 lod = calculateLod(projected_size);
+    current_lod = std::min(current_lod, ResourceManager::MAX_LOD);
+
+    // Current LOD covers [current_lod, current_lod + 1), widen that range by the hysteresis before leaving it
+    if (lod >= (f32) current_lod - hysteresis_ && lod < (f32) current_lod + 1.0f + hysteresis_) {
+        return current_lod;
+    }
+
+    return selectLod(projected_size);
+}
+
+f32 LodPolicy::projectedSizePerspective(const Sphere &sphere, const glm::vec3 &eye, f32 projection_scale_y,
+                                        f32 viewport_height) {
+    f32 distance = glm::length(sphere.center - eye);
+    if (distance <= sphere.radius) {
+        return std::numeric_limits<f32>::infinity();
+    }
+
+    return sphere.radius * projection_scale_y * viewport_height / distance;
+}
+
+f32 LodPolicy::projectedSizeOrthographic(const Sphere &sphere, const glm::mat4 &view_projection,
+                                         f32 viewport_width) {
+    // The first row of the upper 3x3 maps world units to the clip space x range of 2
+    glm::vec3 row = glm::vec3(view_projection[0][0], view_projection[1][0], view_projection[2][0]);
+    return sphere.radius * glm::length(row) * viewport_width;
+}
+
+}
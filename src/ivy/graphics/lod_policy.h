@@ -0,0 +1,74 @@
+#ifndef IVY_LOD_POLICY_H
+#define IVY_LOD_POLICY_H
+
+#include "ivy/types.h"
+#include "ivy/math/bounds.h"
+#include <glm/glm.hpp>
+
+namespace ivy::gfx {
+
+/**
+ * \brief Picks a LOD level from how large a model appears in a view. Each LOD has about half the triangles of the
+ * previous one, so a LOD is used when the model covers about half the area that the previous LOD was made for.
+ */
+class LodPolicy {
+public:
+    /**
+     * \param full_detail_size The projected diameter in pixels or texels at and above which LOD 0 is used
+     * \param hysteresis How far past a LOD boundary, in LOD levels, the projected size has to move before a model
+     * changes LOD
+     */
+    explicit LodPolicy(f32 full_detail_size, f32 hysteresis = 0.25f);
+
+    /**
+     * \brief Get the LOD level for a projected size as a continuous value
+     * \param projected_size The projected diameter in pixels or texels
+     * \return LOD level, 0 when the model is large enough for full detail, not clamped to the max LOD
+     */
+    [[nodiscard]] f32 calculateLod(f32 projected_size) const;
+
+    /**
+     * \brief Select a LOD level without hysteresis, for views that don't keep LOD state between frames
+     * \param projected_size The projected diameter in pixels or texels
+     * \return LOD level
+     */
+    [[nodiscard]] u32 selectLod(f32 projected_size) const;
+
+    /**
+     * \brief Select a LOD level, only changing from the current LOD once the projected size has moved far enough
+     * past the boundary between them so that a model at the boundary doesn't change every frame
+     * \param projected_size The projected diameter in pixels or texels
+     * \param current_lod The LOD level the model was drawn with last frame
+     * \return LOD level
+     */
+    [[nodiscard]] u32 selectLod(f32 projected_size, u32 current_lod) const;
+
+    /**
+     * \brief Get the projected diameter of a sphere in a perspective view
+     * \param sphere The sphere in world space
+     * \param eye The position of the view in world space
+     * \param projection_scale_y The y scale of the projection matrix, projection[1][1]
+     * \param viewport_height The height of the viewport in pixels
+     * \return The projected diameter in pixels, infinite if the eye is inside the sphere
+     */
+    [[nodiscard]] static f32 projectedSizePerspective(const Sphere &sphere, const glm::vec3 &eye,
+                                                      f32 projection_scale_y, f32 viewport_height);
+
+    /**
+     * \brief Get the projected diameter of a sphere in an orthographic view
+     * \param sphere The sphere in world space
+     * \param view_projection The orthographic view projection matrix
+     * \param viewport_width The width of the viewport in pixels or texels
+     * \return The projected diameter in pixels or texels
+     */
+    [[nodiscard]] static f32 projectedSizeOrthographic(const Sphere &sphere, const glm::mat4 &view_projection,
+                                                       f32 viewport_width);
+
+private:
+    f32 fullDetailSize_;
+    f32 hysteresis_;
+};
+
+}
+
+#endif // IVY_LOD_POLICY_H
@@ -3,6 +3,7 @@
 
 #include "ivy/graphics/geometry.h"
 #include "ivy/graphics/material.h"
+#include "ivy/math/bounds.h"
 
 namespace ivy::gfx {
 
@@ -11,8 +12,8 @@ namespace ivy::gfx {
  */
 class Mesh {
 public:
-    Mesh(const Geometry &geometry, const Material &material)
-        : geometry_(geometry), material_(material) {}
+    Mesh(const Geometry &geometry, const Material &material, const AABB &bounds, const Sphere &bounding_sphere)
+        : geometry_(geometry), material_(material), bounds_(bounds), boundingSphere_(bounding_sphere) {}
 
     [[nodiscard]] const Geometry &getGeometry() const {
         return geometry_;
@@ -22,9 +23,27 @@ public:
         return material_;
     }
 
+    /**
+     * \brief Get the bounding box of the mesh in model space
+     * \return Bounding box
+     */
+    [[nodiscard]] const AABB &getBounds() const {
+        return bounds_;
+    }
+
+    /**
+     * \brief Get the bounding sphere of the mesh in model space
+     * \return Bounding sphere
+     */
+    [[nodiscard]] const Sphere &getBoundingSphere() const {
+        return boundingSphere_;
+    }
+
 private:
     Geometry geometry_;
     Material material_;
+    AABB bounds_;
+    Sphere boundingSphere_;
 
     // TODO: share same material across geometries?
 };
@@ -0,0 +1,328 @@
+#include "mipmap.h"
+#include "ivy/log.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define IVY_MIPMAP_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define IVY_MIPMAP_SSE
+#endif
+
+namespace ivy::gfx {
+
+/**
+ * \brief Get the number of 8 bit channels of a format
+ * \param format The format
+ * \return Number of channels, or 0 if the format doesn't have 8 bits per channel
+ */
+static u32 get_num_8bit_channels(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SRGB:
+            return 1;
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SRGB:
+            return 2;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * \brief Get the size of a 4x4 block of a block compressed format
+ * \param format The format
+ * \return Size in bytes, or 0 if the format isn't block compressed
+ */
+static u32 get_compressed_block_size(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+            return 8;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+u32 get_mip_level_count(u32 width, u32 height) {
+    u32 levels = 1;
+    for (u32 size = std::max(width, height); size > 1; size >>= 1) {
+        ++levels;
+    }
+
+    return levels;
+}
+
+VkDeviceSize get_image_layer_size(VkFormat format, u32 width, u32 height) {
+    // Block compressed levels are made of whole blocks, even when they're smaller than a block
+    u32 blockSize = get_compressed_block_size(format);
+    if (blockSize != 0) {
+        return (VkDeviceSize) ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+    }
+
+    u32 channels = get_num_8bit_channels(format);
+    if (channels == 0) {
+        Log::fatal("Unsupported image format: %", format);
+    }
+
+    return (VkDeviceSize) width * height * channels;
+}
+
+VkDeviceSize get_mip_chain_layout(VkFormat format, u32 width, u32 height, u32 layers, u32 mip_levels,
+                                  std::vector<VkDeviceSize> *out_offsets) {
+    if (out_offsets) {
+        out_offsets->clear();
+    }
+
+    VkDeviceSize size = 0;
+    for (u32 level = 0; level < mip_levels; ++level) {
+        size = (size + MIP_LEVEL_ALIGNMENT - 1) & ~(MIP_LEVEL_ALIGNMENT - 1);
+        if (out_offsets) {
+            out_offsets->push_back(size);
+        }
+
+        size += get_image_layer_size(format, std::max(width >> level, 1u), std::max(height >> level, 1u)) * layers;
+    }
+
+    return size;
+}
+
+/**
+ * \brief Downsample the texels of one row of a level, starting at a column
+ * \param row0 The first source row
+ * \param row1 The second source row, the same as row0 if the source has an odd height and this is the last row
+ * \param src_width The width of the source level
+ * \param dst The destination row
+ * \param dst_width The width of the destination level
+ * \param channels The number of channels
+ * \param begin The column to start at
+ */
+static void downsample_row_scalar(const u8 *row0, const u8 *row1, u32 src_width, u8 *dst, u32 dst_width,
+                                  u32 channels, u32 begin) {
+    // Edges of odd sized levels are clamped, so each destination texel always averages 4 source texels
+    for (u32 x = begin; x < dst_width; ++x) {
+        u32 x0 = std::min(x * 2, src_width - 1) * channels;
+        u32 x1 = std::min(x * 2 + 1, src_width - 1) * channels;
+
+        for (u32 c = 0; c < channels; ++c) {
+            u32 sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+            dst[x * channels + c] = (u8) ((sum + 2) / 4);
+        }
+    }
+}
+
+#if defined(IVY_MIPMAP_AVX2) || defined(IVY_MIPMAP_SSE)
+
+#if defined(IVY_MIPMAP_AVX2)
+
+using simd_t = __m256i;
+
+static simd_t load(const u8 *src) {
+    return _mm256_loadu_si256(reinterpret_cast<const simd_t *>(src));
+}
+
+static void store(u8 *dst, simd_t x) {
+    _mm256_storeu_si256(reinterpret_cast<simd_t *>(dst), x);
+}
+
+static simd_t zero() {
+    return _mm256_setzero_si256();
+}
+
+static simd_t set1_16(i16 x) {
+    return _mm256_set1_epi16(x);
+}
+
+static simd_t add_16(simd_t a, simd_t b) {
+    return _mm256_add_epi16(a, b);
+}
+
+static simd_t and_bits(simd_t a, simd_t b) {
+    return _mm256_and_si256(a, b);
+}
+
+static simd_t shift_right_16(simd_t x, i32 bits) {
+    return _mm256_srli_epi16(x, bits);
+}
+
+static simd_t unpack_lo_8(simd_t a, simd_t b) {
+    return _mm256_unpacklo_epi8(a, b);
+}
+
+static simd_t unpack_hi_8(simd_t a, simd_t b) {
+    return _mm256_unpackhi_epi8(a, b);
+}
+
+static simd_t even_odd_32(simd_t x) {
+    return _mm256_shuffle_epi32(x, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+static simd_t pack_16(simd_t a, simd_t b) {
+    // Packing works within each 128 bit lane, put the halves back in order
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+#else
+
+using simd_t = __m128i;
+
+static simd_t load(const u8 *src) {
+    return _mm_loadu_si128(reinterpret_cast<const simd_t *>(src));
+}
+
+static void store(u8 *dst, simd_t x) {
+    _mm_storeu_si128(reinterpret_cast<simd_t *>(dst), x);
+}
+
+static simd_t zero() {
+    return _mm_setzero_si128();
+}
+
+static simd_t set1_16(i16 x) {
+    return _mm_set1_epi16(x);
+}
+
+static simd_t add_16(simd_t a, simd_t b) {
+    return _mm_add_epi16(a, b);
+}
+
+static simd_t and_bits(simd_t a, simd_t b) {
+    return _mm_and_si128(a, b);
+}
+
+static simd_t shift_right_16(simd_t x, i32 bits) {
+    return _mm_srli_epi16(x, bits);
+}
+
+static simd_t unpack_lo_8(simd_t a, simd_t b) {
+    return _mm_unpacklo_epi8(a, b);
+}
+
+static simd_t unpack_hi_8(simd_t a, simd_t b) {
+    return _mm_unpackhi_epi8(a, b);
+}
+
+static simd_t even_odd_32(simd_t x) {
+    return _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+static simd_t pack_16(simd_t a, simd_t b) {
+    return _mm_packus_epi16(a, b);
+}
+
+#endif
+
+constexpr u32 VECTOR_BYTES = sizeof(simd_t);
+
+/**
+ * \brief Sum each pair of neighbouring texels of a vector of single channel texels
+ * \return The sums as 16 bit integers, in order
+ */
+static simd_t pair_sums_1(simd_t x) {
+    simd_t even = and_bits(x, set1_16(0xff));
+    simd_t odd = shift_right_16(x, 8);
+    return add_16(even, odd);
+}
+
+/**
+ * \brief Sum each pair of neighbouring texels of a vector of four channel texels
+ * \return The sums as 16 bit integers, in order
+ */
+static simd_t pair_sums_4(simd_t x) {
+    // Even texels go in the low half of each 128 bit lane and odd ones in the high half
+    simd_t shuffled = even_odd_32(x);
+    return add_16(unpack_lo_8(shuffled, zero()), unpack_hi_8(shuffled, zero()));
+}
+
+/**
+ * \brief Downsample as many texels of a row as possible with SIMD, see downsample_row_scalar
+ * \return The number of destination texels that were written
+ */
+static u32 downsample_row_simd(const u8 *row0, const u8 *row1, u32 src_width, u8 *dst, u32 dst_width,
+                               u32 channels) {
+    if (channels != 1 && channels != 4) {
+        return 0;
+    }
+
+    // Each iteration reads two vectors from each source row and writes one vector, the last texel of an odd sized
+    // row is clamped so it's left to the scalar code
+    u32 texelsPerVector = VECTOR_BYTES / channels;
+    u32 numTexels = std::min(dst_width, src_width / 2) / texelsPerVector * texelsPerVector;
+    simd_t rounding = set1_16(2);
+
+    for (u32 x = 0; x < numTexels; x += texelsPerVector) {
+        const u8 *src0 = row0 + x * 2 * channels;
+        const u8 *src1 = row1 + x * 2 * channels;
+
+        simd_t sumA, sumB;
+        if (channels == 1) {
+            sumA = add_16(pair_sums_1(load(src0)), pair_sums_1(load(src1)));
+            sumB = add_16(pair_sums_1(load(src0 + VECTOR_BYTES)), pair_sums_1(load(src1 + VECTOR_BYTES)));
+        } else {
+            sumA = add_16(pair_sums_4(load(src0)), pair_sums_4(load(src1)));
+            sumB = add_16(pair_sums_4(load(src0 + VECTOR_BYTES)), pair_sums_4(load(src1 + VECTOR_BYTES)));
+        }
+
+        sumA = shift_right_16(add_16(sumA, rounding), 2);
+        sumB = shift_right_16(add_16(sumB, rounding), 2);
+        store(dst + x * channels, pack_16(sumA, sumB));
+    }
+
+    return numTexels;
+}
+
+#else
+
+static u32 downsample_row_simd(const u8 *, const u8 *, u32, u8 *, u32, u32) {
+    return 0;
+}
+
+#endif
+
+void generate_mip_chain(VkFormat format, u32 width, u32 height, const u8 *pixels, std::vector<u8> &out_data) {
+    u32 channels = get_num_8bit_channels(format);
+    if (channels == 0) {
+        Log::fatal("Can't generate mips for image format: %", format);
+    }
+
+    u32 mipLevels = get_mip_level_count(width, height);
+    std::vector<VkDeviceSize> offsets;
+    out_data.assign(get_mip_chain_layout(format, width, height, 1, mipLevels, &offsets), 0);
+    std::memcpy(out_data.data(), pixels, get_image_layer_size(format, width, height));
+
+    for (u32 level = 1; level < mipLevels; ++level) {
+        const u8 *src = out_data.data() + offsets[level - 1];
+        u8 *dst = out_data.data() + offsets[level];
+        u32 srcWidth = std::max(width >> (level - 1), 1u);
+        u32 srcHeight = std::max(height >> (level - 1), 1u);
+        u32 dstWidth = std::max(width >> level, 1u);
+        u32 dstHeight = std::max(height >> level, 1u);
+
+        for (u32 y = 0; y < dstHeight; ++y) {
+            const u8 *row0 = src + (std::min(y * 2, srcHeight - 1) * srcWidth) * channels;
+            const u8 *row1 = src + (std::min(y * 2 + 1, srcHeight - 1) * srcWidth) * channels;
+            u8 *dstRow = dst + y * dstWidth * channels;
+
+            u32 done = downsample_row_simd(row0, row1, srcWidth, dstRow, dstWidth, channels);
+            downsample_row_scalar(row0, row1, srcWidth, dstRow, dstWidth, channels, done);
+        }
+    }
+}
+
+}
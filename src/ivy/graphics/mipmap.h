@@ -0,0 +1,60 @@
+#ifndef IVY_MIPMAP_H
+#define IVY_MIPMAP_H
+
+#include "ivy/types.h"
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace ivy::gfx {
+
+/**
+ * \brief Every level of a mip chain starts at a multiple of this many bytes, offsets of buffer to image copies have to
+ * be multiples of 4. Levels of block compressed formats are whole blocks, so they stay aligned to the block size.
+ */
+constexpr VkDeviceSize MIP_LEVEL_ALIGNMENT = 4;
+
+/**
+ * \brief Get the number of levels in a full mip chain, the last level is 1x1
+ * \param width The width of the largest level
+ * \param height The height of the largest level
+ * \return Number of mip levels
+ */
+u32 get_mip_level_count(u32 width, u32 height);
+
+/**
+ * \brief Get the size of a single layer of an image in bytes
+ * \param format The image format, either 8 bits per channel or block compressed. Fatal error if it isn't supported
+ * \param width The width of the image
+ * \param height The height of the image
+ * \return Size in bytes
+ */
+VkDeviceSize get_image_layer_size(VkFormat format, u32 width, u32 height);
+
+/**
+ * \brief Get where each level is in data that holds a mip chain. The levels are stored from largest to smallest, each
+ * one starts at a multiple of MIP_LEVEL_ALIGNMENT and holds all array layers.
+ * \param format The image format
+ * \param width The width of the largest level
+ * \param height The height of the largest level
+ * \param layers The number of array layers
+ * \param mip_levels The number of mip levels
+ * \param out_offsets If not null, the offset of each level is written here
+ * \return The size of the whole mip chain in bytes
+ */
+VkDeviceSize get_mip_chain_layout(VkFormat format, u32 width, u32 height, u32 layers, u32 mip_levels,
+                                  std::vector<VkDeviceSize> *out_offsets = nullptr);
+
+/**
+ * \brief Generate a full mip chain for a 2D image by averaging each 2x2 block of texels of the previous level. Uses AVX2
+ * or SSE when available for single and four channel formats, otherwise scalar code.
+ * \param format The image format, must have 8 bits per channel
+ * \param width The width of the image
+ * \param height The height of the image
+ * \param pixels The image
+ * \param out_data The mip chain is written here, laid out as described by get_mip_chain_layout
+ */
+void generate_mip_chain(VkFormat format, u32 width, u32 height, const u8 *pixels, std::vector<u8> &out_data);
+
+}
+
+#endif // IVY_MIPMAP_H
@@ -1,18 +1,41 @@
 #include "render_device.h"
 #include "vk_utils.h"
 #include "ivy/consts.h"
+#include "ivy/graphics/mipmap.h"
 #include "ivy/platform/platform.h"
 
 #define VMA_IMPLEMENTATION
 #include <vk_mem_alloc.h>
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <set>
 
 namespace ivy::gfx {
 
 constexpr u32 VULKAN_API_VERSION = VK_API_VERSION_1_1;
 
+// Uploads are staged in a ring of this size, larger ones get their own staging buffer
+constexpr VkDeviceSize STAGING_RING_SIZE = 64 * 1024 * 1024;
+
+// Static geometry is packed into shared vertex and index buffers of these sizes
+constexpr VkDeviceSize VERTEX_BUFFER_BLOCK_SIZE = 64 * 1024 * 1024;
+constexpr VkDeviceSize INDEX_BUFFER_BLOCK_SIZE = 32 * 1024 * 1024;
+
+/**
+ * \brief Let a buffer or image be used by both the graphics queue and the upload queue without transferring ownership
+ * \param create_info The create info of the buffer or image
+ * \param queue_family_indices The graphics and upload queue families
+ */
+template <typename T>
+static void share_with_upload_queue(T &create_info, const u32 (&queue_family_indices)[2]) {
+    if (queue_family_indices[0] != queue_family_indices[1]) {
+        create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        create_info.queueFamilyIndexCount = 2;
+        create_info.pQueueFamilyIndices = queue_family_indices;
+    }
+}
+
 RenderDevice::RenderDevice(const Options &options, const Platform &platform)
     : options_(options) {
     LOG_CHECKPOINT();
@@ -89,7 +112,8 @@ RenderDevice::RenderDevice(const Options &options, const Platform &platform)
     // Logical device creation
     //----------------------------------
 
-    std::set<u32> uniqueIndices = { graphicsFamilyIndex_, computeFamilyIndex_, presentFamilyIndex_ };
+    std::set<u32> uniqueIndices = { graphicsFamilyIndex_, computeFamilyIndex_, presentFamilyIndex_,
+                                    transferFamilyIndex_ };
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     f32 queuePriority = 1;
 
@@ -106,6 +130,8 @@ RenderDevice::RenderDevice(const Options &options, const Platform &platform)
     // Enable features
     VkPhysicalDeviceFeatures features;
     vkGetPhysicalDeviceFeatures(physicalDevice_, &features);
+    samplerAnisotropySupported_ = features.samplerAnisotropy == VK_TRUE;
+    blockCompressionSupported_ = features.textureCompressionBC == VK_TRUE;
     features.imageCubeArray = VK_TRUE;
     features.geometryShader = VK_TRUE;
 
@@ -131,6 +157,7 @@ RenderDevice::RenderDevice(const Options &options, const Platform &platform)
     vkGetDeviceQueue(device_, graphicsFamilyIndex_, 0, &graphicsQueue_);
     vkGetDeviceQueue(device_, computeFamilyIndex_, 0, &computeQueue_);
     vkGetDeviceQueue(device_, presentFamilyIndex_, 0, &presentQueue_);
+    vkGetDeviceQueue(device_, transferFamilyIndex_, 0, &transferQueue_);
 
     //----------------------------------
     // Vulkan Memory Allocator
@@ -147,6 +174,26 @@ RenderDevice::RenderDevice(const Options &options, const Platform &platform)
         vmaDestroyAllocator(allocator_);
     });
 
+    //----------------------------------
+    // Upload manager
+    //----------------------------------
+
+    uploadQueueFamilies_[0] = graphicsFamilyIndex_;
+    uploadQueueFamilies_[1] = transferFamilyIndex_;
+
+    uploadManager_ = std::make_unique<UploadManager>(device_, allocator_, transferQueue_, transferFamilyIndex_,
+                                                     STAGING_RING_SIZE);
+    cleanupStack_.emplace([ = ]() {
+        uploadManager_.reset();
+    });
+
+    vertexBuffers_ = std::make_unique<BufferSuballocator>(VERTEX_BUFFER_BLOCK_SIZE, [this](VkDeviceSize size) {
+        return createDeviceLocalBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    });
+    indexBuffers_ = std::make_unique<BufferSuballocator>(INDEX_BUFFER_BLOCK_SIZE, [this](VkDeviceSize size) {
+        return createDeviceLocalBuffer(size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    });
+
     //----------------------------------
     // Create our swapchain
     //----------------------------------
@@ -194,15 +241,18 @@ RenderDevice::RenderDevice(const Options &options, const Platform &platform)
 
     imageAvailableSemaphores_.resize(options_.numFramesInFlight);
     renderFinishedSemaphores_.resize(options_.numFramesInFlight);
+    uploadFinishedSemaphores_.resize(options_.numFramesInFlight);
     inFlightFences_.resize(options_.numFramesInFlight);
 
     for (u32 i = 0; i < options_.numFramesInFlight; ++i) {
         VK_CHECKF(vkCreateSemaphore(device_, &semaphoreCreateInfo, nullptr, &imageAvailableSemaphores_.at(i)));
         VK_CHECKF(vkCreateSemaphore(device_, &semaphoreCreateInfo, nullptr, &renderFinishedSemaphores_.at(i)));
+        VK_CHECKF(vkCreateSemaphore(device_, &semaphoreCreateInfo, nullptr, &uploadFinishedSemaphores_.at(i)));
         VK_CHECKF(vkCreateFence(device_, &fenceCreateInfo, nullptr, &inFlightFences_.at(i)));
 
         cleanupStack_.emplace([ = ]() {
             vkDestroyFence(device_, inFlightFences_.at(i), nullptr);
+            vkDestroySemaphore(device_, uploadFinishedSemaphores_.at(i), nullptr);
             vkDestroySemaphore(device_, renderFinishedSemaphores_.at(i), nullptr);
             vkDestroySemaphore(device_, imageAvailableSemaphores_.at(i), nullptr);
         });
@@ -221,6 +271,9 @@ RenderDevice::RenderDevice(const Options &options, const Platform &platform)
     poolSizes.emplace_back(VkDescriptorPoolSize{
         VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4096
     });
+    poolSizes.emplace_back(VkDescriptorPoolSize{
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1024
+    });
     poolSizes.emplace_back(VkDescriptorPoolSize{
         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1024
     });
@@ -248,7 +301,7 @@ RenderDevice::RenderDevice(const Options &options, const Platform &platform)
     }
 
     // Make descriptor set caches
-    descriptorSetCaches_.resize(numImages);
+    descriptorSetCaches_.resize(numImages, DescriptorSetCache(options_.descriptorSetEvictionFrames));
 
     //----------------------------------
     // Create uniform buffer
@@ -313,7 +366,7 @@ void RenderDevice::beginFrame() {
     // Reset per-frame descriptor data
     //----------------------------------
 
-    descriptorSetCaches_.at(swapImageIndex_).markAllAsAvailable();
+    descriptorSetCaches_.at(swapImageIndex_).nextFrame();
     uniformBufferOffsets_.at(swapImageIndex_) = 0;
 
     //----------------------------------
@@ -346,12 +399,20 @@ void RenderDevice::endFrame() {
     // Queue submission and sync
     //----------------------------------
 
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    // Resources that were uploaded since the last frame have to be done uploading before they're used, all of them
+    // are waited for at once
+    VkSemaphore waitSemaphores[] = {imageAvailableSemaphores_.at(currentFrame_),
+                                    uploadFinishedSemaphores_.at(currentFrame_)};
+    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
+    bool uploaded = uploadManager_->submit(uploadFinishedSemaphores_.at(currentFrame_));
+
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = &imageAvailableSemaphores_.at(currentFrame_);
+    submitInfo.waitSemaphoreCount = uploaded ? 2 : 1;
+    submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
 
     submitInfo.commandBufferCount = 1;
@@ -387,40 +448,6 @@ VkQueue RenderDevice::getGraphicsQueue() {
     return graphicsQueue_;
 }
 
-void RenderDevice::submitOneTimeCommands(VkQueue queue, const std::function<void(CommandBuffer)> &record_func) {
-    // TODO: create command pool for short-lived command buffers
-
-    // Create command buffer
-    VkCommandBufferAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = 1;
-    allocInfo.commandPool = commandPool_;
-
-    VkCommandBuffer commandBuffer;
-    VK_CHECKF(vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer));
-
-    VkCommandBufferBeginInfo beginInfo = {};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-    // Record commands to command buffer
-    record_func(CommandBuffer(commandBuffer));
-
-    // Submit command buffer to queue
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-    vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(queue);
-
-    vkFreeCommandBuffers(device_, commandPool_, 1, &commandBuffer);
-}
-
 VkRenderPass RenderDevice::createRenderPass(const std::vector<VkAttachmentDescription> &attachments,
                                             const std::vector<VkSubpassDescription> &subpasses,
                                             const std::vector<VkSubpassDependency> &dependencies) {
@@ -444,7 +471,8 @@ VkRenderPass RenderDevice::createRenderPass(const std::vector<VkAttachmentDescri
     return renderPass;
 }
 
-SubpassLayout RenderDevice::createLayout(const LayoutBindingsMap_t &layout_bindings) {
+SubpassLayout RenderDevice::createLayout(const LayoutBindingsMap_t &layout_bindings,
+                                        const std::vector<VkPushConstantRange> &push_constant_ranges) {
     // Create descriptor sets layouts
     std::vector<VkDescriptorSetLayout> setLayouts;
     for (const auto &setsPair : layout_bindings) {
@@ -468,6 +496,19 @@ SubpassLayout RenderDevice::createLayout(const LayoutBindingsMap_t &layout_bindi
         });
     }
 
+    // Make sure the push constant ranges are valid for this device
+    for (const VkPushConstantRange &range : push_constant_ranges) {
+        if (range.size == 0 || range.offset % 4 != 0 || range.size % 4 != 0) {
+            Log::fatal("Push constant range at offset % with size % must be a non-empty multiple of 4 bytes",
+                       range.offset, range.size);
+        }
+
+        if (range.offset + range.size > limits_.maxPushConstantsSize) {
+            Log::fatal("Push constant range at offset % with size % doesn't fit in the % bytes of push constants "
+                       "the device supports", range.offset, range.size, limits_.maxPushConstantsSize);
+        }
+    }
+
     // Create pipeline layout
     VkPipelineLayoutCreateInfo layoutCI = {};
     layoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -475,8 +516,8 @@ SubpassLayout RenderDevice::createLayout(const LayoutBindingsMap_t &layout_bindi
     layoutCI.flags = 0;
     layoutCI.setLayoutCount = (u32) setLayouts.size();
     layoutCI.pSetLayouts = setLayouts.data();
-    layoutCI.pushConstantRangeCount = 0;
-    layoutCI.pPushConstantRanges = nullptr;
+    layoutCI.pushConstantRangeCount = (u32) push_constant_ranges.size();
+    layoutCI.pPushConstantRanges = push_constant_ranges.data();
 
     VkPipelineLayout layout;
     VK_CHECKF(vkCreatePipelineLayout(device_, &layoutCI, nullptr, &layout));
@@ -484,7 +525,7 @@ SubpassLayout RenderDevice::createLayout(const LayoutBindingsMap_t &layout_bindi
         vkDestroyPipelineLayout(device_, layout, nullptr);
     });
 
-    return SubpassLayout{layout, setLayouts};
+    return SubpassLayout{layout, setLayouts, push_constant_ranges};
 }
 
 VkPipeline RenderDevice::createGraphicsPipeline(const std::vector<Shader> &shaders,
@@ -744,33 +785,38 @@ Framebuffer &RenderDevice::getFramebuffer(const GraphicsPass &pass) {
     return framebuffers_.at(renderPass)[swapImageIndex_ % numFramebuffers];
 }
 
-VkBuffer RenderDevice::createVertexBuffer(const void *data, VkDeviceSize size) {
-    if (size <= 0) {
-        Log::fatal("Invalid vertex buffer size: %", size);
+BufferRange RenderDevice::createVertexBuffer(const void *data, VkDeviceSize size, u32 stride) {
+    if (size <= 0 || stride == 0) {
+        Log::fatal("Invalid vertex buffer size: % with stride: %", size, stride);
     }
 
-    return createBufferGPU(data, size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    // Aligned to the stride so draws can address the vertices with a vertex offset
+    BufferRange range = vertexBuffers_->allocate(size, stride);
+    uploadManager_->uploadBuffer(range.buffer, data, size, range.offset);
+
+    return range;
 }
 
-VkBuffer RenderDevice::createIndexBuffer(const void *data, VkDeviceSize size) {
+BufferRange RenderDevice::createIndexBuffer(const void *data, VkDeviceSize size) {
     if (size <= 0) {
         Log::fatal("Invalid index buffer size: %", size);
     }
 
-    return createBufferGPU(data, size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    // Aligned to the index size so draws can address the indices with a first index
+    BufferRange range = indexBuffers_->allocate(size, sizeof(u32));
+    uploadManager_->uploadBuffer(range.buffer, data, size, range.offset);
+
+    return range;
 }
 
 std::pair<VkImage, VkImageView> RenderDevice::createTextureGPUFromData(VkImageCreateInfo image_ci,
                                                                        VkImageViewCreateInfo image_view_ci,
                                                                        const void *data, VkDeviceSize size) {
-    // Create staging buffer
-    std::pair<VkBuffer, VmaAllocation> stagingBuffer;
-    if (size > 0) {
-        stagingBuffer = createStagingBufferCPU(data, size);
-    }
-
     // Create image
     image_ci.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    if (size > 0) {
+        share_with_upload_queue(image_ci, uploadQueueFamilies_);
+    }
 
     VmaAllocationCreateInfo allocCI = {};
     allocCI.usage = VMA_MEMORY_USAGE_GPU_ONLY;
@@ -783,48 +829,32 @@ std::pair<VkImage, VkImageView> RenderDevice::createTextureGPUFromData(VkImageCr
     });
 
     if (size > 0) {
-        // Copy data into image
-        submitOneTimeCommands(graphicsQueue_, [ = ](CommandBuffer cmd) {
-            // Transition image for copying buffer into it
-            {
-                VkImageMemoryBarrier barrier = {};
-                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-                barrier.srcAccessMask = 0;
-                barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-                barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-                barrier.image = image;
-                barrier.subresourceRange = image_view_ci.subresourceRange;
-
-                cmd.pipelineBarrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                    0, 0, nullptr, 0, nullptr, 1, &barrier);
-            }
-
-            // Copy buffer into it
-            {
-                cmd.copyBufferToImage(stagingBuffer.first, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                      image_view_ci.subresourceRange.aspectMask, image_ci.extent.width,
-                                      image_ci.extent.height, image_ci.extent.depth, image_ci.arrayLayers);
-            }
+        // One copy for each mip level
+        std::vector<VkDeviceSize> offsets;
+        VkDeviceSize expectedSize = get_mip_chain_layout(image_ci.format, image_ci.extent.width,
+                                                         image_ci.extent.height, image_ci.arrayLayers,
+                                                         image_ci.mipLevels, &offsets);
+        if (size < expectedSize) {
+            Log::fatal("Texture data is % bytes but % bytes are needed for its mip levels", size, expectedSize);
+        }
 
-            // Transition image for reading in shaders
-            {
-                VkImageMemoryBarrier barrier = {};
-                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-                barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                barrier.image = image;
-                barrier.subresourceRange = image_view_ci.subresourceRange;
-
-                cmd.pipelineBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                                    0, 0, nullptr, 0, nullptr, 1, &barrier);
-            }
-        });
+        std::vector<VkBufferImageCopy> regions(image_ci.mipLevels);
+        for (u32 level = 0; level < image_ci.mipLevels; ++level) {
+            VkBufferImageCopy &region = regions[level];
+            region.bufferOffset = offsets[level];
+            region.imageSubresource.aspectMask = image_view_ci.subresourceRange.aspectMask;
+            region.imageSubresource.mipLevel = level;
+            region.imageSubresource.layerCount = image_ci.arrayLayers;
+            region.imageExtent = {
+                std::max(image_ci.extent.width >> level, 1u),
+                std::max(image_ci.extent.height >> level, 1u),
+                std::max(image_ci.extent.depth >> level, 1u)
+            };
+        }
 
-        // Destroy staging buffer, we're done using it
-        vmaDestroyBuffer(allocator_, stagingBuffer.first, stagingBuffer.second);
+        // The copy is batched with other uploads and done by the time the next frame is rendered
+        uploadManager_->uploadImage(image, image_view_ci.subresourceRange, data, size, (u32) regions.size(),
+                                    regions.data());
     }
 
     // Create image view
@@ -839,11 +869,11 @@ std::pair<VkImage, VkImageView> RenderDevice::createTextureGPUFromData(VkImageCr
     return { image, imageView };
 }
 
-// TODO: mipmapped textures
-
 VkSampler RenderDevice::createSampler(VkFilter mag_filter, VkFilter min_filter, VkSamplerAddressMode u_wrap,
-                                      VkSamplerAddressMode v_wrap, VkSamplerAddressMode w_wrap) {
-    // TODO: anisotropic filtering
+                                      VkSamplerAddressMode v_wrap, VkSamplerAddressMode w_wrap, f32 max_anisotropy,
+                                      f32 min_lod, f32 max_lod) {
+    // Anisotropic filtering is an optional feature
+    max_anisotropy = samplerAnisotropySupported_ ? std::min(max_anisotropy, limits_.maxSamplerAnisotropy) : 1.0f;
 
     VkSamplerCreateInfo samplerCI = {};
     samplerCI.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -852,15 +882,17 @@ VkSampler RenderDevice::createSampler(VkFilter mag_filter, VkFilter min_filter,
     samplerCI.addressModeU = u_wrap;
     samplerCI.addressModeV = v_wrap;
     samplerCI.addressModeW = w_wrap;
-    samplerCI.anisotropyEnable = VK_FALSE;
-    samplerCI.maxAnisotropy = 1.0f;
+    samplerCI.anisotropyEnable = max_anisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+    samplerCI.maxAnisotropy = std::max(max_anisotropy, 1.0f);
     samplerCI.compareEnable = VK_FALSE;
     samplerCI.compareOp = VK_COMPARE_OP_ALWAYS;
 
-    samplerCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    // Blend between mip levels when minifying with linear filtering
+    samplerCI.mipmapMode = min_filter == VK_FILTER_LINEAR ? VK_SAMPLER_MIPMAP_MODE_LINEAR :
+                           VK_SAMPLER_MIPMAP_MODE_NEAREST;
     samplerCI.mipLodBias = 0.0f;
-    samplerCI.minLod = 0.0f;
-    samplerCI.maxLod = 0.0f;
+    samplerCI.minLod = min_lod;
+    samplerCI.maxLod = max_lod;
     samplerCI.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
     samplerCI.unnormalizedCoordinates = VK_FALSE;
 
@@ -873,7 +905,8 @@ VkSampler RenderDevice::createSampler(VkFilter mag_filter, VkFilter min_filter,
     return sampler;
 }
 
-VkDescriptorSet RenderDevice::getVkDescriptorSet(const GraphicsPass &pass, const DescriptorSet &set) {
+VkDescriptorSet RenderDevice::getVkDescriptorSet(const GraphicsPass &pass, const DescriptorSet &set,
+                                                 std::vector<u32> &out_dynamic_offsets) {
     DescriptorSetCache &cache = descriptorSetCaches_.at(swapImageIndex_);
     u32 subpassIdx = set.getSubpassIndex();
     u32 setIdx = set.getSetIndex();
@@ -881,32 +914,25 @@ VkDescriptorSet RenderDevice::getVkDescriptorSet(const GraphicsPass &pass, const
     // Get the layout for this set in this subpass
     VkDescriptorSetLayout layout = pass.getSubpass(subpassIdx).getSetLayout(setIdx);
 
-    // See if the cache can give us an unused descriptor set with the same layout
-    VkDescriptorSet dstSet = cache.findSetWithLayout(layout);
-
-    if (!dstSet) {
-        // We didn't find a descriptor set with the right layout, we need to allocate a new one
-        VkDescriptorSetAllocateInfo allocInfo = {};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = pools_.at(swapImageIndex_);
-        allocInfo.descriptorSetCount = 1;
-        allocInfo.pSetLayouts = &layout;
-
-        Log::verbose("Allocating new descriptor set for frame %, subpass %, set %", swapImageIndex_, subpassIdx, setIdx);
-
-        // TODO: handle case where we can't allocate new descriptor set
-        VK_CHECKF(vkAllocateDescriptorSets(device_, &allocInfo, &dstSet));
-
-        // Add it to the cache so we can find it next time we need a descriptor set with this layout
-        cache.addToCache(layout, dstSet);
+    // Dynamic uniform buffer data goes into the uniform buffer and is found through the offsets it's bound with
+    out_dynamic_offsets.clear();
+    for (const UniformBufferDescriptorInfo &info : set.getDynamicUniformBufferInfos()) {
+        out_dynamic_offsets.emplace_back((u32) writeUniformBufferData(set, info));
     }
 
-    // We don't cache by data yet, so we always write to the descriptor set
-    // TODO: cache by descriptor set data to prevent unnecessary updates
-
+    // The writes are gathered first, along with the contents they describe for looking the set up in the cache. The
+    // destination set is filled in once we know the set has to be written.
     Framebuffer &framebuffer = getFramebuffer(pass);
     std::vector<VkWriteDescriptorSet> writes;
 
+    DescriptorSetCache::Contents_t contents;
+    contents.emplace_back((u64) layout);
+
+    auto addWrite = [&](const VkWriteDescriptorSet &write, u64 handle, u64 extra, u64 range) {
+        writes.emplace_back(write);
+        contents.insert(contents.end(), {write.dstBinding, (u64) write.descriptorType, handle, extra, range});
+    };
+
     //----------------------------------
     // Input attachments
     //----------------------------------
@@ -923,12 +949,11 @@ VkDescriptorSet RenderDevice::getVkDescriptorSet(const GraphicsPass &pass, const
 
         VkWriteDescriptorSet write = {};
         write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write.dstSet = dstSet;
         write.dstBinding = desc.binding;
         write.descriptorCount = 1;
         write.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
         write.pImageInfo = &imageInfos.back();
-        writes.emplace_back(write);
+        addWrite(write, (u64) imageInfo.imageView, 0, 0);
     }
 
     //----------------------------------
@@ -936,48 +961,42 @@ VkDescriptorSet RenderDevice::getVkDescriptorSet(const GraphicsPass &pass, const
     //----------------------------------
 
     std::vector<VkDescriptorBufferInfo> bufferInfos;
-    bufferInfos.reserve(set.getUniformBufferInfos().size());
-
-    const u8 *srcPtr = set.getUniformBufferData().data();
-    u8 *dstPtr = reinterpret_cast<u8 *>(uniformBufferMappedPointers_.at(swapImageIndex_));
-
-    VkDeviceSize &dstOffset = uniformBufferOffsets_.at(swapImageIndex_);
-    u32 minAlignment = (u32) limits_.minUniformBufferOffsetAlignment;
+    bufferInfos.reserve(set.getUniformBufferInfos().size() + set.getDynamicUniformBufferInfos().size());
 
     // Create descriptor writes that reference uniform buffer data
     VkBuffer buffer = uniformBuffers_.at(swapImageIndex_);
     for (const UniformBufferDescriptorInfo &info : set.getUniformBufferInfos()) {
-        if (dstOffset + info.dataRange > uniformBufferSize_) {
-            Log::fatal("This uniform buffer for descriptor set % in subpass % will overrun the buffer! "
-                       "Too much data was set via uniform buffers this frame.",
-                       set.getSetIndex(), set.getSubpassIndex());
-        }
-
-        // Copy data into buffer
-        std::memcpy(dstPtr + dstOffset, srcPtr + info.dataOffset, info.dataRange);
-
         // Set buffer info
         VkDescriptorBufferInfo bufferInfo = {};
         bufferInfo.buffer = buffer;
-        bufferInfo.offset = dstOffset;
+        bufferInfo.offset = writeUniformBufferData(set, info);
         bufferInfo.range = info.dataRange;
         bufferInfos.emplace_back(bufferInfo);
 
-        // Add to dstOffset, taking alignment into account
-        dstOffset += info.dataRange;
-        if (dstOffset % minAlignment != 0) {
-            dstOffset += minAlignment - (dstOffset % minAlignment);
-        }
-
         VkWriteDescriptorSet write = {};
         write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write.dstSet = dstSet;
         write.dstBinding = info.binding;
         write.descriptorCount = 1;
         write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         write.pBufferInfo = &bufferInfos.back();
+        addWrite(write, (u64) buffer, bufferInfo.offset, bufferInfo.range);
+    }
 
-        writes.emplace_back(write);
+    // Dynamic uniform buffers point at the start of the buffer, their data was already written
+    for (const UniformBufferDescriptorInfo &info : set.getDynamicUniformBufferInfos()) {
+        VkDescriptorBufferInfo bufferInfo = {};
+        bufferInfo.buffer = buffer;
+        bufferInfo.offset = 0;
+        bufferInfo.range = info.dataRange;
+        bufferInfos.emplace_back(bufferInfo);
+
+        VkWriteDescriptorSet write = {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstBinding = info.binding;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        write.pBufferInfo = &bufferInfos.back();
+        addWrite(write, (u64) buffer, 0, bufferInfo.range);
     }
 
     //----------------------------------
@@ -993,18 +1012,58 @@ VkDescriptorSet RenderDevice::getVkDescriptorSet(const GraphicsPass &pass, const
 
         VkWriteDescriptorSet write = {};
         write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write.dstSet = dstSet;
         write.dstBinding = info.binding;
         write.descriptorCount = 1;
         write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         write.pImageInfo = &imageInfos.back();
-
-        writes.emplace_back(write);
+        addWrite(write, (u64) info.view, (u64) info.sampler, 0);
     }
 
     // TODO: support other descriptor types
 
+    //----------------------------------
+    // Find or write the set
+    //----------------------------------
+
+    // Regular uniform buffers point at a new offset every frame, so sets with them can't be reused across frames
+    bool transient = !set.getUniformBufferInfos().empty();
+
+    if (!transient) {
+        // A set with the same contents was already written, nothing to update
+        VkDescriptorSet cachedSet = cache.findSetWithContents(contents);
+        if (cachedSet) {
+            return cachedSet;
+        }
+    }
+
+    // See if the cache can give us an unused descriptor set with the same layout
+    VkDescriptorSet dstSet = cache.findSetWithLayout(layout);
+
+    if (!dstSet) {
+        // We didn't find a descriptor set with the right layout, we need to allocate a new one
+        VkDescriptorSetAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = pools_.at(swapImageIndex_);
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &layout;
+
+        Log::verbose("Allocating new descriptor set for frame %, subpass %, set %", swapImageIndex_, subpassIdx, setIdx);
+
+        // TODO: handle case where we can't allocate new descriptor set
+        VK_CHECKF(vkAllocateDescriptorSets(device_, &allocInfo, &dstSet));
+    }
+
+    // Add it to the cache so we can find it next time we need a descriptor set with these contents or this layout
+    if (transient) {
+        cache.addTransient(layout, dstSet);
+    } else {
+        cache.addToCache(layout, std::move(contents), dstSet);
+    }
+
     // Write to descriptor set
+    for (VkWriteDescriptorSet &write : writes) {
+        write.dstSet = dstSet;
+    }
     vkUpdateDescriptorSets(device_, writes.size(), writes.data(), 0, nullptr);
 
     return dstSet;
@@ -1025,6 +1084,29 @@ VkFormat RenderDevice::getFirstSupportedFormat(const std::vector<VkFormat> &form
     return VK_FORMAT_UNDEFINED;
 }
 
+VkDeviceSize RenderDevice::writeUniformBufferData(const DescriptorSet &set, const UniformBufferDescriptorInfo &info) {
+    VkDeviceSize &dstOffset = uniformBufferOffsets_.at(swapImageIndex_);
+    if (dstOffset + info.dataRange > uniformBufferSize_) {
+        Log::fatal("This uniform buffer for descriptor set % in subpass % will overrun the buffer! "
+                   "Too much data was set via uniform buffers this frame.",
+                   set.getSetIndex(), set.getSubpassIndex());
+    }
+
+    // Copy data into buffer
+    u8 *dstPtr = reinterpret_cast<u8 *>(uniformBufferMappedPointers_.at(swapImageIndex_));
+    std::memcpy(dstPtr + dstOffset, set.getUniformBufferData().data() + info.dataOffset, info.dataRange);
+    VkDeviceSize offset = dstOffset;
+
+    // Add to dstOffset, taking alignment into account
+    u32 minAlignment = (u32) limits_.minUniformBufferOffsetAlignment;
+    dstOffset += info.dataRange;
+    if (dstOffset % minAlignment != 0) {
+        dstOffset += minAlignment - (dstOffset % minAlignment);
+    }
+
+    return offset;
+}
+
 void RenderDevice::choosePhysicalDevice() {
     u32 numPhysicalDevices;
     VK_CHECKF(vkEnumeratePhysicalDevices(instance_, &numPhysicalDevices, nullptr));
@@ -1087,6 +1169,7 @@ void RenderDevice::choosePhysicalDevice() {
         std::pair<bool, u32> graphicsFamilyIndex;
         std::pair<bool, u32> computeFamilyIndex;
         std::pair<bool, u32> presentFamilyIndex;
+        std::pair<bool, u32> transferFamilyIndex;
         for (u32 i = 0; i < numQueueFamilies; ++i) {
             // Check graphics support
             if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
@@ -1098,6 +1181,12 @@ void RenderDevice::choosePhysicalDevice() {
                 computeFamilyIndex = { true, i };
             }
 
+            // Check for a dedicated transfer queue, uploads on it run alongside rendering
+            if ((queueFamilies[i].queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+                !(queueFamilies[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+                transferFamilyIndex = { true, i };
+            }
+
             // Check present support
             VkBool32 presentSupport;
             vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface_, &presentSupport);
@@ -1116,6 +1205,10 @@ void RenderDevice::choosePhysicalDevice() {
                 graphicsFamilyIndex_ = graphicsFamilyIndex.second;
                 computeFamilyIndex_ = computeFamilyIndex.second;
                 presentFamilyIndex_ = presentFamilyIndex.second;
+
+                // Graphics queues can always do transfers
+                transferFamilyIndex_ = transferFamilyIndex.first ? transferFamilyIndex.second
+                                                                 : graphicsFamilyIndex.second;
             }
         }
 
@@ -1127,6 +1220,7 @@ void RenderDevice::choosePhysicalDevice() {
         Log::info("|   Graphics: %", graphicsFamilyIndex.first ? "yes" : "no");
         Log::info("|   Compute:  %", computeFamilyIndex.first ? "yes" : "no");
         Log::info("|   Present:  %", presentFamilyIndex.first ? "yes" : "no");
+        Log::info("|   Transfer: %", transferFamilyIndex.first ? "dedicated" : "graphics");
         Log::info("|   Suitable: %", suitable ? "yes" : "no");
         Log::info("+-------------------------------");
     }
@@ -1296,69 +1390,26 @@ void RenderDevice::createSwapchain() {
     }
 }
 
-VkBuffer RenderDevice::createBufferGPU(const void *data, VkDeviceSize size, VkBufferUsageFlagBits usage) {
+VkBuffer RenderDevice::createDeviceLocalBuffer(VkDeviceSize size, VkBufferUsageFlags usage) {
     // Create our buffer and memory
     VkBufferCreateInfo bufferCI = {};
     bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferCI.size = size;
     bufferCI.usage = usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
     bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    share_with_upload_queue(bufferCI, uploadQueueFamilies_);
 
     VmaAllocationCreateInfo allocCI = {};
     allocCI.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
     VkBuffer buffer;
     VmaAllocation allocation;
-    VmaAllocationInfo allocInfo;
-    VK_CHECKF(vmaCreateBuffer(allocator_, &bufferCI, &allocCI, &buffer, &allocation, &allocInfo));
+    VK_CHECKF(vmaCreateBuffer(allocator_, &bufferCI, &allocCI, &buffer, &allocation, nullptr));
     cleanupStack_.emplace([ = ]() {
         vmaDestroyBuffer(allocator_, buffer, allocation);
     });
 
-    VkMemoryPropertyFlags memFlags;
-    vmaGetMemoryTypeProperties(allocator_, allocInfo.memoryType, &memFlags);
-    if ((memFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0) {
-        // If the memory happens to be mappable, no need for staging buffer
-        void *mappedData;
-        vmaMapMemory(allocator_, allocation, &mappedData);
-        std::memcpy(mappedData, data, (size_t) size);
-        vmaUnmapMemory(allocator_, allocation);
-    } else {
-        // Otherwise, we need a staging buffer
-        std::pair<VkBuffer, VmaAllocation> stagingBuffer = createStagingBufferCPU(data, size);
-
-        // Copy staging buffer into vertex buffer
-        submitOneTimeCommands(graphicsQueue_, [ = ](CommandBuffer cmd) {
-            cmd.copyBuffer(buffer, stagingBuffer.first, size);
-        });
-
-        // Destroy staging buffer
-        vmaDestroyBuffer(allocator_, stagingBuffer.first, stagingBuffer.second);
-    }
-
     return buffer;
 }
 
-std::pair<VkBuffer, VmaAllocation> RenderDevice::createStagingBufferCPU(const void *data, VkDeviceSize size) {
-    VkBufferCreateInfo stagingBufferCI = {};
-    stagingBufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    stagingBufferCI.size = size;
-    stagingBufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    stagingBufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    VmaAllocationCreateInfo stagingAllocCI = {};
-    stagingAllocCI.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-    stagingAllocCI.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
-
-    VkBuffer stagingBuffer;
-    VmaAllocation stagingAllocation;
-    VmaAllocationInfo stagingAllocInfo;
-    VK_CHECKF(vmaCreateBuffer(allocator_, &stagingBufferCI, &stagingAllocCI, &stagingBuffer, &stagingAllocation,
-                              &stagingAllocInfo));
-
-    memcpy(stagingAllocInfo.pMappedData, data, static_cast<size_t>(size));
-
-    return { stagingBuffer, stagingAllocation };
-}
-
 }
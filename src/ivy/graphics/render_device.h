@@ -8,12 +8,15 @@
 #include "ivy/graphics/vertex_description.h"
 #include "ivy/graphics/graphics_pass.h"
 #include "ivy/graphics/descriptor_set_cache.h"
+#include "ivy/graphics/upload_manager.h"
+#include "ivy/graphics/buffer_suballocator.h"
 #include <vulkan/vulkan.h>
 #include <vk_mem_alloc.h>
 #include <vector>
 #include <string>
 #include <stack>
 #include <functional>
+#include <memory>
 #include <unordered_map>
 
 namespace ivy {
@@ -54,13 +57,6 @@ public:
      */
     VkQueue getGraphicsQueue();
 
-    /**
-     * \brief Get and submit a command buffer for recording one time commands (like a buffer copy)
-     * \param queue The queue the command buffer should be submitted to
-     * \param record_func A function that records commands into a command buffer
-     */
-    void submitOneTimeCommands(VkQueue queue, const std::function<void(CommandBuffer)> &record_func);
-
     /**
      * \brief Get format of swapchain image views
      * \return Swapchain format
@@ -77,6 +73,14 @@ public:
         return swapchainExtent_;
     }
 
+    /**
+     * \brief Check if the device can sample the BC1 to BC7 block compressed formats
+     * \return Whether or not block compressed textures are supported
+     */
+    [[nodiscard]] bool isBlockCompressionSupported() const {
+        return blockCompressionSupported_;
+    }
+
     /**
      * \brief Create a render pass
      * \param attachments A vector of attachments
@@ -92,9 +96,12 @@ public:
      * \brief Create a layout for a subpass
      * \param layout_bindings An unordered map of unordered maps of VkDescriptorSetLayoutBinding.
      * The keys are set and binding respectively.
+     * \param push_constant_ranges Push constant ranges, fatal error if they're misaligned or don't fit in
+     * maxPushConstantsSize
      * \return SubpassLayout
      */
-    SubpassLayout createLayout(const LayoutBindingsMap_t &layout_bindings = {});
+    SubpassLayout createLayout(const LayoutBindingsMap_t &layout_bindings = {},
+                               const std::vector<VkPushConstantRange> &push_constant_ranges = {});
 
     /**
      * \brief Create a graphics pipeline
@@ -121,23 +128,25 @@ public:
     Framebuffer &getFramebuffer(const GraphicsPass &pass);
 
     /**
-     * \brief Create a vertex buffer with the lifetime of the render device
+     * \brief Store vertices in one of the shared vertex buffers, they live as long as the render device
      * \param data Pointer to vertex data
      * \param size Size of vertex data in bytes
-     * \return VkBuffer
+     * \param stride Size of a vertex in bytes, the offset of the range is a multiple of it
+     * \return The range of the vertices in the buffer
      */
-    VkBuffer createVertexBuffer(const void *data, VkDeviceSize size);
+    BufferRange createVertexBuffer(const void *data, VkDeviceSize size, u32 stride);
 
     /**
-     * \brief Create an index buffer (of u32s) with the lifetime of the render device
+     * \brief Store indices (u32s) in one of the shared index buffers, they live as long as the render device
      * \param data Pointer to index data
-     * \param size Size of index buffer in bytes
-     * \return VkBuffer
+     * \param size Size of index data in bytes
+     * \return The range of the indices in the buffer
      */
-    VkBuffer createIndexBuffer(const void *data, VkDeviceSize size);
+    BufferRange createIndexBuffer(const void *data, VkDeviceSize size);
 
     /**
-     * \brief Create an image on the GPU using given image data with the lifetime of the render device
+     * \brief Create an image on the GPU using given image data with the lifetime of the render device. The data is
+     * uploaded along with everything else that is uploaded this frame, before the frame is rendered.
      * \param image_ci Image create info
      * \param image_view_ci Image view create info
      * \param data Pixel data
@@ -155,20 +164,27 @@ public:
      * \param u_wrap Wrapping for u addressing
      * \param v_wrap Wrapping for v addressing
      * \param w_wrap Wrapping for w addressing
+     * \param max_anisotropy The highest anisotropy to filter with, clamped to what the device supports. 1 disables
+     * anisotropic filtering.
+     * \param min_lod The most detailed mip level that can be sampled
+     * \param max_lod The least detailed mip level that can be sampled, VK_LOD_CLAMP_NONE to allow all of them
      * \return VkSampler
      */
     VkSampler createSampler(VkFilter mag_filter, VkFilter min_filter,
                             VkSamplerAddressMode u_wrap = VK_SAMPLER_ADDRESS_MODE_REPEAT,
                             VkSamplerAddressMode v_wrap = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-                            VkSamplerAddressMode w_wrap = VK_SAMPLER_ADDRESS_MODE_REPEAT);
+                            VkSamplerAddressMode w_wrap = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                            f32 max_anisotropy = 1.0f, f32 min_lod = 0.0f, f32 max_lod = VK_LOD_CLAMP_NONE);
 
     /**
      * \brief Get a VkDescriptorSet with data specified in set for a graphics pass for the current frame
      * \param pass The associated graphics pass
      * \param set The set
+     * \param out_dynamic_offsets The offsets to bind the set's dynamic uniform buffers with are written here
      * \return VkDescriptorSet ready for binding
      */
-    VkDescriptorSet getVkDescriptorSet(const GraphicsPass &pass, const DescriptorSet &set);
+    VkDescriptorSet getVkDescriptorSet(const GraphicsPass &pass, const DescriptorSet &set,
+                                       std::vector<u32> &out_dynamic_offsets);
 
     /**
      * \brief From a list, get the first format that is supported by the device with given features
@@ -192,21 +208,21 @@ private:
     void createSwapchain();
 
     /**
-     * \brief Create a buffer on the GPU with the lifetime of the render device
-     * \param data Pointer to the data
-     * \param size Size of the buffer in bytes
-     * \param usage How the buffer will be used
-     * \return VkBuffer
+     * \brief Copy uniform buffer data of a descriptor set into this frame's uniform buffer
+     * \param set The descriptor set
+     * \param info The uniform buffer in the set
+     * \return The offset of the data in the uniform buffer
      */
-    VkBuffer createBufferGPU(const void *data, VkDeviceSize size, VkBufferUsageFlagBits usage);
+    VkDeviceSize writeUniformBufferData(const DescriptorSet &set, const UniformBufferDescriptorInfo &info);
 
     /**
-     * \brief Create a staging src buffer on the CPU, you need to destroy this yourself with vmaDestroyBuffer
-     * \param data Pointer to the data
+     * \brief Create an uninitialized device local buffer with the lifetime of the render device, it can be filled
+     * through the upload manager
      * \param size Size of the buffer in bytes
+     * \param usage How the buffer will be used
      * \return VkBuffer
      */
-    std::pair<VkBuffer, VmaAllocation> createStagingBufferCPU(const void *data, VkDeviceSize size);
+    VkBuffer createDeviceLocalBuffer(VkDeviceSize size, VkBufferUsageFlags usage);
 
     const Options options_;
 
@@ -217,17 +233,27 @@ private:
 
     VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;
     VkPhysicalDeviceLimits limits_ = {};
+    bool samplerAnisotropySupported_ = false;
+    bool blockCompressionSupported_ = false;
     u32 graphicsFamilyIndex_ = 0;
     u32 computeFamilyIndex_ = 0;
     u32 presentFamilyIndex_ = 0;
+    u32 transferFamilyIndex_ = 0;
 
     VkDevice device_ = VK_NULL_HANDLE;
     VkQueue graphicsQueue_;
     VkQueue computeQueue_;
     VkQueue presentQueue_;
+    VkQueue transferQueue_;
 
     VmaAllocator allocator_;
 
+    std::unique_ptr<UploadManager> uploadManager_;
+    u32 uploadQueueFamilies_[2] = {};
+
+    std::unique_ptr<BufferSuballocator> vertexBuffers_;
+    std::unique_ptr<BufferSuballocator> indexBuffers_;
+
     VkSwapchainKHR swapchain_;
     VkExtent2D swapchainExtent_;
     VkFormat swapchainFormat_;
@@ -242,6 +268,7 @@ private:
     u32 swapImageIndex_ = 0;
     std::vector<VkSemaphore> imageAvailableSemaphores_;
     std::vector<VkSemaphore> renderFinishedSemaphores_;
+    std::vector<VkSemaphore> uploadFinishedSemaphores_;
     std::vector<VkFence> inFlightFences_;
 
     std::vector<VkDescriptorPool> pools_;
@@ -21,7 +21,11 @@ void main() {
         discard;
     }
 
-    oNormal.xyz = FS_IN.tbn * (texture(uNormalTexture, FS_IN.uv).rgb * 2 - 1);
+    // Normal maps can be BC5 compressed, which only keeps x and y
+    vec2 normalXY = texture(uNormalTexture, FS_IN.uv).rg * 2 - 1;
+    vec3 normal = vec3(normalXY, sqrt(max(1 - dot(normalXY, normalXY), 0)));
+
+    oNormal.xyz = FS_IN.tbn * normal;
     oNormal.w = 1;
 
     oOcclusionRoughnessMetallic.r = texture(uOcclusionTexture, FS_IN.uv).r;
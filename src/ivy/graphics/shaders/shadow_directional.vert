@@ -8,7 +8,7 @@ layout (set = 0, binding = 0) uniform PerLight {
     mat4 viewProjection;
 } uPerLight;
 
-layout (set = 1, binding = 0) uniform PerMesh {
+layout (push_constant) uniform PerMesh {
     mat4 model;
 } uPerMesh;
 
@@ -4,7 +4,7 @@ layout (location = 0) in vec3 inPosition;
 //layout (location = 1) in vec3 inNormal;
 //layout (location = 2) in vec2 inUV;
 
-layout (set = 1, binding = 0) uniform PerMesh {
+layout (push_constant) uniform PerMesh {
     mat4 model;
 } uPerMesh;
 
@@ -39,6 +39,11 @@ TextureBuilder &TextureBuilder::setArrayLength(u32 length) {
     return *this;
 }
 
+TextureBuilder &TextureBuilder::setMipLevels(u32 mip_levels) {
+    mipLevels_ = mip_levels;
+    return *this;
+}
+
 TextureBuilder &TextureBuilder::setData(const void *data, VkDeviceSize data_size) {
     data_ = data;
     dataSize_ = data_size;
@@ -52,7 +57,7 @@ Texture TextureBuilder::build() {
     imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageCI.format = format_;
     imageCI.extent = extent_;
-    imageCI.mipLevels = 1;
+    imageCI.mipLevels = mipLevels_;
     imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
     imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
     imageCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | additionalUsage_;
@@ -69,6 +74,10 @@ Texture TextureBuilder::build() {
         Log::fatal("Invalid array size: %", arrayLength_);
     }
 
+    if (mipLevels_ < 1) {
+        Log::fatal("Invalid number of mip levels: %", mipLevels_);
+    }
+
     switch (type_) {
         case Texture::Type::TEX_CUBEMAP:
             imageCI.arrayLayers = 6 * arrayLength_;
@@ -31,6 +31,10 @@ public:
         return imageCI_.arrayLayers;
     }
 
+    [[nodiscard]] u32 getMipLevels() const {
+        return imageCI_.mipLevels;
+    }
+
     [[nodiscard]] VkImageViewType getViewType() const {
         return viewCI_.viewType;
     }
@@ -74,6 +78,9 @@ public:
 
     TextureBuilder &setArrayLength(u32 length);
 
+    TextureBuilder &setMipLevels(u32 mip_levels);
+
+    // The data holds every mip level, laid out as described by get_mip_chain_layout
     TextureBuilder &setData(const void *data, VkDeviceSize data_size);
 
     template <typename T>
@@ -94,6 +101,7 @@ private:
     VkSampler sampler_{};
     VkImageUsageFlags additionalUsage_{};
     u32 arrayLength_ = 1;
+    u32 mipLevels_ = 1;
     const void *data_{};
     VkDeviceSize dataSize_{};
 };
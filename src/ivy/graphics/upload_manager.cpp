@@ -0,0 +1,301 @@
+#include "upload_manager.h"
+#include "vk_utils.h"
+#include "ivy/graphics/command_buffer.h"
+#include <cstring>
+
+namespace ivy::gfx {
+
+// Offsets of buffer to image copies have to be multiples of 4 and of the texel block size, which is at most 16
+constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+UploadManager::UploadManager(VkDevice device, VmaAllocator allocator, VkQueue queue, u32 queue_family_index,
+                             VkDeviceSize ring_size)
+    : device_(device), allocator_(allocator), queue_(queue), ringSize_(ring_size) {
+    VkCommandPoolCreateInfo commandPoolCI = {};
+    commandPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolCI.queueFamilyIndex = queue_family_index;
+    commandPoolCI.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    VK_CHECKF(vkCreateCommandPool(device_, &commandPoolCI, nullptr, &commandPool_));
+
+    VkBufferCreateInfo ringCI = {};
+    ringCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    ringCI.size = ringSize_;
+    ringCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    ringCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VmaAllocationCreateInfo ringAllocCI = {};
+    ringAllocCI.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    ringAllocCI.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VmaAllocationInfo ringAllocInfo;
+    VK_CHECKF(vmaCreateBuffer(allocator_, &ringCI, &ringAllocCI, &ringBuffer_, &ringAllocation_, &ringAllocInfo));
+    ringData_ = static_cast<u8 *>(ringAllocInfo.pMappedData);
+
+    Log::debug("Allocated a staging ring of size %", ringSize_);
+}
+
+UploadManager::~UploadManager() {
+    for (Batch &batch : submittedBatches_) {
+        vkWaitForFences(device_, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+    }
+    retireBatches(false);
+
+    if (recording_) {
+        freeBatches_.emplace_back(std::move(recordingBatch_));
+    }
+
+    for (Batch &batch : freeBatches_) {
+        for (std::pair<VkBuffer, VmaAllocation> &stagingBuffer : batch.stagingBuffers) {
+            vmaDestroyBuffer(allocator_, stagingBuffer.first, stagingBuffer.second);
+        }
+        vkDestroyFence(device_, batch.fence, nullptr);
+    }
+
+    // Destroying the pool frees the command buffers
+    vkDestroyCommandPool(device_, commandPool_, nullptr);
+    vmaDestroyBuffer(allocator_, ringBuffer_, ringAllocation_);
+}
+
+void UploadManager::uploadBuffer(VkBuffer dst, const void *data, VkDeviceSize size, VkDeviceSize dst_offset) {
+    if (size == 0) {
+        return;
+    }
+
+    VkBuffer stagingBuffer;
+    VkDeviceSize stagingOffset;
+    stage(data, size, stagingBuffer, stagingOffset);
+
+    CommandBuffer cmd(getRecordingBatch().commandBuffer);
+    cmd.copyBuffer(dst, stagingBuffer, size, dst_offset, stagingOffset);
+}
+
+void UploadManager::uploadImage(VkImage dst, const VkImageSubresourceRange &subresource_range, const void *data,
+                                VkDeviceSize size, u32 num_regions, const VkBufferImageCopy *regions) {
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceSize stagingOffset = 0;
+    if (size > 0) {
+        stage(data, size, stagingBuffer, stagingOffset);
+    }
+
+    std::vector<VkBufferImageCopy> stagedRegions(regions, regions + num_regions);
+    for (VkBufferImageCopy &region : stagedRegions) {
+        region.bufferOffset += stagingOffset;
+    }
+
+    CommandBuffer cmd(getRecordingBatch().commandBuffer);
+
+    // Transition image for copying buffer into it
+    {
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = dst;
+        barrier.subresourceRange = subresource_range;
+
+        cmd.pipelineBarrier(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                            0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    // Copy buffer into it
+    if (!stagedRegions.empty()) {
+        cmd.copyBufferToImage(stagingBuffer, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (u32) stagedRegions.size(),
+                              stagedRegions.data());
+    }
+
+    // Transition image for reading in shaders. Transfer queues don't have shader stages, the semaphore that the
+    // graphics queue waits on makes the writes visible to them.
+    {
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = dst;
+        barrier.subresourceRange = subresource_range;
+
+        cmd.pipelineBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                            0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+}
+
+bool UploadManager::submit(VkSemaphore signal_semaphore) {
+    bool uploaded = recording_ || submittedSinceSignal_;
+    if (uploaded) {
+        submitBatch(signal_semaphore);
+        submittedSinceSignal_ = false;
+    }
+
+    retireBatches(false);
+
+    return uploaded;
+}
+
+UploadManager::Batch &UploadManager::getRecordingBatch() {
+    if (recording_) {
+        return recordingBatch_;
+    }
+
+    retireBatches(false);
+
+    if (freeBatches_.empty()) {
+        Batch &batch = freeBatches_.emplace_back();
+
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        allocInfo.commandPool = commandPool_;
+        VK_CHECKF(vkAllocateCommandBuffers(device_, &allocInfo, &batch.commandBuffer));
+
+        VkFenceCreateInfo fenceCI = {};
+        fenceCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VK_CHECKF(vkCreateFence(device_, &fenceCI, nullptr, &batch.fence));
+    }
+
+    recordingBatch_ = std::move(freeBatches_.back());
+    freeBatches_.pop_back();
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECKF(vkBeginCommandBuffer(recordingBatch_.commandBuffer, &beginInfo));
+    recording_ = true;
+
+    return recordingBatch_;
+}
+
+void UploadManager::stage(const void *data, VkDeviceSize size, VkBuffer &out_buffer, VkDeviceSize &out_offset) {
+    if (size > ringSize_) {
+        VkBufferCreateInfo stagingBufferCI = {};
+        stagingBufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        stagingBufferCI.size = size;
+        stagingBufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        stagingBufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VmaAllocationCreateInfo stagingAllocCI = {};
+        stagingAllocCI.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+        stagingAllocCI.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+        VmaAllocation stagingAllocation;
+        VmaAllocationInfo stagingAllocInfo;
+        VK_CHECKF(vmaCreateBuffer(allocator_, &stagingBufferCI, &stagingAllocCI, &out_buffer, &stagingAllocation,
+                                  &stagingAllocInfo));
+        std::memcpy(stagingAllocInfo.pMappedData, data, (size_t) size);
+
+        getRecordingBatch().stagingBuffers.emplace_back(out_buffer, stagingAllocation);
+        out_offset = 0;
+        return;
+    }
+
+    // When the ring is full, the copies that use it are submitted and waited for oldest first until there's room
+    while (!allocateFromRing(size, out_offset)) {
+        submitBatch(VK_NULL_HANDLE);
+        retireBatches(true);
+    }
+
+    std::memcpy(ringData_ + out_offset, data, (size_t) size);
+
+    Batch &batch = getRecordingBatch();
+    if (!batch.usesRing) {
+        batch.usesRing = true;
+        batch.ringBegin = out_offset;
+    }
+
+    out_buffer = ringBuffer_;
+}
+
+bool UploadManager::allocateFromRing(VkDeviceSize size, VkDeviceSize &out_offset) {
+    // Data that is still needed starts where the oldest batch that uses the ring staged its data
+    const Batch *oldest = nullptr;
+    for (const Batch &batch : submittedBatches_) {
+        if (batch.usesRing) {
+            oldest = &batch;
+            break;
+        }
+    }
+    if (!oldest && recording_ && recordingBatch_.usesRing) {
+        oldest = &recordingBatch_;
+    }
+
+    VkDeviceSize begin = (ringHead_ + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+    if (!oldest) {
+        begin = 0;
+    } else if (ringHead_ > oldest->ringBegin) {
+        // Used: [tail, head), free: [head, end) and [0, tail). Space is left between the head and the tail so that
+        // a full ring can't be mistaken for an empty one.
+        if (begin + size > ringSize_) {
+            if (size >= oldest->ringBegin) {
+                return false;
+            }
+            begin = 0;
+        }
+    } else if (begin + size >= oldest->ringBegin) {
+        // Used: [tail, end) and [0, head), free: [head, tail)
+        return false;
+    }
+
+    out_offset = begin;
+    ringHead_ = begin + size;
+
+    return true;
+}
+
+void UploadManager::submitBatch(VkSemaphore signal_semaphore) {
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.signalSemaphoreCount = signal_semaphore != VK_NULL_HANDLE ? 1 : 0;
+    submitInfo.pSignalSemaphores = &signal_semaphore;
+
+    if (!recording_) {
+        // Signaling the semaphore still waits for the batches that were submitted before, they're on the same queue
+        if (signal_semaphore != VK_NULL_HANDLE) {
+            VK_CHECKF(vkQueueSubmit(queue_, 1, &submitInfo, VK_NULL_HANDLE));
+        }
+        return;
+    }
+
+    VK_CHECKF(vkEndCommandBuffer(recordingBatch_.commandBuffer));
+
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &recordingBatch_.commandBuffer;
+    VK_CHECKF(vkQueueSubmit(queue_, 1, &submitInfo, recordingBatch_.fence));
+
+    submittedBatches_.emplace_back(std::move(recordingBatch_));
+    recordingBatch_ = Batch();
+    recording_ = false;
+    submittedSinceSignal_ = true;
+}
+
+void UploadManager::retireBatches(bool wait_for_oldest) {
+    while (!submittedBatches_.empty()) {
+        Batch &batch = submittedBatches_.front();
+        if (wait_for_oldest) {
+            VK_CHECKF(vkWaitForFences(device_, 1, &batch.fence, VK_TRUE, UINT64_MAX));
+            wait_for_oldest = false;
+        } else if (vkGetFenceStatus(device_, batch.fence) != VK_SUCCESS) {
+            break;
+        }
+
+        for (std::pair<VkBuffer, VmaAllocation> &stagingBuffer : batch.stagingBuffers) {
+            vmaDestroyBuffer(allocator_, stagingBuffer.first, stagingBuffer.second);
+        }
+        batch.stagingBuffers.clear();
+        batch.usesRing = false;
+
+        VK_CHECKF(vkResetFences(device_, 1, &batch.fence));
+        VK_CHECKF(vkResetCommandBuffer(batch.commandBuffer, 0));
+
+        freeBatches_.emplace_back(std::move(batch));
+        submittedBatches_.pop_front();
+    }
+}
+
+}
@@ -0,0 +1,134 @@
+#ifndef IVY_UPLOAD_MANAGER_H
+#define IVY_UPLOAD_MANAGER_H
+
+#include "ivy/types.h"
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace ivy::gfx {
+
+/**
+ * \brief Copies data to GPU buffers and images through a persistently mapped staging ring buffer. Copies are recorded
+ * into batches that are submitted together, and the staging memory of a batch is reused once its fence is signaled.
+ */
+class UploadManager {
+public:
+    /**
+     * \param device The logical device
+     * \param allocator The allocator to allocate staging memory with
+     * \param queue The queue copies are submitted to, preferably a dedicated transfer queue
+     * \param queue_family_index The queue family of the queue
+     * \param ring_size The size of the staging ring in bytes, larger uploads get a staging buffer of their own
+     */
+    UploadManager(VkDevice device, VmaAllocator allocator, VkQueue queue, u32 queue_family_index,
+                  VkDeviceSize ring_size);
+    ~UploadManager();
+
+    UploadManager(const UploadManager &) = delete;
+    UploadManager &operator=(const UploadManager &) = delete;
+
+    /**
+     * \brief Copy data into a buffer. The data is staged right away, so it can be freed once this returns.
+     * \param dst The buffer, it must have been created with VK_BUFFER_USAGE_TRANSFER_DST_BIT
+     * \param data Pointer to the data
+     * \param size Size of the data in bytes
+     * \param dst_offset The offset in the buffer to copy to
+     */
+    void uploadBuffer(VkBuffer dst, const void *data, VkDeviceSize size, VkDeviceSize dst_offset = 0);
+
+    /**
+     * \brief Copy data into an image and transition it to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL. The data is staged
+     * right away, so it can be freed once this returns.
+     * \param dst The image, it must be in VK_IMAGE_LAYOUT_UNDEFINED and have been created with
+     * VK_IMAGE_USAGE_TRANSFER_DST_BIT
+     * \param subresource_range The subresources of the image that are transitioned
+     * \param data Pointer to the data
+     * \param size Size of the data in bytes
+     * \param num_regions The number of regions
+     * \param regions The regions to copy, their buffer offsets are relative to data
+     */
+    void uploadImage(VkImage dst, const VkImageSubresourceRange &subresource_range, const void *data,
+                     VkDeviceSize size, u32 num_regions, const VkBufferImageCopy *regions);
+
+    /**
+     * \brief Submit the copies that were recorded since the last call
+     * \param signal_semaphore Signaled once every copy submitted so far is done
+     * \return Whether anything was uploaded since the last call, the semaphore is only signaled if so
+     */
+    bool submit(VkSemaphore signal_semaphore);
+
+private:
+    /**
+     * \brief Copies that are submitted together
+     */
+    struct Batch {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+
+        // The part of the ring the batch staged its data in, it's free again once the fence is signaled
+        bool usesRing = false;
+        VkDeviceSize ringBegin = 0;
+
+        // Staging buffers of uploads that are larger than the ring, destroyed once the fence is signaled
+        std::vector<std::pair<VkBuffer, VmaAllocation>> stagingBuffers;
+    };
+
+    /**
+     * \brief Get the batch that copies are recorded into, begins a new one if there isn't one
+     * \return The batch
+     */
+    Batch &getRecordingBatch();
+
+    /**
+     * \brief Copy data into staging memory, waits for earlier batches to finish if the ring is full
+     * \param data Pointer to the data
+     * \param size Size of the data in bytes
+     * \param out_buffer The staging buffer is written here
+     * \param out_offset The offset of the data in the staging buffer is written here
+     */
+    void stage(const void *data, VkDeviceSize size, VkBuffer &out_buffer, VkDeviceSize &out_offset);
+
+    /**
+     * \brief Allocate space in the ring
+     * \param size Size in bytes
+     * \param out_offset The offset of the space is written here
+     * \return Whether or not there was enough contiguous free space
+     */
+    bool allocateFromRing(VkDeviceSize size, VkDeviceSize &out_offset);
+
+    /**
+     * \brief Submit the recording batch. If nothing was recorded the semaphore is still signaled.
+     * \param signal_semaphore Semaphore to signal when it's done, may be VK_NULL_HANDLE
+     */
+    void submitBatch(VkSemaphore signal_semaphore);
+
+    /**
+     * \brief Free the staging memory of submitted batches that are done, oldest first
+     * \param wait_for_oldest Whether or not to wait for the oldest batch to be done
+     */
+    void retireBatches(bool wait_for_oldest);
+
+    VkDevice device_;
+    VmaAllocator allocator_;
+    VkQueue queue_;
+    VkCommandPool commandPool_ = VK_NULL_HANDLE;
+
+    VkBuffer ringBuffer_ = VK_NULL_HANDLE;
+    VmaAllocation ringAllocation_ = VK_NULL_HANDLE;
+    u8 *ringData_ = nullptr;
+    VkDeviceSize ringSize_;
+    VkDeviceSize ringHead_ = 0;
+
+    bool recording_ = false;
+    Batch recordingBatch_;
+    std::deque<Batch> submittedBatches_;
+    std::vector<Batch> freeBatches_;
+    bool submittedSinceSignal_ = false;
+};
+
+}
+
+#endif // IVY_UPLOAD_MANAGER_H
@@ -0,0 +1,260 @@
+#include "batch_cull.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define IVY_BATCH_CULL_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <xmmintrin.h>
+    #define IVY_BATCH_CULL_SSE
+#endif
+
+namespace ivy {
+
+void BoundsBatch::clear() {
+    for (std::vector<f32> *v : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ}) {
+        v->clear();
+    }
+}
+
+void BoundsBatch::add(const AABB &bounds) {
+    glm::vec3 center = bounds.getCenter();
+    glm::vec3 extents = bounds.getExtents();
+
+    centerX.emplace_back(center.x);
+    centerY.emplace_back(center.y);
+    centerZ.emplace_back(center.z);
+    extentX.emplace_back(extents.x);
+    extentY.emplace_back(extents.y);
+    extentZ.emplace_back(extents.z);
+}
+
+static bool intersects_scalar(const BoundsBatch &batch, u32 idx, const Frustum &frustum) {
+    for (u32 p = 0; p < Frustum::NUM_PLANES; ++p) {
+        const glm::vec4 &plane = frustum.getPlane((Frustum::Plane) p);
+        f32 distance = plane.x * batch.centerX[idx] + plane.y * batch.centerY[idx] + plane.z * batch.centerZ[idx] +
+                       plane.w;
+        f32 radius = std::abs(plane.x) * batch.extentX[idx] + std::abs(plane.y) * batch.extentY[idx] +
+                     std::abs(plane.z) * batch.extentZ[idx];
+
+        if (distance + radius < 0.0f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool intersects_scalar(const BoundsBatch &batch, u32 idx, const Sphere &sphere) {
+    f32 dx = std::max(std::abs(batch.centerX[idx] - sphere.center.x) - batch.extentX[idx], 0.0f);
+    f32 dy = std::max(std::abs(batch.centerY[idx] - sphere.center.y) - batch.extentY[idx], 0.0f);
+    f32 dz = std::max(std::abs(batch.centerZ[idx] - sphere.center.z) - batch.extentZ[idx], 0.0f);
+
+    return dx * dx + dy * dy + dz * dz <= sphere.radius * sphere.radius;
+}
+
+#if defined(IVY_BATCH_CULL_AVX2) || defined(IVY_BATCH_CULL_SSE)
+
+#if defined(IVY_BATCH_CULL_AVX2)
+
+using simd_t = __m256;
+constexpr u32 LANES = 8;
+
+static inline simd_t load(const f32 *p) {
+    return _mm256_loadu_ps(p);
+}
+
+static inline simd_t set1(f32 v) {
+    return _mm256_set1_ps(v);
+}
+
+static inline simd_t add(simd_t a, simd_t b) {
+    return _mm256_add_ps(a, b);
+}
+
+static inline simd_t sub(simd_t a, simd_t b) {
+    return _mm256_sub_ps(a, b);
+}
+
+static inline simd_t mul(simd_t a, simd_t b) {
+    return _mm256_mul_ps(a, b);
+}
+
+static inline simd_t max(simd_t a, simd_t b) {
+    return _mm256_max_ps(a, b);
+}
+
+static inline simd_t abs(simd_t a) {
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+}
+
+static inline simd_t and_mask(simd_t a, simd_t b) {
+    return _mm256_and_ps(a, b);
+}
+
+static inline simd_t greater_equal(simd_t a, simd_t b) {
+    return _mm256_cmp_ps(a, b, _CMP_GE_OQ);
+}
+
+static inline u32 move_mask(simd_t a) {
+    return (u32) _mm256_movemask_ps(a);
+}
+
+#else
+
+using simd_t = __m128;
+constexpr u32 LANES = 4;
+
+static inline simd_t load(const f32 *p) {
+    return _mm_loadu_ps(p);
+}
+
+static inline simd_t set1(f32 v) {
+    return _mm_set1_ps(v);
+}
+
+static inline simd_t add(simd_t a, simd_t b) {
+    return _mm_add_ps(a, b);
+}
+
+static inline simd_t sub(simd_t a, simd_t b) {
+    return _mm_sub_ps(a, b);
+}
+
+static inline simd_t mul(simd_t a, simd_t b) {
+    return _mm_mul_ps(a, b);
+}
+
+static inline simd_t max(simd_t a, simd_t b) {
+    return _mm_max_ps(a, b);
+}
+
+static inline simd_t abs(simd_t a) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+}
+
+static inline simd_t and_mask(simd_t a, simd_t b) {
+    return _mm_and_ps(a, b);
+}
+
+static inline simd_t greater_equal(simd_t a, simd_t b) {
+    return _mm_cmpge_ps(a, b);
+}
+
+static inline u32 move_mask(simd_t a) {
+    return (u32) _mm_movemask_ps(a);
+}
+
+#endif
+
+/**
+ * \brief Append the indices of the set bits in a lane mask
+ */
+static inline void append_lanes(u32 mask, u32 first_idx, std::vector<u32> &out_visible) {
+    for (u32 lane = 0; mask != 0; ++lane, mask >>= 1u) {
+        if (mask & 1u) {
+            out_visible.emplace_back(first_idx + lane);
+        }
+    }
+}
+
+void cull_bounds(const BoundsBatch &batch, const Frustum &frustum, std::vector<u32> &out_visible) {
+    out_visible.clear();
+    const u32 count = batch.size();
+    const simd_t zero = set1(0);
+
+    // Broadcast every plane once, the absolute value of the normal projects the extents onto it
+    simd_t planeX[Frustum::NUM_PLANES], planeY[Frustum::NUM_PLANES], planeZ[Frustum::NUM_PLANES];
+    simd_t planeW[Frustum::NUM_PLANES];
+    simd_t absX[Frustum::NUM_PLANES], absY[Frustum::NUM_PLANES], absZ[Frustum::NUM_PLANES];
+    for (u32 p = 0; p < Frustum::NUM_PLANES; ++p) {
+        const glm::vec4 &plane = frustum.getPlane((Frustum::Plane) p);
+        planeX[p] = set1(plane.x);
+        planeY[p] = set1(plane.y);
+        planeZ[p] = set1(plane.z);
+        planeW[p] = set1(plane.w);
+        absX[p] = set1(std::abs(plane.x));
+        absY[p] = set1(std::abs(plane.y));
+        absZ[p] = set1(std::abs(plane.z));
+    }
+
+    // Each lane is a different box
+    u32 i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        simd_t cx = load(&batch.centerX[i]);
+        simd_t cy = load(&batch.centerY[i]);
+        simd_t cz = load(&batch.centerZ[i]);
+        simd_t ex = load(&batch.extentX[i]);
+        simd_t ey = load(&batch.extentY[i]);
+        simd_t ez = load(&batch.extentZ[i]);
+
+        // Every lane starts out inside, then each plane can reject lanes
+        simd_t inside = greater_equal(zero, zero);
+        for (u32 p = 0; p < Frustum::NUM_PLANES; ++p) {
+            simd_t distance = add(add(mul(planeX[p], cx), mul(planeY[p], cy)), add(mul(planeZ[p], cz), planeW[p]));
+            simd_t radius = add(add(mul(absX[p], ex), mul(absY[p], ey)), mul(absZ[p], ez));
+            inside = and_mask(inside, greater_equal(add(distance, radius), zero));
+        }
+
+        append_lanes(move_mask(inside), i, out_visible);
+    }
+
+    // Leftovers that don't fill a register
+    for (; i < count; ++i) {
+        if (intersects_scalar(batch, i, frustum)) {
+            out_visible.emplace_back(i);
+        }
+    }
+}
+
+void cull_bounds(const BoundsBatch &batch, const Sphere &sphere, std::vector<u32> &out_visible) {
+    out_visible.clear();
+    const u32 count = batch.size();
+    const simd_t zero = set1(0);
+    const simd_t sx = set1(sphere.center.x);
+    const simd_t sy = set1(sphere.center.y);
+    const simd_t sz = set1(sphere.center.z);
+    const simd_t radiusSquared = set1(sphere.radius * sphere.radius);
+
+    // Each lane is a different box, the distance from the sphere center to the closest point in the box is compared
+    // against the radius
+    u32 i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        simd_t dx = max(sub(abs(sub(load(&batch.centerX[i]), sx)), load(&batch.extentX[i])), zero);
+        simd_t dy = max(sub(abs(sub(load(&batch.centerY[i]), sy)), load(&batch.extentY[i])), zero);
+        simd_t dz = max(sub(abs(sub(load(&batch.centerZ[i]), sz)), load(&batch.extentZ[i])), zero);
+        simd_t distanceSquared = add(add(mul(dx, dx), mul(dy, dy)), mul(dz, dz));
+
+        append_lanes(move_mask(greater_equal(radiusSquared, distanceSquared)), i, out_visible);
+    }
+
+    // Leftovers that don't fill a register
+    for (; i < count; ++i) {
+        if (intersects_scalar(batch, i, sphere)) {
+            out_visible.emplace_back(i);
+        }
+    }
+}
+
+#else
+
+void cull_bounds(const BoundsBatch &batch, const Frustum &frustum, std::vector<u32> &out_visible) {
+    out_visible.clear();
+    for (u32 i = 0; i < batch.size(); ++i) {
+        if (intersects_scalar(batch, i, frustum)) {
+            out_visible.emplace_back(i);
+        }
+    }
+}
+
+void cull_bounds(const BoundsBatch &batch, const Sphere &sphere, std::vector<u32> &out_visible) {
+    out_visible.clear();
+    for (u32 i = 0; i < batch.size(); ++i) {
+        if (intersects_scalar(batch, i, sphere)) {
+            out_visible.emplace_back(i);
+        }
+    }
+}
+
+#endif
+
+}
@@ -0,0 +1,58 @@
+#ifndef IVY_BATCH_CULL_H
+#define IVY_BATCH_CULL_H
+
+#include "ivy/types.h"
+#include "ivy/math/bounds.h"
+#include "ivy/math/frustum.h"
+#include <vector>
+
+namespace ivy {
+
+/**
+ * \brief Bounding boxes laid out as one array per scalar so they can be tested several boxes at a time
+ */
+struct BoundsBatch {
+    std::vector<f32> centerX, centerY, centerZ;
+    std::vector<f32> extentX, extentY, extentZ;
+
+    /**
+     * \brief Remove all boxes from the batch, this keeps the memory
+     */
+    void clear();
+
+    /**
+     * \brief Add a box to the end of the batch
+     * \param bounds The box, it must be valid
+     */
+    void add(const AABB &bounds);
+
+    /**
+     * \brief Get the number of boxes in the batch
+     * \return Number of boxes
+     */
+    [[nodiscard]] u32 size() const {
+        return (u32) centerX.size();
+    }
+};
+
+/**
+ * \brief Find the boxes in a batch that might be inside of a frustum, with the same test as Frustum::intersects.
+ * Uses AVX2 or SSE when available, otherwise scalar code.
+ * \param batch The boxes
+ * \param frustum The frustum
+ * \param out_visible The indices of the boxes that might be visible are written here in increasing order
+ */
+void cull_bounds(const BoundsBatch &batch, const Frustum &frustum, std::vector<u32> &out_visible);
+
+/**
+ * \brief Find the boxes in a batch that intersect a sphere, with the same test as Sphere::intersects.
+ * Uses AVX2 or SSE when available, otherwise scalar code.
+ * \param batch The boxes
+ * \param sphere The sphere
+ * \param out_visible The indices of the boxes that intersect the sphere are written here in increasing order
+ */
+void cull_bounds(const BoundsBatch &batch, const Sphere &sphere, std::vector<u32> &out_visible);
+
+}
+
+#endif // IVY_BATCH_CULL_H
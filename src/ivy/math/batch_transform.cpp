@@ -0,0 +1,218 @@
+#include "batch_transform.h"
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define IVY_BATCH_TRANSFORM_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <xmmintrin.h>
+    #define IVY_BATCH_TRANSFORM_SSE
+#endif
+
+namespace ivy {
+
+void TransformBatch::clear() {
+    for (std::vector<f32> *v : {&positionX, &positionY, &positionZ,
+                                &orientationX, &orientationY, &orientationZ, &orientationW,
+                                &scaleX, &scaleY, &scaleZ}) {
+        v->clear();
+    }
+}
+
+void TransformBatch::add(const glm::vec3 &position, const glm::quat &orientation, const glm::vec3 &scale) {
+    positionX.emplace_back(position.x);
+    positionY.emplace_back(position.y);
+    positionZ.emplace_back(position.z);
+    orientationX.emplace_back(orientation.x);
+    orientationY.emplace_back(orientation.y);
+    orientationZ.emplace_back(orientation.z);
+    orientationW.emplace_back(orientation.w);
+    scaleX.emplace_back(scale.x);
+    scaleY.emplace_back(scale.y);
+    scaleZ.emplace_back(scale.z);
+}
+
+void compute_transform_matrices_scalar(const TransformBatch &batch, u32 idx, glm::mat4 &out_model,
+                                       glm::mat4 &out_normal) {
+    f32 x = batch.orientationX[idx];
+    f32 y = batch.orientationY[idx];
+    f32 z = batch.orientationZ[idx];
+    f32 w = batch.orientationW[idx];
+
+    // Rotation matrix columns, same as glm::mat3_cast
+    glm::vec3 r0(1 - 2 * (y * y + z * z), 2 * (x * y + w * z), 2 * (x * z - w * y));
+    glm::vec3 r1(2 * (x * y - w * z), 1 - 2 * (x * x + z * z), 2 * (y * z + w * x));
+    glm::vec3 r2(2 * (x * z + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y));
+
+    f32 sx = batch.scaleX[idx];
+    f32 sy = batch.scaleY[idx];
+    f32 sz = batch.scaleZ[idx];
+
+    out_model[0] = glm::vec4(r0 * sx, 0);
+    out_model[1] = glm::vec4(r1 * sy, 0);
+    out_model[2] = glm::vec4(r2 * sz, 0);
+    out_model[3] = glm::vec4(batch.positionX[idx], batch.positionY[idx], batch.positionZ[idx], 1);
+
+    out_normal[0] = glm::vec4(r0 / sx, 0);
+    out_normal[1] = glm::vec4(r1 / sy, 0);
+    out_normal[2] = glm::vec4(r2 / sz, 0);
+    out_normal[3] = glm::vec4(0, 0, 0, 1);
+}
+
+#if defined(IVY_BATCH_TRANSFORM_AVX2) || defined(IVY_BATCH_TRANSFORM_SSE)
+
+#if defined(IVY_BATCH_TRANSFORM_AVX2)
+
+using simd_t = __m256;
+constexpr u32 LANES = 8;
+
+static inline simd_t load(const f32 *p) {
+    return _mm256_loadu_ps(p);
+}
+
+static inline simd_t set1(f32 v) {
+    return _mm256_set1_ps(v);
+}
+
+static inline simd_t add(simd_t a, simd_t b) {
+    return _mm256_add_ps(a, b);
+}
+
+static inline simd_t sub(simd_t a, simd_t b) {
+    return _mm256_sub_ps(a, b);
+}
+
+static inline simd_t mul(simd_t a, simd_t b) {
+    return _mm256_mul_ps(a, b);
+}
+
+static inline simd_t div(simd_t a, simd_t b) {
+    return _mm256_div_ps(a, b);
+}
+
+/**
+ * \brief Transpose 4 registers of 8 lanes and store them as column col of 8 consecutive matrices
+ */
+static inline void store_column(glm::mat4 *out, u32 col, simd_t a, simd_t b, simd_t c, simd_t d) {
+    // Transposes within each 128 bit half, the low half holds lanes 0-3 and the high half lanes 4-7
+    simd_t t0 = _mm256_unpacklo_ps(a, b);
+    simd_t t1 = _mm256_unpackhi_ps(a, b);
+    simd_t t2 = _mm256_unpacklo_ps(c, d);
+    simd_t t3 = _mm256_unpackhi_ps(c, d);
+    simd_t rows[4] = {
+        _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+        _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+        _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+        _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)),
+    };
+
+    for (u32 i = 0; i < 4; ++i) {
+        _mm_storeu_ps(&out[i][col][0], _mm256_castps256_ps128(rows[i]));
+        _mm_storeu_ps(&out[i + 4][col][0], _mm256_extractf128_ps(rows[i], 1));
+    }
+}
+
+#else
+
+using simd_t = __m128;
+constexpr u32 LANES = 4;
+
+static inline simd_t load(const f32 *p) {
+    return _mm_loadu_ps(p);
+}
+
+static inline simd_t set1(f32 v) {
+    return _mm_set1_ps(v);
+}
+
+static inline simd_t add(simd_t a, simd_t b) {
+    return _mm_add_ps(a, b);
+}
+
+static inline simd_t sub(simd_t a, simd_t b) {
+    return _mm_sub_ps(a, b);
+}
+
+static inline simd_t mul(simd_t a, simd_t b) {
+    return _mm_mul_ps(a, b);
+}
+
+static inline simd_t div(simd_t a, simd_t b) {
+    return _mm_div_ps(a, b);
+}
+
+/**
+ * \brief Transpose 4 registers of 4 lanes and store them as column col of 4 consecutive matrices
+ */
+static inline void store_column(glm::mat4 *out, u32 col, simd_t a, simd_t b, simd_t c, simd_t d) {
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+    _mm_storeu_ps(&out[0][col][0], a);
+    _mm_storeu_ps(&out[1][col][0], b);
+    _mm_storeu_ps(&out[2][col][0], c);
+    _mm_storeu_ps(&out[3][col][0], d);
+}
+
+#endif
+
+void compute_transform_matrices(const TransformBatch &batch, glm::mat4 *out_model, glm::mat4 *out_normal) {
+    const u32 count = batch.size();
+    const simd_t zero = set1(0);
+    const simd_t one = set1(1);
+    const simd_t two = set1(2);
+
+    // Each lane is a different transform
+    u32 i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        simd_t x = load(&batch.orientationX[i]);
+        simd_t y = load(&batch.orientationY[i]);
+        simd_t z = load(&batch.orientationZ[i]);
+        simd_t w = load(&batch.orientationW[i]);
+
+        simd_t xx = mul(x, x), yy = mul(y, y), zz = mul(z, z);
+        simd_t xy = mul(x, y), xz = mul(x, z), yz = mul(y, z);
+        simd_t wx = mul(w, x), wy = mul(w, y), wz = mul(w, z);
+
+        // Rotation matrix, rij is row j of column i
+        simd_t r00 = sub(one, mul(two, add(yy, zz)));
+        simd_t r01 = mul(two, add(xy, wz));
+        simd_t r02 = mul(two, sub(xz, wy));
+        simd_t r10 = mul(two, sub(xy, wz));
+        simd_t r11 = sub(one, mul(two, add(xx, zz)));
+        simd_t r12 = mul(two, add(yz, wx));
+        simd_t r20 = mul(two, add(xz, wy));
+        simd_t r21 = mul(two, sub(yz, wx));
+        simd_t r22 = sub(one, mul(two, add(xx, yy)));
+
+        simd_t sx = load(&batch.scaleX[i]);
+        simd_t sy = load(&batch.scaleY[i]);
+        simd_t sz = load(&batch.scaleZ[i]);
+
+        // Model matrix columns are the rotation columns scaled, normal matrix columns are divided by the scale
+        store_column(out_model + i, 0, mul(r00, sx), mul(r01, sx), mul(r02, sx), zero);
+        store_column(out_model + i, 1, mul(r10, sy), mul(r11, sy), mul(r12, sy), zero);
+        store_column(out_model + i, 2, mul(r20, sz), mul(r21, sz), mul(r22, sz), zero);
+        store_column(out_model + i, 3, load(&batch.positionX[i]), load(&batch.positionY[i]), load(&batch.positionZ[i]),
+                     one);
+
+        store_column(out_normal + i, 0, div(r00, sx), div(r01, sx), div(r02, sx), zero);
+        store_column(out_normal + i, 1, div(r10, sy), div(r11, sy), div(r12, sy), zero);
+        store_column(out_normal + i, 2, div(r20, sz), div(r21, sz), div(r22, sz), zero);
+        store_column(out_normal + i, 3, zero, zero, zero, one);
+    }
+
+    // Leftovers that don't fill a register
+    for (; i < count; ++i) {
+        compute_transform_matrices_scalar(batch, i, out_model[i], out_normal[i]);
+    }
+}
+
+#else
+
+void compute_transform_matrices(const TransformBatch &batch, glm::mat4 *out_model, glm::mat4 *out_normal) {
+    for (u32 i = 0; i < batch.size(); ++i) {
+        compute_transform_matrices_scalar(batch, i, out_model[i], out_normal[i]);
+    }
+}
+
+#endif
+
+}
@@ -0,0 +1,62 @@
+#ifndef IVY_BATCH_TRANSFORM_H
+#define IVY_BATCH_TRANSFORM_H
+
+#include "ivy/types.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+namespace ivy {
+
+/**
+ * \brief Transform data laid out as one array per scalar so it can be processed several transforms at a time
+ */
+struct TransformBatch {
+    std::vector<f32> positionX, positionY, positionZ;
+    std::vector<f32> orientationX, orientationY, orientationZ, orientationW;
+    std::vector<f32> scaleX, scaleY, scaleZ;
+
+    /**
+     * \brief Remove all transforms from the batch, this keeps the memory
+     */
+    void clear();
+
+    /**
+     * \brief Add a transform to the end of the batch
+     * \param position Translation
+     * \param orientation Normalized rotation quaternion
+     * \param scale Scale, every component must be non-zero
+     */
+    void add(const glm::vec3 &position, const glm::quat &orientation, const glm::vec3 &scale);
+
+    /**
+     * \brief Get the number of transforms in the batch
+     * \return Number of transforms
+     */
+    [[nodiscard]] u32 size() const {
+        return (u32) positionX.size();
+    }
+};
+
+/**
+ * \brief Calculate the model matrix (T * R * S) and normal matrix (R * S^-1, the inverse transpose of the model matrix's
+ * upper 3x3) for every transform in a batch. Uses AVX2 or SSE when available, otherwise scalar code.
+ * \param batch The transforms
+ * \param out_model Array of batch.size() model matrices to write to
+ * \param out_normal Array of batch.size() normal matrices to write to
+ */
+void compute_transform_matrices(const TransformBatch &batch, glm::mat4 *out_model, glm::mat4 *out_normal);
+
+/**
+ * \brief Calculate the model and normal matrices for a single transform without any SIMD, see compute_transform_matrices
+ * \param batch The transforms
+ * \param idx The index of the transform in the batch
+ * \param out_model The model matrix to write to
+ * \param out_normal The normal matrix to write to
+ */
+void compute_transform_matrices_scalar(const TransformBatch &batch, u32 idx, glm::mat4 &out_model,
+                                       glm::mat4 &out_normal);
+
+}
+
+#endif // IVY_BATCH_TRANSFORM_H
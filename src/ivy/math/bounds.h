@@ -0,0 +1,160 @@
+#ifndef IVY_BOUNDS_H
+#define IVY_BOUNDS_H
+
+#include "ivy/types.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ivy {
+
+/**
+ * \brief Axis aligned bounding box. A default constructed box is empty and contains nothing.
+ */
+struct AABB {
+    glm::vec3 min = glm::vec3(std::numeric_limits<f32>::max());
+    glm::vec3 max = glm::vec3(std::numeric_limits<f32>::lowest());
+
+    AABB() = default;
+
+    AABB(const glm::vec3 &min, const glm::vec3 &max)
+        : min(min), max(max) {}
+
+    /**
+     * \return Whether or not the box contains at least one point
+     */
+    [[nodiscard]] bool isValid() const {
+        return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+    }
+
+    [[nodiscard]] glm::vec3 getCenter() const {
+        return (min + max) * 0.5f;
+    }
+
+    /**
+     * \brief Get the half size of the box along each axis
+     * \return Half extents
+     */
+    [[nodiscard]] glm::vec3 getExtents() const {
+        return (max - min) * 0.5f;
+    }
+
+    [[nodiscard]] f32 getSurfaceArea() const {
+        glm::vec3 size = max - min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    /**
+     * \brief Grow the box to contain a point
+     * \param point The point
+     */
+    void expand(const glm::vec3 &point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    /**
+     * \brief Grow the box to contain another box
+     * \param other The other box
+     */
+    void expand(const AABB &other) {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    /**
+     * \brief Get a copy of the box that is larger by margin on every side
+     * \param margin The distance to grow each side by
+     * \return The larger box
+     */
+    [[nodiscard]] AABB grown(f32 margin) const {
+        return AABB(min - glm::vec3(margin), max + glm::vec3(margin));
+    }
+
+    [[nodiscard]] bool contains(const AABB &other) const {
+        return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::greaterThanEqual(max, other.max));
+    }
+
+    [[nodiscard]] bool intersects(const AABB &other) const {
+        return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::greaterThanEqual(max, other.min));
+    }
+
+    /**
+     * \brief Get the squared distance from a point to the closest point in the box
+     * \param point The point
+     * \return Squared distance, 0 if the point is inside the box
+     */
+    [[nodiscard]] f32 distanceSquared(const glm::vec3 &point) const {
+        glm::vec3 d = glm::max(glm::max(min - point, point - max), glm::vec3(0));
+        return glm::dot(d, d);
+    }
+
+    /**
+     * \brief Get the bounds of the box after it has been transformed
+     * \param matrix The affine transformation
+     * \return A box that contains the transformed box
+     */
+    [[nodiscard]] AABB transformed(const glm::mat4 &matrix) const {
+        // Transform the center and project the extents onto each world axis
+        glm::vec3 center = glm::vec3(matrix * glm::vec4(getCenter(), 1.0f));
+        glm::vec3 extents = getExtents();
+        glm::vec3 worldExtents = glm::abs(glm::vec3(matrix[0])) * extents.x +
+                                 glm::abs(glm::vec3(matrix[1])) * extents.y +
+                                 glm::abs(glm::vec3(matrix[2])) * extents.z;
+
+        return AABB(center - worldExtents, center + worldExtents);
+    }
+
+    /**
+     * \brief Get the union of two boxes
+     * \param a The first box
+     * \param b The second box
+     * \return A box that contains both boxes
+     */
+    [[nodiscard]] static AABB merge(const AABB &a, const AABB &b) {
+        return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+    }
+};
+
+/**
+ * \brief Bounding sphere
+ */
+struct Sphere {
+    glm::vec3 center = glm::vec3(0);
+    f32 radius = 0.0f;
+
+    Sphere() = default;
+
+    Sphere(const glm::vec3 &center, f32 radius)
+        : center(center), radius(radius) {}
+
+    [[nodiscard]] bool intersects(const AABB &bounds) const {
+        return bounds.distanceSquared(center) <= radius * radius;
+    }
+
+    /**
+     * \brief Get the bounding box of the sphere
+     * \return Bounding box
+     */
+    [[nodiscard]] AABB getBounds() const {
+        return AABB(center - glm::vec3(radius), center + glm::vec3(radius));
+    }
+
+    /**
+     * \brief Get the bounds of the sphere after it has been transformed
+     * \param matrix The affine transformation
+     * \return A sphere that contains the transformed sphere, non-uniform scales use the largest axis
+     */
+    [[nodiscard]] Sphere transformed(const glm::mat4 &matrix) const {
+        f32 scaleSquared = std::max(std::max(glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+                                             glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1]))),
+                                    glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2])));
+
+        return Sphere(glm::vec3(matrix * glm::vec4(center, 1.0f)), radius * std::sqrt(scaleSquared));
+    }
+};
+
+}
+
+#endif // IVY_BOUNDS_H
@@ -0,0 +1,308 @@
+#include "bvh.h"
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace ivy {
+
+DynamicBVH::DynamicBVH(f32 margin)
+    : margin_(margin) {}
+
+u32 DynamicBVH::insert(const AABB &bounds, u32 user_data) {
+    u32 proxy = allocateNode();
+
+    Node &node = nodes_[proxy];
+    node.bounds = bounds.grown(margin_);
+    node.tightBounds = bounds;
+    node.userData = user_data;
+
+    insertLeaf(proxy);
+    ++numProxies_;
+
+    return proxy;
+}
+
+void DynamicBVH::remove(u32 proxy) {
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --numProxies_;
+}
+
+bool DynamicBVH::update(u32 proxy, const AABB &bounds) {
+    Node &node = nodes_[proxy];
+    node.tightBounds = bounds;
+
+    // Keep the proxy where it is while it fits in its fat box, unless the fat box has become much too large for it
+    AABB fatBounds = bounds.grown(margin_);
+    if (node.bounds.contains(bounds) && node.bounds.getSurfaceArea() <= 4.0f * fatBounds.getSurfaceArea()) {
+        return false;
+    }
+
+    removeLeaf(proxy);
+    nodes_[proxy].bounds = fatBounds;
+    insertLeaf(proxy);
+
+    return true;
+}
+
+u32 DynamicBVH::raycast(const Ray &ray, f32 max_t, f32 &out_t) const {
+    u32 closest = NULL_NODE;
+    out_t = max_t;
+    if (root_ == NULL_NODE) {
+        return closest;
+    }
+
+    std::array<u32, MAX_DEPTH> stack;
+    u32 stackSize = 0;
+    stack[stackSize++] = root_;
+
+    while (stackSize > 0) {
+        u32 idx = stack[--stackSize];
+        const Node &node = nodes_[idx];
+
+        // Anything further away than the closest hit so far can be skipped
+        f32 t;
+        if (!ray.intersects(node.bounds, out_t, t)) {
+            continue;
+        }
+
+        if (node.isLeaf()) {
+            if (ray.intersects(node.tightBounds, out_t, t) && (closest == NULL_NODE || t < out_t)) {
+                closest = idx;
+                out_t = t;
+            }
+        } else {
+            stack[stackSize++] = node.left;
+            stack[stackSize++] = node.right;
+        }
+    }
+
+    return closest;
+}
+
+void DynamicBVH::findNearest(const glm::vec3 &point, u32 k, std::vector<u32> &out_proxies, f32 max_distance) const {
+    out_proxies.clear();
+    if (root_ == NULL_NODE || k == 0) {
+        return;
+    }
+
+    // Best first search, a node's fat box is never further away than anything below it, so leaves come off the
+    // heap in order of distance
+    using Entry = std::pair<f32, u32>;
+    std::vector<Entry> heap;
+    auto push = [&](u32 idx) {
+        const Node &node = nodes_[idx];
+        heap.emplace_back((node.isLeaf() ? node.tightBounds : node.bounds).distanceSquared(point), idx);
+        std::push_heap(heap.begin(), heap.end(), std::greater<>());
+    };
+
+    f32 maxDistanceSquared = max_distance * max_distance;
+    push(root_);
+
+    while (!heap.empty() && out_proxies.size() < k) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+        Entry entry = heap.back();
+        heap.pop_back();
+
+        if (entry.first > maxDistanceSquared) {
+            break;
+        }
+
+        const Node &node = nodes_[entry.second];
+        if (node.isLeaf()) {
+            out_proxies.emplace_back(entry.second);
+        } else {
+            push(node.left);
+            push(node.right);
+        }
+    }
+}
+
+u32 DynamicBVH::allocateNode() {
+    u32 idx;
+    if (freeList_ != NULL_NODE) {
+        idx = freeList_;
+        freeList_ = nodes_[idx].parent;
+    } else {
+        idx = (u32) nodes_.size();
+        nodes_.emplace_back();
+    }
+
+    Node &node = nodes_[idx];
+    node.parent = NULL_NODE;
+    node.left = NULL_NODE;
+    node.right = NULL_NODE;
+    node.height = 0;
+    node.userData = 0;
+
+    return idx;
+}
+
+void DynamicBVH::freeNode(u32 node) {
+    nodes_[node].parent = freeList_;
+    freeList_ = node;
+}
+
+void DynamicBVH::insertLeaf(u32 leaf) {
+    if (root_ == NULL_NODE) {
+        root_ = leaf;
+        nodes_[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // Walk down to the sibling that adds the least surface area to the tree
+    const AABB leafBounds = nodes_[leaf].bounds;
+    u32 idx = root_;
+    while (!nodes_[idx].isLeaf()) {
+        const Node &node = nodes_[idx];
+
+        f32 area = node.bounds.getSurfaceArea();
+        f32 combinedArea = AABB::merge(node.bounds, leafBounds).getSurfaceArea();
+
+        // Cost of making a new parent for this node and the leaf
+        f32 cost = 2.0f * combinedArea;
+
+        // Minimum cost of pushing the leaf further down the tree
+        f32 inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto childCost = [&](u32 child_idx) {
+            const Node &child = nodes_[child_idx];
+            f32 mergedArea = AABB::merge(leafBounds, child.bounds).getSurfaceArea();
+            return (child.isLeaf() ? mergedArea : mergedArea - child.bounds.getSurfaceArea()) + inheritanceCost;
+        };
+
+        f32 costLeft = childCost(node.left);
+        f32 costRight = childCost(node.right);
+        if (cost < costLeft && cost < costRight) {
+            break;
+        }
+
+        idx = costLeft < costRight ? node.left : node.right;
+    }
+
+    // Make a new parent for the sibling and the leaf, this can reallocate nodes_
+    u32 sibling = idx;
+    u32 oldParent = nodes_[sibling].parent;
+    u32 newParent = allocateNode();
+
+    Node &parent = nodes_[newParent];
+    parent.parent = oldParent;
+    parent.bounds = AABB::merge(leafBounds, nodes_[sibling].bounds);
+    parent.height = nodes_[sibling].height + 1;
+    parent.left = sibling;
+    parent.right = leaf;
+    nodes_[sibling].parent = newParent;
+    nodes_[leaf].parent = newParent;
+
+    if (oldParent == NULL_NODE) {
+        root_ = newParent;
+    } else if (nodes_[oldParent].left == sibling) {
+        nodes_[oldParent].left = newParent;
+    } else {
+        nodes_[oldParent].right = newParent;
+    }
+
+    refitAncestors(newParent);
+}
+
+void DynamicBVH::removeLeaf(u32 leaf) {
+    if (leaf == root_) {
+        root_ = NULL_NODE;
+        return;
+    }
+
+    // The sibling takes the place of the parent
+    u32 parent = nodes_[leaf].parent;
+    u32 grandParent = nodes_[parent].parent;
+    u32 sibling = nodes_[parent].left == leaf ? nodes_[parent].right : nodes_[parent].left;
+
+    freeNode(parent);
+    nodes_[sibling].parent = grandParent;
+
+    if (grandParent == NULL_NODE) {
+        root_ = sibling;
+        return;
+    }
+
+    if (nodes_[grandParent].left == parent) {
+        nodes_[grandParent].left = sibling;
+    } else {
+        nodes_[grandParent].right = sibling;
+    }
+
+    refitAncestors(grandParent);
+}
+
+void DynamicBVH::refitAncestors(u32 node) {
+    while (node != NULL_NODE) {
+        node = balance(node);
+
+        Node &n = nodes_[node];
+        const Node &left = nodes_[n.left];
+        const Node &right = nodes_[n.right];
+        n.height = 1 + std::max(left.height, right.height);
+        n.bounds = AABB::merge(left.bounds, right.bounds);
+
+        node = n.parent;
+    }
+}
+
+u32 DynamicBVH::balance(u32 a) {
+    Node &nodeA = nodes_[a];
+    if (nodeA.isLeaf() || nodeA.height < 2) {
+        return a;
+    }
+
+    u32 b = nodeA.left;
+    u32 c = nodeA.right;
+    Node &nodeB = nodes_[b];
+    Node &nodeC = nodes_[c];
+
+    i32 heightDifference = (i32) nodeC.height - (i32) nodeB.height;
+    if (heightDifference >= -1 && heightDifference <= 1) {
+        return a;
+    }
+
+    // Rotate the taller child up into a's place, a becomes its child
+    bool rotateRight = heightDifference > 1;
+    u32 up = rotateRight ? c : b;
+    u32 other = rotateRight ? b : c;
+    Node &nodeUp = nodes_[up];
+    Node &nodeOther = nodes_[other];
+
+    nodeUp.parent = nodeA.parent;
+    nodeA.parent = up;
+    if (nodeUp.parent == NULL_NODE) {
+        root_ = up;
+    } else if (nodes_[nodeUp.parent].left == a) {
+        nodes_[nodeUp.parent].left = up;
+    } else {
+        nodes_[nodeUp.parent].right = up;
+    }
+
+    // The taller grandchild stays with the rotated node, the shorter one moves to a
+    u32 f = nodeUp.left;
+    u32 g = nodeUp.right;
+    u32 keep = nodes_[f].height > nodes_[g].height ? f : g;
+    u32 move = keep == f ? g : f;
+    Node &nodeKeep = nodes_[keep];
+    Node &nodeMove = nodes_[move];
+
+    nodeUp.left = a;
+    nodeUp.right = keep;
+    nodeMove.parent = a;
+    if (rotateRight) {
+        nodeA.right = move;
+    } else {
+        nodeA.left = move;
+    }
+
+    nodeA.bounds = AABB::merge(nodeOther.bounds, nodeMove.bounds);
+    nodeA.height = 1 + std::max(nodeOther.height, nodeMove.height);
+    nodeUp.bounds = AABB::merge(nodeA.bounds, nodeKeep.bounds);
+    nodeUp.height = 1 + std::max(nodeA.height, nodeKeep.height);
+
+    return up;
+}
+
+}
@@ -0,0 +1,184 @@
+#ifndef IVY_BVH_H
+#define IVY_BVH_H
+
+#include "ivy/types.h"
+#include "ivy/math/bounds.h"
+#include "ivy/math/frustum.h"
+#include "ivy/math/ray.h"
+#include <vector>
+
+namespace ivy {
+
+/**
+ * \brief Dynamic bounding volume hierarchy of boxes. Every box is stored in a leaf, leaves store a slightly larger "fat"
+ * box so that small movements don't change the tree. The tree is kept balanced with rotations, so queries visit
+ * O(log n) nodes plus the nodes they return.
+ */
+class DynamicBVH {
+public:
+    /**
+     * \brief Used as a proxy id and node index when nothing is referenced
+     */
+    static constexpr u32 NULL_NODE = ~0u;
+
+    /**
+     * \param margin How much larger than the inserted boxes the fat boxes are
+     */
+    explicit DynamicBVH(f32 margin = 0.1f);
+
+    /**
+     * \brief Insert a box into the tree
+     * \param bounds The box
+     * \param user_data Data that is returned with the proxy
+     * \return The proxy id
+     */
+    u32 insert(const AABB &bounds, u32 user_data);
+
+    /**
+     * \brief Remove a box from the tree
+     * \param proxy The proxy id returned by insert
+     */
+    void remove(u32 proxy);
+
+    /**
+     * \brief Change the box of a proxy, the tree is only changed if the box leaves the proxy's fat box
+     * \param proxy The proxy id
+     * \param bounds The new box
+     * \return Whether or not the proxy was moved in the tree
+     */
+    bool update(u32 proxy, const AABB &bounds);
+
+    [[nodiscard]] u32 getUserData(u32 proxy) const {
+        return nodes_[proxy].userData;
+    }
+
+    /**
+     * \brief Get the box that was inserted for a proxy
+     * \param proxy The proxy id
+     * \return The box
+     */
+    [[nodiscard]] const AABB &getBounds(u32 proxy) const {
+        return nodes_[proxy].tightBounds;
+    }
+
+    /**
+     * \brief Call fn(proxy) for every proxy whose box intersects a box
+     * \tparam Func The function type
+     * \param bounds The box
+     * \param fn The function to call
+     */
+    template <typename Func>
+    void query(const AABB &bounds, Func &&fn) const;
+
+    /**
+     * \brief Call fn(proxy) for every proxy whose box intersects a sphere
+     * \tparam Func The function type
+     * \param sphere The sphere
+     * \param fn The function to call
+     */
+    template <typename Func>
+    void query(const Sphere &sphere, Func &&fn) const;
+
+    /**
+     * \brief Call fn(proxy) for every proxy whose box might be inside of a frustum
+     * \tparam Func The function type
+     * \param frustum The frustum
+     * \param fn The function to call
+     */
+    template <typename Func>
+    void query(const Frustum &frustum, Func &&fn) const;
+
+    /**
+     * \brief Find the first box hit by a ray
+     * \param ray The ray
+     * \param max_t The maximum distance along the ray
+     * \param out_t The distance to the hit
+     * \return The proxy id of the closest box that was hit, or NULL_NODE if nothing was hit
+     */
+    u32 raycast(const Ray &ray, f32 max_t, f32 &out_t) const;
+
+    /**
+     * \brief Find the boxes closest to a point
+     * \param point The point
+     * \param k The maximum number of proxies to find
+     * \param out_proxies The proxy ids are written here, sorted from closest to furthest
+     * \param max_distance Boxes further away than this are ignored
+     */
+    void findNearest(const glm::vec3 &point, u32 k, std::vector<u32> &out_proxies,
+                     f32 max_distance = std::numeric_limits<f32>::max()) const;
+
+    /**
+     * \brief Get the number of proxies in the tree
+     * \return Number of proxies
+     */
+    [[nodiscard]] u32 size() const {
+        return numProxies_;
+    }
+
+    /**
+     * \brief Get the height of the tree, a single leaf has height 0
+     * \return Tree height
+     */
+    [[nodiscard]] u32 getHeight() const {
+        return root_ == NULL_NODE ? 0 : nodes_[root_].height;
+    }
+
+private:
+    /**
+     * \brief Call fn(proxy) for every leaf where overlaps(bounds) is true for the leaf and all of its ancestors
+     */
+    template <typename Overlap, typename Func>
+    void queryTree(Overlap &&overlaps, Func &&fn) const;
+
+    struct Node {
+        AABB bounds;      // Fat box for leaves, the union of the children for internal nodes
+        AABB tightBounds; // Box that was inserted, leaves only
+        u32 parent;       // Next free node when the node is in the free list
+        u32 left;
+        u32 right;
+        u32 height;
+        u32 userData;
+
+        [[nodiscard]] bool isLeaf() const {
+            return left == NULL_NODE;
+        }
+    };
+
+    u32 allocateNode();
+
+    void freeNode(u32 node);
+
+    void insertLeaf(u32 leaf);
+
+    void removeLeaf(u32 leaf);
+
+    /**
+     * \brief Walk from a node to the root, rebalancing and refitting every node on the way
+     * \param node The node to start at
+     */
+    void refitAncestors(u32 node);
+
+    /**
+     * \brief Rotate the tree at a node if its children's heights differ by more than one
+     * \param a The node
+     * \return The node that took a's place
+     */
+    u32 balance(u32 a);
+
+    /**
+     * \brief The deepest a query can go, the balanced tree stays far below this for any number of proxies
+     */
+    static constexpr u32 MAX_DEPTH = 128;
+
+    f32 margin_;
+    std::vector<Node> nodes_;
+    u32 root_ = NULL_NODE;
+    u32 freeList_ = NULL_NODE;
+    u32 numProxies_ = 0;
+};
+
+}
+
+#include "bvh.inl"
+
+#endif // IVY_BVH_H
@@ -0,0 +1,55 @@
+#include "bvh.h"
+#include <array>
+
+namespace ivy {
+
+template<typename Func>
+void DynamicBVH::query(const AABB &bounds, Func &&fn) const {
+    queryTree([&bounds](const AABB &node_bounds) {
+        return bounds.intersects(node_bounds);
+    }, fn);
+}
+
+template<typename Func>
+void DynamicBVH::query(const Sphere &sphere, Func &&fn) const {
+    queryTree([&sphere](const AABB &node_bounds) {
+        return sphere.intersects(node_bounds);
+    }, fn);
+}
+
+template<typename Func>
+void DynamicBVH::query(const Frustum &frustum, Func &&fn) const {
+    queryTree([&frustum](const AABB &node_bounds) {
+        return frustum.intersects(node_bounds);
+    }, fn);
+}
+
+template<typename Overlap, typename Func>
+void DynamicBVH::queryTree(Overlap &&overlaps, Func &&fn) const {
+    if (root_ == NULL_NODE) {
+        return;
+    }
+
+    // A depth first traversal never holds more than height + 1 nodes
+    std::array<u32, MAX_DEPTH> stack;
+    u32 stackSize = 0;
+    stack[stackSize++] = root_;
+
+    while (stackSize > 0) {
+        const Node &node = nodes_[stack[--stackSize]];
+        if (!overlaps(node.bounds)) {
+            continue;
+        }
+
+        if (node.isLeaf()) {
+            if (overlaps(node.tightBounds)) {
+                fn((u32) (&node - nodes_.data()));
+            }
+        } else {
+            stack[stackSize++] = node.left;
+            stack[stackSize++] = node.right;
+        }
+    }
+}
+
+}
@@ -0,0 +1,25 @@
+#include "frustum.h"
+
+namespace ivy {
+
+Frustum::Frustum(const glm::mat4 &view_projection) {
+    // Rows of the matrix, glm matrices are column major
+    glm::vec4 rows[4];
+    for (u32 i = 0; i < 4; ++i) {
+        rows[i] = glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i],
+                            view_projection[3][i]);
+    }
+
+    planes_[LEFT] = rows[3] + rows[0];
+    planes_[RIGHT] = rows[3] - rows[0];
+    planes_[BOTTOM] = rows[3] + rows[1];
+    planes_[TOP] = rows[3] - rows[1];
+    planes_[NEAR] = rows[2];
+    planes_[FAR] = rows[3] - rows[2];
+
+    for (glm::vec4 &plane : planes_) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+}
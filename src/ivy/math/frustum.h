@@ -0,0 +1,83 @@
+#ifndef IVY_FRUSTUM_H
+#define IVY_FRUSTUM_H
+
+#include "ivy/types.h"
+#include "ivy/math/bounds.h"
+#include <glm/glm.hpp>
+#include <array>
+
+namespace ivy {
+
+/**
+ * \brief The volume visible to a camera or light, stored as six inward facing planes
+ */
+class Frustum {
+public:
+    enum Plane {
+        LEFT,
+        RIGHT,
+        BOTTOM,
+        TOP,
+        NEAR,
+        FAR,
+        NUM_PLANES
+    };
+
+    /**
+     * \brief Extract the frustum planes from a view projection matrix with a depth range of 0 to 1
+     * \param view_projection The view projection matrix
+     */
+    explicit Frustum(const glm::mat4 &view_projection);
+
+    /**
+     * \brief Get a plane of the frustum
+     * \param plane The plane
+     * \return The plane as (normal, distance), points p with dot(normal, p) + distance >= 0 are on the inside
+     */
+    [[nodiscard]] const glm::vec4 &getPlane(Plane plane) const {
+        return planes_[plane];
+    }
+
+    /**
+     * \brief Check if a box is at least partially inside of the frustum, boxes near the corners of the frustum can be
+     * reported as intersecting when they are outside
+     * \param bounds The box
+     * \return Whether or not the box might be inside
+     */
+    [[nodiscard]] bool intersects(const AABB &bounds) const {
+        glm::vec3 center = bounds.getCenter();
+        glm::vec3 extents = bounds.getExtents();
+
+        for (const glm::vec4 &plane : planes_) {
+            glm::vec3 normal = glm::vec3(plane);
+            if (glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), extents) < 0.0f) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief Check if a sphere is at least partially inside of the frustum, spheres near the corners of the frustum
+     * can be reported as intersecting when they are outside
+     * \param sphere The sphere
+     * \return Whether or not the sphere might be inside
+     */
+    [[nodiscard]] bool intersects(const Sphere &sphere) const {
+        for (const glm::vec4 &plane : planes_) {
+            if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    std::array<glm::vec4, NUM_PLANES> planes_;
+};
+
+}
+
+#endif // IVY_FRUSTUM_H
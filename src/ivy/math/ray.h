@@ -0,0 +1,68 @@
+#ifndef IVY_RAY_H
+#define IVY_RAY_H
+
+#include "ivy/types.h"
+#include "ivy/math/bounds.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+
+namespace ivy {
+
+/**
+ * \brief A half line starting at an origin, the reciprocal of the direction is cached for box tests
+ */
+class Ray {
+public:
+    /**
+     * \param origin The start of the ray
+     * \param direction The direction of the ray, distances along the ray are measured in multiples of its length
+     */
+    Ray(const glm::vec3 &origin, const glm::vec3 &direction)
+        : origin_(origin), direction_(direction), inverseDirection_(1.0f / direction) {}
+
+    [[nodiscard]] const glm::vec3 &getOrigin() const {
+        return origin_;
+    }
+
+    [[nodiscard]] const glm::vec3 &getDirection() const {
+        return direction_;
+    }
+
+    /**
+     * \brief Get the point at a distance along the ray
+     * \param t The distance
+     * \return The point
+     */
+    [[nodiscard]] glm::vec3 at(f32 t) const {
+        return origin_ + direction_ * t;
+    }
+
+    /**
+     * \brief Intersect the ray with a box
+     * \param bounds The box
+     * \param max_t The maximum distance along the ray
+     * \param out_t The distance to where the ray enters the box, 0 if the origin is inside the box
+     * \return Whether or not the ray hits the box before max_t
+     */
+    bool intersects(const AABB &bounds, f32 max_t, f32 &out_t) const {
+        glm::vec3 t0 = (bounds.min - origin_) * inverseDirection_;
+        glm::vec3 t1 = (bounds.max - origin_) * inverseDirection_;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+
+        f32 enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        f32 exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, max_t));
+
+        out_t = enter;
+        return enter <= exit;
+    }
+
+private:
+    glm::vec3 origin_;
+    glm::vec3 direction_;
+    glm::vec3 inverseDirection_;
+};
+
+}
+
+#endif // IVY_RAY_H
@@ -12,6 +12,8 @@ struct Options {
     u32 renderWidth = 1280;
     u32 renderHeight = 720;
     u32 numFramesInFlight = 3;
+    u32 numWorkerThreads = 0; // 0 uses the number of hardware threads minus one
+    u32 descriptorSetEvictionFrames = 8; // Cached descriptor sets unused for longer than this can be rewritten
 
     enum class PresentModeEnum {
         IMMEDIATE, MAILBOX, FIFO
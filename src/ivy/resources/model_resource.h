@@ -3,11 +3,22 @@
 
 #include "ivy/resources/resource.h"
 #include "ivy/graphics/mesh.h"
+#include "ivy/math/bounds.h"
 #include <vector>
 
 namespace ivy {
 
-using ModelResource = Resource<std::vector<std::vector<gfx::Mesh>>>;
+/**
+ * \brief The meshes of one LOD level of a model, with bounds around all of them that are calculated once when the
+ * model is loaded
+ */
+struct ModelLod {
+    std::vector<gfx::Mesh> meshes;
+    AABB bounds;           // Model space box around every mesh, empty if there are no meshes
+    Sphere boundingSphere; // Model space sphere around every mesh
+};
+
+using ModelResource = Resource<std::vector<ModelLod>>;
 
 }
 
@@ -1,8 +1,32 @@
 #ifndef IVY_RESOURCE_H
 #define IVY_RESOURCE_H
 
+#include <memory>
+#include <string>
+
 namespace ivy {
 
+/**
+ * \brief How far along loading a resource is
+ */
+enum class ResourceState {
+    LOADING, // Being loaded in the background, a placeholder is used until it's done
+    LOADED,
+    FAILED   // Couldn't be loaded, the placeholder is used instead
+};
+
+/**
+ * \brief Where the resource manager keeps a resource, handles point at the slot so they pick up the resource once it
+ * has finished loading
+ * \tparam T Resource type
+ */
+template <typename T>
+struct ResourceSlot {
+    std::unique_ptr<T> resource; // Null until the resource is loaded
+    const T *current = nullptr;  // The resource, or a placeholder while it isn't loaded
+    ResourceState state = ResourceState::LOADING;
+};
+
 /**
  * \brief Opaque resource handle
  * \tparam T Resource type
@@ -10,17 +34,41 @@ namespace ivy {
 template <typename T>
 class Resource {
 public:
+    /**
+     * \brief Get the resource, this is a placeholder until the resource has loaded
+     * \return The resource
+     */
     const T &get() const {
-        return resource_;
+        return *slot_->current;
+    }
+
+    [[nodiscard]] ResourceState getState() const {
+        return slot_->state;
+    }
+
+    /**
+     * \return Whether or not get() returns the actual resource
+     */
+    [[nodiscard]] bool isLoaded() const {
+        return slot_->state == ResourceState::LOADED;
+    }
+
+    /**
+     * \brief Get the name the resource was requested from the resource manager with
+     * \return Resource name
+     */
+    [[nodiscard]] const std::string &getName() const {
+        return *name_;
     }
 
 private:
     friend class ResourceManager;
 
-    explicit Resource(const T &resource)
-        : resource_(resource) {}
+    Resource(const ResourceSlot<T> &slot, const std::string &name)
+        : slot_(&slot), name_(&name) {}
 
-    const T &resource_;
+    const ResourceSlot<T> *slot_;
+    const std::string *name_;
 };
 
 }
@@ -1,6 +1,11 @@
 #include "resource_manager.h"
 #include "ivy/log.h"
+#include "ivy/graphics/block_compression.h"
+#include "ivy/graphics/mipmap.h"
 #include "ivy/graphics/vertex.h"
+#include "ivy/utils/binary_sections.h"
+#include "ivy/utils/utils.h"
+#include <assimp/DefaultIOSystem.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -11,36 +16,289 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
 
 namespace ivy {
 
-ResourceManager::ResourceManager(gfx::RenderDevice &render_device, const std::string &resource_directory)
-    : device_(render_device), resourceDirectory_(resource_directory + "/") {
+constexpr u32 IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_GenUVCoords | aiProcess_GenNormals | aiProcess_FlipUVs |
+                             aiProcess_CalcTangentSpace;
+
+// How far simplification can move the surface of a LOD, relative to the size of the mesh
+constexpr f32 LOD_TARGET_ERROR = 1e-2f;
+
+/*
+ * Cooked model file layout, every section starts at a multiple of SECTION_ALIGNMENT:
+ *   ModelCacheHeader
+ *   per mesh: vertices, then the indices of each LOD
+ *   string characters
+ *   ModelCacheDependency[numDependencies], ModelCacheTexture[numTextures], ModelCacheMesh[numMeshes],
+ *   ModelCacheString[numStrings]
+ */
+
+constexpr char MODEL_CACHE_MAGIC[4] = {'I', 'V', 'Y', 'M'};
+constexpr u32 MODEL_CACHE_VERSION = 3;
+
+struct ModelCacheHeader {
+    char magic[4];
+    u32 version;
+    u64 settingsHash;
+    u32 numDependencies;
+    u32 numTextures;
+    u32 numMeshes;
+    u32 numStrings;
+    u64 dependenciesOffset;
+    u64 texturesOffset;
+    u64 meshesOffset;
+    u64 stringsOffset;
+};
+
+struct ModelCacheDependency {
+    u64 hash;
+    u32 pathIdx;
+    u32 padding;
+};
+
+struct ModelCacheTexture {
+    u32 pathIdx;
+    u32 kind;
+};
+
+struct ModelCacheLod {
+    u64 indicesOffset;
+    u32 numIndices; // Zero when the LOD is the same as the previous one
+    f32 boundsMin[3];
+    f32 boundsMax[3];
+    f32 sphereCenter[3];
+    f32 sphereRadius;
+    u32 padding;
+};
+
+struct ModelCacheMesh {
+    u64 verticesOffset;
+    u32 numVertices;
+    u32 diffuseTextureIdx;
+    u32 normalTextureIdx;
+    u32 occlusionTextureIdx;
+    u32 roughnessTextureIdx;
+    u32 metallicTextureIdx;
+    ModelCacheLod lods[ResourceManager::NUM_LOD];
+};
+
+struct ModelCacheString {
+    u64 offset;
+    u32 length;
+    u32 padding;
+};
+
+/*
+ * Cooked texture file layout, every section starts at a multiple of SECTION_ALIGNMENT:
+ *   TextureCacheHeader
+ *   per texture: every mip level, laid out as described by get_mip_chain_layout, block compressed if the header says so
+ *   TextureCacheEntry[numTextures]
+ */
+
+constexpr char TEXTURE_CACHE_MAGIC[4] = {'I', 'V', 'Y', 'T'};
+constexpr u32 TEXTURE_CACHE_VERSION = 4;
+
+struct TextureCacheHeader {
+    char magic[4];
+    u32 version;
+    u64 sourceHash;
+    u32 numTextures;
+    u32 compressed; // Textures are cooked again when the device's support for block compression changes
+    u64 texturesOffset;
+};
+
+struct TextureCacheEntry {
+    u64 dataOffset;
+    u64 dataSize;
+    u32 width;
+    u32 height;
+    u32 mipLevels;
+    u32 format;
+    char nameSuffix[8]; // Null terminated, appended to the texture path to get the texture name
+};
+
+/**
+ * \brief Assimp file system that keeps track of the files that are read, a model can be made of more than one file
+ */
+class RecordingIOSystem : public Assimp::DefaultIOSystem {
+public:
+    explicit RecordingIOSystem(std::vector<std::string> &opened_files)
+        : openedFiles_(opened_files) {}
+
+    Assimp::IOStream *Open(const char *file, const char *mode) override {
+        Assimp::IOStream *stream = DefaultIOSystem::Open(file, mode);
+        if (stream && std::find(openedFiles_.begin(), openedFiles_.end(), file) == openedFiles_.end()) {
+            openedFiles_.emplace_back(file);
+        }
+
+        return stream;
+    }
+
+private:
+    std::vector<std::string> &openedFiles_;
+};
+
+/**
+ * \brief Write a file to the cache directory. It's written to a temporary file first so that a half written file is
+ * never read.
+ * \param path The path of the file
+ * \param data The contents of the file
+ */
+static void write_cache_file(const std::string &path, const std::vector<u8> &data) {
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!stream.write(reinterpret_cast<const char *>(data.data()), (std::streamsize) data.size())) {
+            Log::warn("Failed to write cache file '%'", path);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        Log::warn("Failed to write cache file '%': %", path, error.message());
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
+
+/**
+ * \brief Get the name of a texture resource, textures of different kinds are processed differently so they can't
+ * share a name even if they are read from the same file. Split channels are a color texture with extra textures.
+ * \param texture_path The path to the texture relative to the resource directory
+ * \param kind How the texture is used
+ * \return The name, it starts with texture_path
+ */
+static std::string get_texture_name(const std::string &texture_path, ResourceManager::TextureKind kind) {
+    return kind == ResourceManager::TextureKind::NORMAL_MAP ? texture_path + "*normal" : texture_path;
+}
+
+/**
+ * \brief Get a hash of everything that affects how models are processed, cooked models that were made with different
+ * settings are ignored
+ * \return The hash
+ */
+static u64 get_import_settings_hash() {
+    const u32 settings[] = {
+        IMPORT_FLAGS, ResourceManager::NUM_LOD, (u32) sizeof(gfx::VertexP3N3T3B3UV2), (u32) sizeof(ModelCacheMesh)
+    };
+
+    u64 hash = hash_bytes(settings, sizeof(settings));
+    return hash_bytes(&LOD_TARGET_ERROR, sizeof(LOD_TARGET_ERROR), hash);
+}
+
+/**
+ * \brief Check if a format is one that textures are cooked to
+ * \param format The format
+ * \return Whether or not cooked textures can have the format
+ */
+static bool is_cooked_texture_format(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * \brief Calculate the bounds of the vertices that are referenced by an index buffer
+ * \param positions The vertex positions
+ * \param indices The indices
+ * \param out_bounds The bounding box is written here
+ * \param out_sphere The bounding sphere is written here, it is centered on the bounding box
+ */
+static void calculate_bounds(const std::vector<gfx::VertexP3> &positions, const std::vector<u32> &indices,
+                             AABB &out_bounds, Sphere &out_sphere) {
+    out_bounds = AABB();
+    for (u32 index : indices) {
+        out_bounds.expand(positions[index].position);
+    }
+
+    f32 radiusSquared = 0.0f;
+    glm::vec3 center = out_bounds.getCenter();
+    for (u32 index : indices) {
+        glm::vec3 d = positions[index].position - center;
+        radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+    }
+
+    out_sphere = Sphere(center, std::sqrt(radiusSquared));
+}
+
+/**
+ * \brief Calculate the bounds around every mesh in a LOD level of a model
+ * \param lod The LOD level, its bounds are written to
+ */
+static void calculate_lod_bounds(ModelLod &lod) {
+    lod.bounds = AABB();
+    for (const gfx::Mesh &mesh : lod.meshes) {
+        lod.bounds.expand(mesh.getBounds());
+    }
+
+    // Enclose the mesh spheres, but never be larger than the sphere around the box
+    glm::vec3 center = lod.bounds.getCenter();
+    f32 radius = 0.0f;
+    for (const gfx::Mesh &mesh : lod.meshes) {
+        const Sphere &sphere = mesh.getBoundingSphere();
+        radius = std::max(radius, glm::length(sphere.center - center) + sphere.radius);
+    }
+
+    lod.boundingSphere = Sphere(center, std::min(radius, glm::length(lod.bounds.getExtents())));
+}
+
+ResourceManager::ResourceManager(gfx::RenderDevice &render_device, ThreadPool &thread_pool,
+                                 const std::string &resource_directory)
+    : device_(render_device), threadPool_(thread_pool), resourceDirectory_(resource_directory + "/"),
+      cacheDirectory_(resourceDirectory_ + ".cache/"),
+      compressTextures_(render_device.isBlockCompressionSupported()) {
     if (!std::filesystem::is_directory(resourceDirectory_)) {
         Log::fatal("Invalid resource directory: '%'", resourceDirectory_);
     }
 
+    // Processed models are kept here so that they don't have to be imported again on the next run
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory_, error);
+    if (error) {
+        Log::warn("Failed to create cache directory '%': %", cacheDirectory_, error.message());
+    }
+
+    if (!compressTextures_) {
+        Log::info("Block compressed textures aren't supported, textures will be uncompressed");
+    }
+
     // Load default textures
     {
         u8 pixels[] = {255, 255, 255, 255};
-        loadTexture("*white", 1, 1, VK_FORMAT_R8G8B8A8_UNORM, pixels, sizeof(pixels));
-        textureWhite_ = textures_.find("*white")->second.get();
+        loadTexture("*white", 1, 1, 1, VK_FORMAT_R8G8B8A8_UNORM, pixels, sizeof(pixels));
+        textureWhite_ = textures_.find("*white")->second.resource.get();
     }
     {
         u8 pixels[] = {0, 0, 0, 255};
-        loadTexture("*blackOpaque", 1, 1, VK_FORMAT_R8G8B8A8_UNORM, pixels, sizeof(pixels));
-        textureBlackOpaque_ = textures_.find("*blackOpaque")->second.get();
+        loadTexture("*blackOpaque", 1, 1, 1, VK_FORMAT_R8G8B8A8_UNORM, pixels, sizeof(pixels));
+        textureBlackOpaque_ = textures_.find("*blackOpaque")->second.resource.get();
     }
     {
         u8 pixels[] = {0, 0, 0, 0};
-        loadTexture("*blackTransparent", 1, 1, VK_FORMAT_R8G8B8A8_UNORM, pixels, sizeof(pixels));
-        textureBlackTransparent_ = textures_.find("*blackTransparent")->second.get();
+        loadTexture("*blackTransparent", 1, 1, 1, VK_FORMAT_R8G8B8A8_UNORM, pixels, sizeof(pixels));
+        textureBlackTransparent_ = textures_.find("*blackTransparent")->second.resource.get();
     }
     {
         u8 pixels[] = {127, 127, 255, 255};
-        loadTexture("*normal", 1, 1, VK_FORMAT_R8G8B8A8_UNORM, pixels, sizeof(pixels));
-        textureNormal_ = textures_.find("*normal")->second.get();
+        loadTexture("*normal", 1, 1, 1, VK_FORMAT_R8G8B8A8_UNORM, pixels, sizeof(pixels));
+        textureNormal_ = textures_.find("*normal")->second.resource.get();
     }
     {
         u8 pixels[] = {255, 0, 255, 255,
@@ -48,39 +306,170 @@ ResourceManager::ResourceManager(gfx::RenderDevice &render_device, const std::st
                        0, 0, 0, 255,
                        255, 0, 255, 255
                       };
-        loadTexture("*missing", 2, 2, VK_FORMAT_R8G8B8A8_UNORM, pixels, sizeof(pixels));
-        textureMissing_ = textures_.find("*missing")->second.get();
+        loadTexture("*missing", 2, 2, 1, VK_FORMAT_R8G8B8A8_UNORM, pixels, sizeof(pixels));
+        textureMissing_ = textures_.find("*missing")->second.resource.get();
+    }
+}
+
+ResourceManager::~ResourceManager() {
+    // The tasks write into the pending loads, so they have to be done before those are freed
+    for (std::unique_ptr<PendingLoad> &load : pendingLoads_) {
+        threadPool_.wait(load->group);
     }
 }
 
 ModelResource ResourceManager::getModel(const std::string &model_name) {
+    ModelResource model = getModelAsync(model_name);
+    waitForLoad(model_name);
+
+    if (model.getState() == ResourceState::FAILED) {
+        Log::fatal("Failed to get model '%'", model_name);
+    }
+
+    return model;
+}
+
+ModelResource ResourceManager::getModelAsync(const std::string &model_name) {
     auto it = modelMeshes_.find(model_name);
     if (it == modelMeshes_.end()) {
-        if (!loadModelFromFile(model_name)) {
-            Log::fatal("Failed to get model '%'", model_name);
-        }
-
+        startLoad(model_name, model_name, true);
         it = modelMeshes_.find(model_name);
     }
 
-    return ModelResource(*it->second);
+    return ModelResource(it->second, it->first);
+}
+
+TextureResource ResourceManager::getTexture(const std::string &texture_name, TextureKind kind) {
+    TextureResource texture = getTextureAsync(texture_name, kind);
+    waitForLoad(get_texture_name(texture_name, kind));
+
+    if (texture.getState() == ResourceState::FAILED) {
+        Log::warn("Failed to get texture '%'", texture_name);
+    }
+
+    return texture;
 }
 
-TextureResource ResourceManager::getTexture(const std::string &texture_name) {
-    auto it = textures_.find(texture_name);
+TextureResource ResourceManager::getTextureAsync(const std::string &texture_name, TextureKind kind) {
+    std::string name = get_texture_name(texture_name, kind);
+    auto it = textures_.find(name);
     if (it == textures_.end()) {
-        if (!loadTextureFromFile(texture_name)) {
-            Log::warn("Failed to get texture '%'", texture_name);
-            return TextureResource(*textureMissing_);
+        startLoad(name, texture_name, false, kind);
+        it = textures_.find(name);
+    }
+
+    return TextureResource(it->second, it->first);
+}
+
+void ResourceManager::update() {
+    // Finish loads in the order they were started, later loads can depend on textures from earlier ones
+    auto it = pendingLoads_.begin();
+    while (it != pendingLoads_.end()) {
+        if ((*it)->group.isDone()) {
+            finishLoad(**it);
+            it = pendingLoads_.erase(it);
+        } else {
+            ++it;
         }
+    }
+}
 
-        it = textures_.find(texture_name);
+void ResourceManager::startLoad(const std::string &name, const std::string &path, bool is_model,
+                                TextureKind texture_kind) {
+    if (is_model) {
+        ResourceSlot<ModelMeshes> &slot = modelMeshes_[name];
+        slot.current = &emptyModel_;
+    } else {
+        ResourceSlot<gfx::Texture> &slot = textures_[name];
+        slot.current = textureMissing_;
     }
 
-    return TextureResource(*it->second);
+    pendingLoads_.emplace_back(std::make_unique<PendingLoad>());
+    PendingLoad *load = pendingLoads_.back().get();
+    load->name = name;
+    load->path = path;
+    load->isModel = is_model;
+    load->textureKind = texture_kind;
+
+    // Only file reading and processing happens on the pool, GPU resources are created in finishLoad
+    threadPool_.submit(load->group, [this, load]() {
+        if (load->isModel) {
+            load->success = readCachedModel(load->path, load->cacheFile, load->meshes, load->textures) ||
+                            readModel(load->path, load->meshes, load->textures);
+        } else {
+            load->success = readTexture(load->path, load->textureKind, load->textures);
+        }
+    });
 }
 
-bool ResourceManager::loadModelFromFile(const std::string &model_path) {
+void ResourceManager::waitForLoad(const std::string &name) {
+    for (auto it = pendingLoads_.begin(); it != pendingLoads_.end(); ++it) {
+        if ((*it)->name == name) {
+            threadPool_.wait((*it)->group);
+            finishLoad(**it);
+            pendingLoads_.erase(it);
+            return;
+        }
+    }
+}
+
+void ResourceManager::finishLoad(PendingLoad &load) {
+    // Upload textures first, model materials reference them
+    for (const TextureData &texture : load.textures) {
+        loadTexture(texture.name, texture.width, texture.height, texture.mipLevels, texture.format,
+                    texture.pixels.data(), texture.pixels.size());
+    }
+
+    if (!load.isModel) {
+        ResourceSlot<gfx::Texture> &slot = textures_.at(load.name);
+        if (!load.success && slot.state == ResourceState::LOADING) {
+            slot.state = ResourceState::FAILED;
+        }
+        return;
+    }
+
+    ResourceSlot<ModelMeshes> &slot = modelMeshes_.at(load.name);
+    if (!load.success) {
+        slot.state = ResourceState::FAILED;
+        return;
+    }
+
+    auto lodMeshes = std::make_unique<ModelMeshes>(NUM_LOD);
+    for (const MeshData &mesh : load.meshes) {
+        gfx::Material material(findTexture(mesh.diffuseTexture, *textureWhite_),
+                               findTexture(mesh.normalTexture, *textureNormal_),
+                               findTexture(mesh.occlusionTexture, *textureWhite_),
+                               findTexture(mesh.roughnessTexture, *textureWhite_),
+                               findTexture(mesh.metallicTexture, *textureBlackTransparent_));
+
+        // Save optimized mesh
+        (*lodMeshes)[0].meshes.emplace_back(gfx::Geometry(device_, mesh.vertices, mesh.lodIndices[0]), material,
+                                            mesh.lodBounds[0], mesh.lodBoundingSpheres[0]);
+
+        for (u32 i = 1; i < NUM_LOD; ++i) {
+            if (mesh.lodIndices[i].empty()) {
+                // Re-use mesh from previous LOD
+                (*lodMeshes)[i].meshes.emplace_back((*lodMeshes)[i - 1].meshes.back());
+            } else {
+                // Create new mesh but reuse vertex buffer from LOD0, we're just changing indices
+                const gfx::Geometry &lod0 = (*lodMeshes)[0].meshes.back().getGeometry();
+                (*lodMeshes)[i].meshes.emplace_back(gfx::Geometry(device_, lod0, mesh.lodIndices[i]), material,
+                                                    mesh.lodBounds[i], mesh.lodBoundingSpheres[i]);
+            }
+        }
+    }
+
+    for (ModelLod &lod : *lodMeshes) {
+        calculate_lod_bounds(lod);
+    }
+
+    slot.resource = std::move(lodMeshes);
+    slot.current = slot.resource.get();
+    slot.state = ResourceState::LOADED;
+}
+
+bool ResourceManager::readModel(const std::string &model_path, std::vector<MeshData> &out_meshes,
+                                std::vector<TextureData> &out_textures) const {
     std::filesystem::path filePath = std::filesystem::path(resourceDirectory_ + model_path).lexically_normal();
     std::string relativeDirectory = std::filesystem::path(model_path).parent_path().string() + "/";
 
@@ -89,196 +478,508 @@ bool ResourceManager::loadModelFromFile(const std::string &model_path) {
         return false;
     }
 
-    if (modelMeshes_.find(model_path) != modelMeshes_.end()) {
-        Log::warn("Tried to load already loaded resource: '%'", model_path);
-        return false;
-    }
-
-    std::vector<std::vector<gfx::Mesh>> lodMeshes(NUM_LOD);
-
+    // The importer owns the file system and deletes it
+    std::vector<std::string> dependencies;
     Assimp::Importer importer;
-    const aiScene *scene = importer.ReadFile(filePath.generic_string().c_str(),
-                                             aiProcess_Triangulate | aiProcess_GenUVCoords |
-                                             aiProcess_GenNormals | aiProcess_FlipUVs |
-                                             aiProcess_CalcTangentSpace);
+    importer.SetIOHandler(new RecordingIOSystem(dependencies));
+
+    const aiScene *scene = importer.ReadFile(filePath.generic_string().c_str(), IMPORT_FLAGS);
     if (!scene) {
         Log::warn("Failed to read resource %: %", filePath, importer.GetErrorString());
         return false;
     }
 
-    // Process meshes
-    for (u32 m = 0; m < scene->mNumMeshes; ++m) {
-        std::vector<gfx::VertexP3N3T3B3UV2> vertices;
-        std::vector<u32> indices;
-
-        aiMesh *mesh = scene->mMeshes[m];
-
-        // Process vertices
-        vertices.reserve(mesh->mNumVertices);
-        for (u32 v = 0; v < mesh->mNumVertices; ++v) {
-            vertices.emplace_back();
-            gfx::VertexP3N3T3B3UV2 &vert = vertices.back();
-            vert.position = glm::vec3(
-                                mesh->mVertices[v].x,
-                                mesh->mVertices[v].y,
-                                mesh->mVertices[v].z
-                            );
-
-            vert.normal = glm::vec3(
-                              mesh->mNormals[v].x,
-                              mesh->mNormals[v].y,
-                              mesh->mNormals[v].z
-                          );
-
-            vert.tangent = glm::vec3(
-                               mesh->mTangents[v].x,
-                               mesh->mTangents[v].y,
-                               mesh->mTangents[v].z
-                           );
-
-            vert.bitangent = glm::vec3(
-                                 mesh->mBitangents[v].x,
-                                 mesh->mBitangents[v].y,
-                                 mesh->mBitangents[v].z
-                             );
-
-            vert.uv = glm::vec2(
-                          mesh->mTextureCoords[0][v].x,
-                          mesh->mTextureCoords[0][v].y
-                      );
+    // Each texture the model uses is only decoded once, useTexture returns the texture name
+    std::vector<ModelTexture> textures;
+    std::unordered_set<std::string> usedTextures;
+    auto useTexture = [&](const std::string &texture_path, TextureKind kind) {
+        if (usedTextures.insert(texture_path + "*" + std::to_string((u32) kind)).second) {
+            textures.push_back({texture_path, kind});
         }
+        return get_texture_name(texture_path, kind);
+    };
 
-        // Process indices
-        indices.reserve(mesh->mNumFaces * 3);
-        for (u32 f = 0; f < mesh->mNumFaces; ++f) {
-            aiFace face = mesh->mFaces[f];
-            for (u32 i = 0; i < face.mNumIndices; ++i) {
-                indices.emplace_back(face.mIndices[i]);
-            }
-        }
+    // Find the textures of each mesh, this is cheap so it's done before anything is fanned out
+    out_meshes.resize(scene->mNumMeshes);
+    for (u32 m = 0; m < scene->mNumMeshes; ++m) {
+        aiMesh *mesh = scene->mMeshes[m];
+        MeshData &meshData = out_meshes[m];
 
         // Get material for this mesh
         aiMaterial *aiMat = scene->mMaterials[mesh->mMaterialIndex];
 
         // Diffuse
-        const gfx::Texture *diffuseTexture = textureWhite_;
         if (aiMat->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
             aiString texPath;
             aiMat->GetTexture(aiTextureType_DIFFUSE, 0, &texPath);
-            diffuseTexture = &getTexture(relativeDirectory + texPath.C_Str()).get();
+            meshData.diffuseTexture = useTexture(relativeDirectory + texPath.C_Str(), TextureKind::COLOR);
         }
 
         // Normal
-        const gfx::Texture *normalTexture = textureNormal_;
         if (aiMat->GetTextureCount(aiTextureType_NORMALS) > 0) {
             aiString texPath;
             aiMat->GetTexture(aiTextureType_NORMALS, 0, &texPath);
-            normalTexture = &getTexture(relativeDirectory + texPath.C_Str()).get();
+            meshData.normalTexture = useTexture(relativeDirectory + texPath.C_Str(), TextureKind::NORMAL_MAP);
         }
 
         // Ambient occlusion
-        const gfx::Texture *occlusionTexture = textureWhite_;
         if (aiMat->GetTextureCount(aiTextureType_AMBIENT_OCCLUSION) > 0) {
             aiString texPath;
             aiMat->GetTexture(aiTextureType_AMBIENT_OCCLUSION, 0, &texPath);
-            occlusionTexture = &getTexture(relativeDirectory + texPath.C_Str()).get();
+            meshData.occlusionTexture = useTexture(relativeDirectory + texPath.C_Str(), TextureKind::COLOR);
         }
 
         // Roughness
-        const gfx::Texture *roughnessTexture = textureWhite_;
         if (aiMat->GetTextureCount(aiTextureType_DIFFUSE_ROUGHNESS) > 0) {
             aiString texPath;
             aiMat->GetTexture(aiTextureType_DIFFUSE_ROUGHNESS, 0, &texPath);
-            roughnessTexture = &getTexture(relativeDirectory + texPath.C_Str()).get();
+            meshData.roughnessTexture = useTexture(relativeDirectory + texPath.C_Str(), TextureKind::COLOR);
         }
 
         // Metal
-        const gfx::Texture *metallicTexture = textureBlackTransparent_;
         if (aiMat->GetTextureCount(aiTextureType_METALNESS) > 0) {
             aiString texPath;
             aiMat->GetTexture(aiTextureType_METALNESS, 0, &texPath);
-            metallicTexture = &getTexture(relativeDirectory + texPath.C_Str()).get();
+            meshData.metallicTexture = useTexture(relativeDirectory + texPath.C_Str(), TextureKind::COLOR);
         }
 
         // If ao, roughness, and metallic are in same texture
         aiString texPath;
         if (aiMat->GetTexture(AI_MATKEY_GLTF_PBRMETALLICROUGHNESS_METALLICROUGHNESS_TEXTURE, &texPath) == aiReturn_SUCCESS) {
-            loadTextureFromFile(relativeDirectory + texPath.C_Str(), true);
+            std::string name = useTexture(relativeDirectory + texPath.C_Str(), TextureKind::SPLIT_CHANNELS);
 
             // Guess what channels hold what data
-            occlusionTexture = &getTexture(relativeDirectory + texPath.C_Str() + "_r").get();
-            roughnessTexture = &getTexture(relativeDirectory + texPath.C_Str() + "_g").get();
-            metallicTexture = &getTexture(relativeDirectory + texPath.C_Str() + "_b").get();
+            meshData.occlusionTexture = name + "_r";
+            meshData.roughnessTexture = name + "_g";
+            meshData.metallicTexture = name + "_b";
         }
+    }
 
-        // Optimize mesh
-        std::vector<u32> remap(indices.size());
-        meshopt_generateVertexRemap(remap.data(), indices.data(), indices.size(), vertices.data(), vertices.size(),
-                                    sizeof(vertices[0]));
+    // Texture decodes, meshes and each LOD of each mesh are separate tasks. This usually runs on a worker already,
+    // which runs other tasks while it waits for the group.
+    TaskGroup group;
 
-        std::vector<u32> optimizedIndices(indices.size());
-        meshopt_remapIndexBuffer(optimizedIndices.data(), indices.data(), indices.size(), remap.data());
+    std::vector<std::vector<TextureData>> decodedTextures;
+    decodeTextures(textures, group, decodedTextures);
 
-        std::vector<gfx::VertexP3N3T3B3UV2> optimizedVertices(vertices.size());
-        meshopt_remapVertexBuffer(optimizedVertices.data(), vertices.data(), vertices.size(), sizeof(vertices[0]),
-                                  remap.data());
+    // Positions only, used for bounds and simplification. They have to outlive the LOD tasks.
+    std::vector<std::vector<gfx::VertexP3>> meshPositions(scene->mNumMeshes);
 
-        // Save optimized mesh
-        lodMeshes[0].emplace_back(
-            gfx::Geometry(device_, optimizedVertices, optimizedIndices),
-            gfx::Material(*diffuseTexture, *normalTexture, *occlusionTexture, *roughnessTexture, *metallicTexture)
-        );
-
-        // Generate LODs
-        std::vector<gfx::VertexP3> vertexPositions(optimizedVertices.size());
-        for (u32 i = 0; i < optimizedVertices.size(); ++i) {
-            vertexPositions[i].position = optimizedVertices[i].position;
-        }
+    for (u32 m = 0; m < scene->mNumMeshes; ++m) {
+        threadPool_.submit(group, [&, m]() {
+            std::vector<gfx::VertexP3N3T3B3UV2> vertices;
+            std::vector<u32> indices;
+            MeshData &meshData = out_meshes[m];
 
-        u32 lastIndexCount = optimizedIndices.size();
-        for (u32 i = 1; i < NUM_LOD; ++i) {
-            // Half the number of indices each lod level
-            u32 targetIndices = (u32)((f32)optimizedIndices.size() * std::pow(0.5f, i));
-            f32 targetError = 1e-2f;
+            aiMesh *mesh = scene->mMeshes[m];
+
+            // Process vertices
+            vertices.reserve(mesh->mNumVertices);
+            for (u32 v = 0; v < mesh->mNumVertices; ++v) {
+                vertices.emplace_back();
+                gfx::VertexP3N3T3B3UV2 &vert = vertices.back();
+                vert.position = glm::vec3(
+                                    mesh->mVertices[v].x,
+                                    mesh->mVertices[v].y,
+                                    mesh->mVertices[v].z
+                                );
+
+                vert.normal = glm::vec3(
+                                  mesh->mNormals[v].x,
+                                  mesh->mNormals[v].y,
+                                  mesh->mNormals[v].z
+                              );
+
+                vert.tangent = glm::vec3(
+                                   mesh->mTangents[v].x,
+                                   mesh->mTangents[v].y,
+                                   mesh->mTangents[v].z
+                               );
+
+                vert.bitangent = glm::vec3(
+                                     mesh->mBitangents[v].x,
+                                     mesh->mBitangents[v].y,
+                                     mesh->mBitangents[v].z
+                                 );
+
+                vert.uv = glm::vec2(
+                              mesh->mTextureCoords[0][v].x,
+                              mesh->mTextureCoords[0][v].y
+                          );
+            }
+
+            // Process indices
+            indices.reserve(mesh->mNumFaces * 3);
+            for (u32 f = 0; f < mesh->mNumFaces; ++f) {
+                aiFace face = mesh->mFaces[f];
+                for (u32 i = 0; i < face.mNumIndices; ++i) {
+                    indices.emplace_back(face.mIndices[i]);
+                }
+            }
+
+            // Optimize mesh
+            std::vector<u32> remap(indices.size());
+            meshopt_generateVertexRemap(remap.data(), indices.data(), indices.size(), vertices.data(), vertices.size(),
+                                        sizeof(vertices[0]));
 
-            std::vector<u32> lodIndices(optimizedIndices.size());
-            lodIndices.resize(meshopt_simplify(lodIndices.data(), optimizedIndices.data(), optimizedIndices.size(),
-                                               &vertexPositions[0].position.x, vertexPositions.size(), sizeof(vertexPositions[0]),
-                                               targetIndices, targetError));
+            std::vector<u32> &optimizedIndices = meshData.lodIndexStorage[0];
+            optimizedIndices.resize(indices.size());
+            meshopt_remapIndexBuffer(optimizedIndices.data(), indices.data(), indices.size(), remap.data());
 
+            std::vector<gfx::VertexP3N3T3B3UV2> &optimizedVertices = meshData.vertexStorage;
+            optimizedVertices.resize(vertices.size());
+            meshopt_remapVertexBuffer(optimizedVertices.data(), vertices.data(), vertices.size(), sizeof(vertices[0]),
+                                      remap.data());
+
+            std::vector<gfx::VertexP3> &vertexPositions = meshPositions[m];
+            vertexPositions.resize(optimizedVertices.size());
+            for (u32 i = 0; i < optimizedVertices.size(); ++i) {
+                vertexPositions[i].position = optimizedVertices[i].position;
+            }
+
+            calculate_bounds(vertexPositions, optimizedIndices, meshData.lodBounds[0],
+                             meshData.lodBoundingSpheres[0]);
+
+            // Generate LODs, each one is simplified from LOD0 so they don't depend on each other
+            for (u32 i = 1; i < NUM_LOD; ++i) {
+                threadPool_.submit(group, [&, m, i]() {
+                    MeshData &lodMeshData = out_meshes[m];
+                    const std::vector<u32> &lod0Indices = lodMeshData.lodIndexStorage[0];
+                    const std::vector<gfx::VertexP3> &positions = meshPositions[m];
+
+                    // Half the number of indices each lod level
+                    u32 targetIndices = (u32)((f32)lod0Indices.size() * std::pow(0.5f, i));
+
+                    std::vector<u32> &lodIndices = lodMeshData.lodIndexStorage[i];
+                    lodIndices.resize(lod0Indices.size());
+                    lodIndices.resize(meshopt_simplify(lodIndices.data(), lod0Indices.data(), lod0Indices.size(),
+                                                       &positions[0].position.x, positions.size(), sizeof(positions[0]),
+                                                       targetIndices, LOD_TARGET_ERROR));
+
+                    // Simplification can drop vertices on the edges of the mesh, so each LOD gets its own bounds
+                    calculate_bounds(positions, lodIndices, lodMeshData.lodBounds[i],
+                                     lodMeshData.lodBoundingSpheres[i]);
+                });
+            }
+        });
+    }
+
+    threadPool_.wait(group);
+
+    // LODs that didn't simplify any further re-use the mesh from the previous LOD, marked by empty indices
+    for (MeshData &meshData : out_meshes) {
+        u32 lastIndexCount = meshData.lodIndexStorage[0].size();
+        for (u32 i = 1; i < NUM_LOD; ++i) {
+            std::vector<u32> &lodIndices = meshData.lodIndexStorage[i];
             if (lodIndices.size() == lastIndexCount || lodIndices.empty()) {
-                // Re-use mesh from previous LOD
-                lodMeshes[i].emplace_back(lodMeshes[i - 1].back());
+                lodIndices.clear();
+                meshData.lodBounds[i] = meshData.lodBounds[i - 1];
+                meshData.lodBoundingSpheres[i] = meshData.lodBoundingSpheres[i - 1];
             } else {
-                // Create new mesh but reuse vertex buffer from LOD0, we're just changing indices
-                lodMeshes[i].emplace_back(gfx::Geometry(device_, lodMeshes[0].back().getGeometry(), lodIndices),
-                                          gfx::Material(*diffuseTexture, *normalTexture, *occlusionTexture, *roughnessTexture, *metallicTexture));
+                lastIndexCount = lodIndices.size();
             }
+        }
 
-            lastIndexCount = lodIndices.size();
+        meshData.vertices = Span<const gfx::VertexP3N3T3B3UV2>(meshData.vertexStorage.data(),
+                                                               meshData.vertexStorage.size());
+        for (u32 i = 0; i < NUM_LOD; ++i) {
+            meshData.lodIndices[i] = Span<const u32>(meshData.lodIndexStorage[i].data(),
+                                                     meshData.lodIndexStorage[i].size());
         }
     }
 
-    modelMeshes_.emplace(model_path, std::make_unique<std::vector<std::vector<gfx::Mesh>>>(lodMeshes));
+    writeCachedModel(model_path, dependencies, out_meshes, textures);
+
+    for (std::vector<TextureData> &decoded : decodedTextures) {
+        std::move(decoded.begin(), decoded.end(), std::back_inserter(out_textures));
+    }
+
     return true;
 }
 
-bool ResourceManager::loadTextureFromFile(const std::string &texture_path, bool split_channels) {
+bool ResourceManager::readCachedModel(const std::string &model_path, MappedFile &out_cache_file,
+                                      std::vector<MeshData> &out_meshes, std::vector<TextureData> &out_textures) const {
+    MappedFile &file = out_cache_file;
+    if (!file.open(getCachePath(model_path, ".mesh"))) {
+        return false;
+    }
+
+    const auto *header = get_section<ModelCacheHeader>(file, 0, 1);
+    if (!header || std::memcmp(header->magic, MODEL_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != MODEL_CACHE_VERSION || header->settingsHash != get_import_settings_hash()) {
+        Log::debug("Cooked model for '%' is out of date", model_path);
+        file.close();
+        return false;
+    }
+
+    const auto *dependencies = get_section<ModelCacheDependency>(file, header->dependenciesOffset,
+                                                                 header->numDependencies);
+    const auto *textures = get_section<ModelCacheTexture>(file, header->texturesOffset, header->numTextures);
+    const auto *meshes = get_section<ModelCacheMesh>(file, header->meshesOffset, header->numMeshes);
+    const auto *cacheStrings = get_section<ModelCacheString>(file, header->stringsOffset, header->numStrings);
+    if (!dependencies || !textures || !meshes || !cacheStrings) {
+        Log::warn("Cooked model for '%' is truncated", model_path);
+        file.close();
+        return false;
+    }
+
+    std::vector<std::string> strings;
+    strings.reserve(header->numStrings);
+    for (u32 i = 0; i < header->numStrings; ++i) {
+        if (!get_section<char>(file, cacheStrings[i].offset, cacheStrings[i].length)) {
+            Log::warn("Cooked model for '%' is truncated", model_path);
+            file.close();
+            return false;
+        }
+
+        strings.emplace_back(reinterpret_cast<const char *>(file.getData() + cacheStrings[i].offset),
+                             cacheStrings[i].length);
+    }
+
+    auto getString = [&](u32 idx, std::string &out_string) {
+        if (idx >= strings.size()) {
+            return false;
+        }
+
+        out_string = strings[idx];
+        return true;
+    };
+
+    // The model has to be imported again if any of the files it was made from has changed
+    for (u32 i = 0; i < header->numDependencies; ++i) {
+        std::string path;
+        u64 hash;
+        if (!getString(dependencies[i].pathIdx, path) || !hash_file(path, hash) || hash != dependencies[i].hash) {
+            Log::debug("Cooked model for '%' is out of date", model_path);
+            file.close();
+            return false;
+        }
+    }
+
+    std::vector<ModelTexture> modelTextures(header->numTextures);
+    for (u32 i = 0; i < header->numTextures; ++i) {
+        modelTextures[i].kind = (TextureKind) textures[i].kind;
+        if (textures[i].kind > (u32) TextureKind::SPLIT_CHANNELS ||
+            !getString(textures[i].pathIdx, modelTextures[i].path)) {
+            Log::warn("Cooked model for '%' is invalid", model_path);
+            file.close();
+            return false;
+        }
+    }
+
+    out_meshes.resize(header->numMeshes);
+    for (u32 m = 0; m < header->numMeshes; ++m) {
+        const ModelCacheMesh &cacheMesh = meshes[m];
+        MeshData &meshData = out_meshes[m];
+
+        const auto *vertices = get_section<gfx::VertexP3N3T3B3UV2>(file, cacheMesh.verticesOffset,
+                                                                  cacheMesh.numVertices);
+        bool valid = vertices != nullptr &&
+                     getString(cacheMesh.diffuseTextureIdx, meshData.diffuseTexture) &&
+                     getString(cacheMesh.normalTextureIdx, meshData.normalTexture) &&
+                     getString(cacheMesh.occlusionTextureIdx, meshData.occlusionTexture) &&
+                     getString(cacheMesh.roughnessTextureIdx, meshData.roughnessTexture) &&
+                     getString(cacheMesh.metallicTextureIdx, meshData.metallicTexture);
+        meshData.vertices = Span<const gfx::VertexP3N3T3B3UV2>(vertices, cacheMesh.numVertices);
+
+        for (u32 i = 0; i < NUM_LOD && valid; ++i) {
+            const ModelCacheLod &lod = cacheMesh.lods[i];
+            const u32 *indices = get_section<u32>(file, lod.indicesOffset, lod.numIndices);
+
+            // The vertices are read in place, so the indices must be in range
+            valid = indices != nullptr &&
+                    std::all_of(indices, indices + lod.numIndices, [&](u32 index) {
+                        return index < cacheMesh.numVertices;
+                    });
+
+            meshData.lodIndices[i] = Span<const u32>(indices, lod.numIndices);
+            meshData.lodBounds[i] = AABB(glm::vec3(lod.boundsMin[0], lod.boundsMin[1], lod.boundsMin[2]),
+                                         glm::vec3(lod.boundsMax[0], lod.boundsMax[1], lod.boundsMax[2]));
+            meshData.lodBoundingSpheres[i] = Sphere(glm::vec3(lod.sphereCenter[0], lod.sphereCenter[1],
+                                                              lod.sphereCenter[2]), lod.sphereRadius);
+        }
+
+        if (!valid) {
+            Log::warn("Cooked model for '%' is invalid", model_path);
+            out_meshes.clear();
+            file.close();
+            return false;
+        }
+    }
+
+    TaskGroup group;
+    std::vector<std::vector<TextureData>> decodedTextures;
+    decodeTextures(modelTextures, group, decodedTextures);
+    threadPool_.wait(group);
+
+    for (std::vector<TextureData> &decoded : decodedTextures) {
+        std::move(decoded.begin(), decoded.end(), std::back_inserter(out_textures));
+    }
+
+    return true;
+}
+
+void ResourceManager::writeCachedModel(const std::string &model_path, const std::vector<std::string> &dependencies,
+                                       const std::vector<MeshData> &meshes,
+                                       const std::vector<ModelTexture> &textures) const {
+    std::vector<u8> file(sizeof(ModelCacheHeader));
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, u32> stringIndices;
+    auto addString = [&](const std::string &str) {
+        auto it = stringIndices.emplace(str, (u32) strings.size()).first;
+        if (it->second == strings.size()) {
+            strings.push_back(str);
+        }
+
+        return it->second;
+    };
+
+    ModelCacheHeader header = {};
+    std::memcpy(header.magic, MODEL_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MODEL_CACHE_VERSION;
+    header.settingsHash = get_import_settings_hash();
+
+    std::vector<ModelCacheDependency> cacheDependencies;
+    for (const std::string &path : dependencies) {
+        ModelCacheDependency &dependency = cacheDependencies.emplace_back();
+        dependency.pathIdx = addString(path);
+        if (!hash_file(path, dependency.hash)) {
+            Log::warn("Failed to cook model '%', couldn't read '%'", model_path, path);
+            return;
+        }
+    }
+
+    std::vector<ModelCacheTexture> cacheTextures;
+    for (const ModelTexture &texture : textures) {
+        cacheTextures.push_back({addString(texture.path), (u32) texture.kind});
+    }
+
+    std::vector<ModelCacheMesh> cacheMeshes;
+    for (const MeshData &mesh : meshes) {
+        ModelCacheMesh &cacheMesh = cacheMeshes.emplace_back();
+        cacheMesh.verticesOffset = append_section(file, mesh.vertices.data(),
+                                                  mesh.vertices.size() * sizeof(mesh.vertices[0]));
+        cacheMesh.numVertices = (u32) mesh.vertices.size();
+        cacheMesh.diffuseTextureIdx = addString(mesh.diffuseTexture);
+        cacheMesh.normalTextureIdx = addString(mesh.normalTexture);
+        cacheMesh.occlusionTextureIdx = addString(mesh.occlusionTexture);
+        cacheMesh.roughnessTextureIdx = addString(mesh.roughnessTexture);
+        cacheMesh.metallicTextureIdx = addString(mesh.metallicTexture);
+
+        for (u32 i = 0; i < NUM_LOD; ++i) {
+            ModelCacheLod &lod = cacheMesh.lods[i];
+            lod.indicesOffset = append_section(file, mesh.lodIndices[i].data(),
+                                               mesh.lodIndices[i].size() * sizeof(u32));
+            lod.numIndices = (u32) mesh.lodIndices[i].size();
+
+            const AABB &bounds = mesh.lodBounds[i];
+            const Sphere &sphere = mesh.lodBoundingSpheres[i];
+            for (u32 c = 0; c < 3; ++c) {
+                lod.boundsMin[c] = bounds.min[c];
+                lod.boundsMax[c] = bounds.max[c];
+                lod.sphereCenter[c] = sphere.center[c];
+            }
+            lod.sphereRadius = sphere.radius;
+        }
+    }
+
+    std::vector<ModelCacheString> cacheStrings;
+    for (const std::string &str : strings) {
+        cacheStrings.push_back({append_section(file, str.data(), str.size()), (u32) str.size(), 0});
+    }
+
+    header.numDependencies = (u32) cacheDependencies.size();
+    header.numTextures = (u32) cacheTextures.size();
+    header.numMeshes = (u32) cacheMeshes.size();
+    header.numStrings = (u32) cacheStrings.size();
+    header.dependenciesOffset = append_section(file, cacheDependencies);
+    header.texturesOffset = append_section(file, cacheTextures);
+    header.meshesOffset = append_section(file, cacheMeshes);
+    header.stringsOffset = append_section(file, cacheStrings);
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    write_cache_file(getCachePath(model_path, ".mesh"), file);
+}
+
+void ResourceManager::decodeTextures(const std::vector<ModelTexture> &textures, TaskGroup &group,
+                                     std::vector<std::vector<TextureData>> &out_textures) const {
+    out_textures.resize(textures.size());
+    for (u32 t = 0; t < textures.size(); ++t) {
+        threadPool_.submit(group, [this, &textures, &out_textures, t]() {
+            if (!readTexture(textures[t].path, textures[t].kind, out_textures[t])) {
+                Log::warn("Failed to get texture '%'", textures[t].path);
+            }
+        });
+    }
+}
+
+std::string ResourceManager::getCachePath(const std::string &name, const std::string &extension) const {
+    // The hash keeps names that only differ in their directories apart
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx", (unsigned long long) hash_bytes(name.data(), name.size()));
+
+    return cacheDirectory_ + std::filesystem::path(name).filename().string() + "-" + hash + extension;
+}
+
+bool ResourceManager::readTexture(const std::string &texture_path, TextureKind kind,
+                                  std::vector<TextureData> &out_textures) const {
     std::string full = resourceDirectory_ + texture_path;
     std::replace(full.begin(), full.end(), '\\', '/');
     std::filesystem::path filePath = std::filesystem::path(full).lexically_normal();
 
+    // The file is hashed to find out if the cooked texture is up to date, it's only decoded if it isn't
+    MappedFile sourceFile;
+    if (!sourceFile.open(filePath.string())) {
+        return false;
+    }
+    u64 sourceHash = hash_bytes(sourceFile.getData(), sourceFile.getSize());
+
+    std::string cachePath = getCachePath(texture_path, kind == TextureKind::NORMAL_MAP ? ".normal.tex" :
+                                                       kind == TextureKind::SPLIT_CHANNELS ? ".split.tex" : ".tex");
+    if (readCachedTexture(cachePath, texture_path, sourceHash, out_textures)) {
+        return true;
+    }
+
     // Read image
     i32 width, height;
-    u8 *data = stbi_load(filePath.string().c_str(), &width, &height, nullptr, 4);
+    u8 *data = stbi_load_from_memory(sourceFile.getData(), (i32) sourceFile.getSize(), &width, &height, nullptr, 4);
     if (!data) {
         return false;
     }
     u32 size = width * height * 4;
 
-    loadTexture(texture_path, width, height, VK_FORMAT_R8G8B8A8_UNORM, data, size);
+    std::vector<TextureData> textures;
+    auto addTexture = [&](const std::string &name, VkFormat format, VkFormat compressed_format, const u8 *pixels) {
+        TextureData &texture = textures.emplace_back();
+        texture.name = name;
+        texture.width = (u32) width;
+        texture.height = (u32) height;
+        texture.mipLevels = gfx::get_mip_level_count(texture.width, texture.height);
+        texture.format = format;
+        gfx::generate_mip_chain(format, texture.width, texture.height, pixels, texture.pixelStorage);
+
+        // Mips are generated before compressing, averaging compressed blocks would add up their errors
+        if (compressTextures_) {
+            std::vector<u8> mipChain = std::move(texture.pixelStorage);
+            gfx::compress_mip_chain(format, compressed_format, texture.width, texture.height, texture.mipLevels,
+                                    mipChain.data(), texture.pixelStorage);
+            texture.format = compressed_format;
+        }
+
+        texture.pixels = Span<const u8>(texture.pixelStorage.data(), texture.pixelStorage.size());
+    };
 
-    if (split_channels) {
+    // Opaque textures don't need the alpha of BC3, BC1 is half the size
+    bool opaque = true;
+    for (u32 i = 3; i < size && opaque; i += 4) {
+        opaque = data[i] == 255;
+    }
+
+    VkFormat compressedFormat = kind == TextureKind::NORMAL_MAP ? VK_FORMAT_BC5_UNORM_BLOCK :
+                                opaque ? VK_FORMAT_BC1_RGB_UNORM_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+    addTexture(get_texture_name(texture_path, kind), VK_FORMAT_R8G8B8A8_UNORM, compressedFormat, data);
+
+    if (kind == TextureKind::SPLIT_CHANNELS) {
         std::vector<char> suffix = {'r', 'g', 'b', 'a'};
         std::vector<std::vector<u8>> channels(suffix.size(), std::vector<u8>(width * height));
 
@@ -287,26 +988,140 @@ bool ResourceManager::loadTextureFromFile(const std::string &texture_path, bool
             channels[i % channels.size()][i / channels.size()] = data[i];
         }
 
-        // Load textures for each channel
+        // Add textures for each channel
         for (u32 i = 0; i < suffix.size(); ++i) {
-            loadTexture(texture_path + "_" + suffix[i], width, height, VK_FORMAT_R8_UNORM,
-                        channels[i].data(), channels[i].size());
+            addTexture(texture_path + "_" + suffix[i], VK_FORMAT_R8_UNORM, VK_FORMAT_BC4_UNORM_BLOCK,
+                       channels[i].data());
         }
     }
 
     // Free image data
     stbi_image_free(data);
+
+    writeCachedTexture(cachePath, texture_path, sourceHash, textures);
+    std::move(textures.begin(), textures.end(), std::back_inserter(out_textures));
+
     return true;
 }
 
-void ResourceManager::loadTexture(const std::string &name, u32 width, u32 height, VkFormat format, u8 *data, u32 size) {
-    textures_.emplace(name, std::make_unique<gfx::Texture>(
-                          gfx::TextureBuilder(device_)
-                          .setExtent2D(width, height)
-                          .setFormat(format)
-                          .setImageAspect(VK_IMAGE_ASPECT_COLOR_BIT)
-                          .setData(data, size)
-                          .build()));
+bool ResourceManager::readCachedTexture(const std::string &cache_path, const std::string &texture_path,
+                                        u64 source_hash, std::vector<TextureData> &out_textures) const {
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(cache_path)) {
+        return false;
+    }
+
+    const auto *header = get_section<TextureCacheHeader>(*file, 0, 1);
+    if (!header || std::memcmp(header->magic, TEXTURE_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TEXTURE_CACHE_VERSION || header->sourceHash != source_hash ||
+        header->compressed != (compressTextures_ ? 1u : 0u)) {
+        Log::debug("Cooked texture for '%' is out of date", texture_path);
+        return false;
+    }
+
+    const auto *entries = get_section<TextureCacheEntry>(*file, header->texturesOffset, header->numTextures);
+    if (!entries) {
+        Log::warn("Cooked texture for '%' is truncated", texture_path);
+        return false;
+    }
+
+    std::vector<TextureData> textures(header->numTextures);
+    for (u32 i = 0; i < header->numTextures; ++i) {
+        const TextureCacheEntry &entry = entries[i];
+        VkFormat format = (VkFormat) entry.format;
+
+        // Everything has to be checked before its size is calculated, unknown formats are fatal errors
+        if (!is_cooked_texture_format(format) ||
+            !std::memchr(entry.nameSuffix, '\0', sizeof(entry.nameSuffix)) ||
+            entry.width == 0 || entry.height == 0 || entry.mipLevels == 0 ||
+            entry.mipLevels > gfx::get_mip_level_count(entry.width, entry.height) ||
+            entry.dataSize < gfx::get_mip_chain_layout(format, entry.width, entry.height, 1, entry.mipLevels) ||
+            !get_section<u8>(*file, entry.dataOffset, entry.dataSize)) {
+            Log::warn("Cooked texture for '%' is invalid", texture_path);
+            return false;
+        }
+
+        TextureData &texture = textures[i];
+        texture.name = texture_path + entry.nameSuffix;
+        texture.width = entry.width;
+        texture.height = entry.height;
+        texture.mipLevels = entry.mipLevels;
+        texture.format = format;
+        texture.pixels = Span<const u8>(file->getData() + entry.dataOffset, entry.dataSize);
+        texture.cacheFile = file;
+    }
+
+    std::move(textures.begin(), textures.end(), std::back_inserter(out_textures));
+
+    return true;
+}
+
+void ResourceManager::writeCachedTexture(const std::string &cache_path, const std::string &texture_path,
+                                         u64 source_hash, const std::vector<TextureData> &textures) const {
+    std::vector<u8> file(sizeof(TextureCacheHeader));
+
+    TextureCacheHeader header = {};
+    std::memcpy(header.magic, TEXTURE_CACHE_MAGIC, sizeof(header.magic));
+    header.version = TEXTURE_CACHE_VERSION;
+    header.sourceHash = source_hash;
+    header.compressed = compressTextures_ ? 1 : 0;
+
+    std::vector<TextureCacheEntry> entries;
+    for (const TextureData &texture : textures) {
+        TextureCacheEntry &entry = entries.emplace_back();
+        entry.dataOffset = append_section(file, texture.pixels.data(), texture.pixels.size());
+        entry.dataSize = texture.pixels.size();
+        entry.width = texture.width;
+        entry.height = texture.height;
+        entry.mipLevels = texture.mipLevels;
+        entry.format = (u32) texture.format;
+
+        std::string suffix = texture.name.substr(texture_path.size());
+        if (suffix.size() >= sizeof(entry.nameSuffix)) {
+            Log::warn("Failed to cook texture '%', name suffix '%' is too long", texture_path, suffix);
+            return;
+        }
+        std::memcpy(entry.nameSuffix, suffix.c_str(), suffix.size() + 1);
+    }
+
+    header.numTextures = (u32) entries.size();
+    header.texturesOffset = append_section(file, entries);
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    write_cache_file(cache_path, file);
+}
+
+void ResourceManager::loadTexture(const std::string &name, u32 width, u32 height, u32 mip_levels, VkFormat format,
+                                  const u8 *data, u64 size) {
+    // A texture can be decoded by more than one load, the first one to finish wins
+    ResourceSlot<gfx::Texture> &slot = textures_[name];
+    if (slot.state == ResourceState::LOADED) {
+        return;
+    }
+
+    slot.resource = std::make_unique<gfx::Texture>(
+                        gfx::TextureBuilder(device_)
+                        .setExtent2D(width, height)
+                        .setMipLevels(mip_levels)
+                        .setFormat(format)
+                        .setImageAspect(VK_IMAGE_ASPECT_COLOR_BIT)
+                        .setData(data, size)
+                        .build());
+    slot.current = slot.resource.get();
+    slot.state = ResourceState::LOADED;
+}
+
+const gfx::Texture &ResourceManager::findTexture(const std::string &name, const gfx::Texture &default_texture) const {
+    if (name.empty()) {
+        return default_texture;
+    }
+
+    auto it = textures_.find(name);
+    if (it == textures_.end() || it->second.state != ResourceState::LOADED) {
+        return *textureMissing_;
+    }
+
+    return *it->second.resource;
 }
 
 }
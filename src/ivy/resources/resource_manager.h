@@ -4,6 +4,11 @@
 #include "ivy/resources/model_resource.h"
 #include "ivy/resources/texture_resource.h"
 #include "ivy/graphics/mesh.h"
+#include "ivy/graphics/vertex.h"
+#include "ivy/utils/mapped_file.h"
+#include "ivy/utils/span.h"
+#include "ivy/utils/thread_pool.h"
+#include <array>
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -22,49 +27,270 @@ public:
      */
     static constexpr u32 NUM_LOD = MAX_LOD + 1;
 
-    explicit ResourceManager(gfx::RenderDevice &render_device, const std::string &resource_directory);
+    /**
+     * \brief How a texture is used, this decides how it is processed
+     */
+    enum class TextureKind : u32 {
+        COLOR,         // Compressed to BC1, or BC3 if it has transparency
+        NORMAL_MAP,    // Compressed to BC5, only x and y are kept
+        SPLIT_CHANNELS // A color texture and a texture for each of its channels, which are compressed to BC4
+    };
+
+    /**
+     * \param render_device The device to create GPU resources with
+     * \param thread_pool The pool that files are read and processed on for asynchronous loads
+     * \param resource_directory The directory resource names are relative to
+     */
+    explicit ResourceManager(gfx::RenderDevice &render_device, ThreadPool &thread_pool,
+                             const std::string &resource_directory);
+    ~ResourceManager();
+
+    ResourceManager(const ResourceManager &) = delete;
+    ResourceManager &operator=(const ResourceManager &) = delete;
 
     /**
      * \brief Get a handle to a 3D model. If the model has not been loaded then the resource manager
-     * will load it from the filesystem (path: resource_directory/model_name)
+     * will load it from the filesystem (path: resource_directory/model_name), blocking until it is done
      * \param model_name The name of the model resource
      * \return A resource handle to the model
      */
     ModelResource getModel(const std::string &model_name);
 
+    /**
+     * \brief Get a handle to a 3D model without waiting for it to load. If the model has not been loaded then it is
+     * loaded on the thread pool, and until update() finishes it the handle refers to a model without any meshes
+     * \param model_name The name of the model resource
+     * \return A resource handle to the model
+     */
+    ModelResource getModelAsync(const std::string &model_name);
+
     /**
      * \brief Get a handle to a texture. If the texture has not been loaded then the resource manager
-     * will load it from the filesystem (path: resource_directory/texture_name).
+     * will load it from the filesystem (path: resource_directory/texture_name), blocking until it is done
      * \param texture_name The name of the texture resource
+     * \param kind How the texture is used, the same file used as a different kind is a different texture
      * \return A resource handle to the texture
      */
-    TextureResource getTexture(const std::string &texture_name);
+    TextureResource getTexture(const std::string &texture_name, TextureKind kind = TextureKind::COLOR);
+
+    /**
+     * \brief Get a handle to a texture without waiting for it to load. If the texture has not been loaded then it is
+     * loaded on the thread pool, and until update() finishes it the handle refers to the missing texture
+     * \param texture_name The name of the texture resource
+     * \param kind How the texture is used, the same file used as a different kind is a different texture
+     * \return A resource handle to the texture
+     */
+    TextureResource getTextureAsync(const std::string &texture_name, TextureKind kind = TextureKind::COLOR);
+
+    /**
+     * \brief Create the GPU resources for asynchronous loads that are done reading their files, handles to them
+     * refer to the loaded resources afterwards. Called once per frame by the engine.
+     */
+    void update();
+
+    /**
+     * \brief Get the number of asynchronous loads that haven't been finished by update() yet
+     * \return Number of loads
+     */
+    [[nodiscard]] u32 getNumPendingLoads() const {
+        return (u32) pendingLoads_.size();
+    }
 
 private:
+    using ModelMeshes = std::vector<ModelLod>;
+
+    /**
+     * \brief Decoded texture that hasn't been uploaded yet
+     */
+    struct TextureData {
+        std::string name;
+        u32 width = 0;
+        u32 height = 0;
+        u32 mipLevels = 1;
+        VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+        // Every mip level, it's either in the storage below or in the cooked texture file
+        Span<const u8> pixels;
+        std::vector<u8> pixelStorage;
+        std::shared_ptr<const MappedFile> cacheFile;
+    };
+
+    /**
+     * \brief Processed mesh that hasn't been uploaded yet
+     */
+    struct MeshData {
+        // The data that is uploaded, it's either in the storage below or in the cooked model file
+        Span<const gfx::VertexP3N3T3B3UV2> vertices;
+        std::array<Span<const u32>, NUM_LOD> lodIndices; // Empty when the LOD is the same as the previous one
+        std::array<AABB, NUM_LOD> lodBounds;
+        std::array<Sphere, NUM_LOD> lodBoundingSpheres;
+
+        // Texture names, empty to use the default for that slot
+        std::string diffuseTexture;
+        std::string normalTexture;
+        std::string occlusionTexture;
+        std::string roughnessTexture;
+        std::string metallicTexture;
+
+        // Storage for meshes that were imported from the source file
+        std::vector<gfx::VertexP3N3T3B3UV2> vertexStorage;
+        std::array<std::vector<u32>, NUM_LOD> lodIndexStorage;
+    };
+
+    /**
+     * \brief A texture used by a model
+     */
+    struct ModelTexture {
+        std::string path;
+        TextureKind kind = TextureKind::COLOR;
+    };
+
+    /**
+     * \brief A resource that is being read on the thread pool, texture loads only fill in textures
+     */
+    struct PendingLoad {
+        std::string name; // The name of the resource's slot
+        std::string path; // The file that is read
+        bool isModel = false;
+        TextureKind textureKind = TextureKind::COLOR;
+        bool success = false;
+        std::vector<MeshData> meshes;
+        std::vector<TextureData> textures;
+        MappedFile cacheFile; // The cooked model the meshes point into, if it was read from the cache
+        TaskGroup group;
+    };
+
     /**
-     * \brief Load a model into the resource manager
+     * \brief Start loading a resource on the thread pool, its slot must not exist yet
+     * \param name The name of the resource slot
+     * \param path The path to the resource relative to the resource directory
+     * \param is_model Whether the resource is a model or a texture
+     * \param texture_kind How the texture is used, ignored for models
+     */
+    void startLoad(const std::string &name, const std::string &path, bool is_model,
+                   TextureKind texture_kind = TextureKind::COLOR);
+
+    /**
+     * \brief Wait for the pending load of a resource and finish it, does nothing if the resource isn't loading
+     * \param name The name of the resource
+     */
+    void waitForLoad(const std::string &name);
+
+    /**
+     * \brief Create the GPU resources of a load that is done and point its slot at them
+     * \param load The load
+     */
+    void finishLoad(PendingLoad &load);
+
+    /**
+     * \brief Read and process a model and the textures it uses, this doesn't touch the resource manager's state so
+     * it can run on any thread. The processed model is written to the cache.
      * \param model_path The path to the resource relative to the resource directory
-     * \return Whether or not the model was loaded successfully
+     * \param out_meshes The processed meshes are written here
+     * \param out_textures The decoded textures are written here
+     * \return Whether or not the model was read successfully
      */
-    bool loadModelFromFile(const std::string &model_path);
+    bool readModel(const std::string &model_path, std::vector<MeshData> &out_meshes,
+                   std::vector<TextureData> &out_textures) const;
 
     /**
-     * \brief Load a texture from file
+     * \brief Read a model that was processed by readModel before from the cache, and decode the textures it uses.
+     * This doesn't touch the resource manager's state so it can run on any thread.
+     * \param model_path The path to the resource relative to the resource directory
+     * \param out_cache_file The cooked model is mapped here, the meshes point into it
+     * \param out_meshes The meshes are written here
+     * \param out_textures The decoded textures are written here
+     * \return Whether or not the model was in the cache and none of the files it was made from have changed
+     */
+    bool readCachedModel(const std::string &model_path, MappedFile &out_cache_file, std::vector<MeshData> &out_meshes,
+                         std::vector<TextureData> &out_textures) const;
+
+    /**
+     * \brief Write a processed model to the cache
+     * \param model_path The path to the resource relative to the resource directory
+     * \param dependencies The paths of the files the model was made from
+     * \param meshes The processed meshes
+     * \param textures The textures the meshes use
+     */
+    void writeCachedModel(const std::string &model_path, const std::vector<std::string> &dependencies,
+                          const std::vector<MeshData> &meshes, const std::vector<ModelTexture> &textures) const;
+
+    /**
+     * \brief Decode the textures of a model on the thread pool
+     * \param textures The textures to decode
+     * \param group The group to add the tasks to, out_textures is filled in once it's done
+     * \param out_textures The decoded textures of each of the model's textures are written here
+     */
+    void decodeTextures(const std::vector<ModelTexture> &textures, TaskGroup &group,
+                        std::vector<std::vector<TextureData>> &out_textures) const;
+
+    /**
+     * \brief Get the path in the cache directory that a processed resource is stored at
+     * \param name The name of the resource
+     * \param extension The extension of the cache file
+     * \return The path
+     */
+    [[nodiscard]] std::string getCachePath(const std::string &name, const std::string &extension) const;
+
+    /**
+     * \brief Decode a texture file, generate its mip levels and block compress them if the device supports it. This
+     * doesn't touch the resource manager's state so it can run on any thread. The cooked texture is read from the
+     * cache instead if the file hasn't changed, otherwise it is written to the cache.
+     * \param texture_path The path to the texture relative to the resource directory
+     * \param kind How the texture is used, normal maps are named with a suffix so they don't share a name with the
+     * file's color texture. Split channels generate 4 additional textures that can be gotten by appending an _r, _g,
+     * _b, or _a to the end of the texture name
+     * \param out_textures The decoded textures are appended here
+     * \return Whether or not the texture was read successfully
+     */
+    bool readTexture(const std::string &texture_path, TextureKind kind, std::vector<TextureData> &out_textures) const;
+
+    /**
+     * \brief Read the textures of a cooked texture file, their pixels point into the mapped file
+     * \param cache_path The path to the cooked texture
+     * \param texture_path The path to the texture relative to the resource directory
+     * \param source_hash The hash of the texture file the cooked texture has to be made from
+     * \param out_textures The textures are appended here
+     * \return Whether or not the cooked texture exists and is up to date
+     */
+    bool readCachedTexture(const std::string &cache_path, const std::string &texture_path, u64 source_hash,
+                           std::vector<TextureData> &out_textures) const;
+
+    /**
+     * \brief Write decoded textures to a cooked texture file
+     * \param cache_path The path to the cooked texture
      * \param texture_path The path to the texture relative to the resource directory
-     * \param split_channels Whether or not to split the texture into separate textures, one for each channel
-     * If true, 4 additional textures will be generated that can be gotten by appending an _r, _g, _b, or _a to the
-     * end of the texture name
-     * \return Whether or not the texture was loaded successfully
+     * \param source_hash The hash of the texture file the textures were decoded from
+     * \param textures The textures decoded from the file, all names start with texture_path
      */
-    bool loadTextureFromFile(const std::string &texture_path, bool split_channels = false);
+    void writeCachedTexture(const std::string &cache_path, const std::string &texture_path, u64 source_hash,
+                            const std::vector<TextureData> &textures) const;
 
-    void loadTexture(const std::string &name, u32 width, u32 height, VkFormat format, u8 *data, u32 size);
+    /**
+     * \brief Upload a texture and point its slot at it, textures that are already loaded are left alone
+     */
+    void loadTexture(const std::string &name, u32 width, u32 height, u32 mip_levels, VkFormat format, const u8 *data,
+                     u64 size);
+
+    /**
+     * \brief Get a loaded texture by name
+     * \param name The texture name, may be empty
+     * \param default_texture The texture to use if the name is empty
+     * \return The texture, or the missing texture if it isn't loaded
+     */
+    const gfx::Texture &findTexture(const std::string &name, const gfx::Texture &default_texture) const;
 
     gfx::RenderDevice &device_;
+    ThreadPool &threadPool_;
     std::string resourceDirectory_;
+    std::string cacheDirectory_;
+    bool compressTextures_;
+
+    std::unordered_map<std::string, ResourceSlot<ModelMeshes>> modelMeshes_;
+    std::unordered_map<std::string, ResourceSlot<gfx::Texture>> textures_;
+    std::vector<std::unique_ptr<PendingLoad>> pendingLoads_;
 
-    std::unordered_map<std::string, std::unique_ptr<std::vector<std::vector<gfx::Mesh>>>> modelMeshes_;
-    std::unordered_map<std::string, std::unique_ptr<gfx::Texture>> textures_;
+    ModelMeshes emptyModel_ = ModelMeshes(NUM_LOD);
 
     gfx::Texture *textureWhite_;
     gfx::Texture *textureBlackOpaque_;
@@ -0,0 +1,56 @@
+#include "archetype.h"
+#include "ivy/log.h"
+#include <atomic>
+
+namespace ivy {
+
+u32 next_component_type_id() {
+    // Components can be used for the first time from worker threads
+    static std::atomic<u32> nextId = 0;
+
+    u32 id = nextId.fetch_add(1, std::memory_order_relaxed);
+    if (id >= MAX_COMPONENT_TYPES) {
+        Log::fatal("Too many component types, at most % are supported", MAX_COMPONENT_TYPES);
+    }
+
+    return id;
+}
+
+u32 Archetype::addEntity(u32 entity_idx) {
+    entities_.emplace_back(entity_idx);
+    return (u32) entities_.size() - 1;
+}
+
+u32 Archetype::addEntities(const u32 *entity_idxs, u32 count) {
+    u32 firstRow = (u32) entities_.size();
+    entities_.insert(entities_.end(), entity_idxs, entity_idxs + count);
+    return firstRow;
+}
+
+u32 Archetype::removeRow(u32 row) {
+    for (auto &pool : pools_) {
+        if (pool) {
+            pool->swapRemove(row);
+        }
+    }
+
+    u32 movedEntityIdx = INVALID_ENTITY;
+    if (row + 1 != entities_.size()) {
+        movedEntityIdx = entities_.back();
+        entities_[row] = movedEntityIdx;
+    }
+    entities_.pop_back();
+
+    return movedEntityIdx;
+}
+
+void Archetype::reserve(u32 capacity) {
+    entities_.reserve(capacity);
+    for (auto &pool : pools_) {
+        if (pool) {
+            pool->reserve(capacity);
+        }
+    }
+}
+
+}
@@ -0,0 +1,287 @@
+#ifndef IVY_ARCHETYPE_H
+#define IVY_ARCHETYPE_H
+
+#include "ivy/types.h"
+#include "ivy/scene/components/component.h"
+#include <array>
+#include <bitset>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace ivy {
+
+/**
+ * \brief The maximum number of different component types that can be used in a scene
+ */
+constexpr u32 MAX_COMPONENT_TYPES = 64;
+
+/**
+ * \brief A set of component types, bit i is set if the component with type id i is present
+ */
+using ComponentMask = std::bitset<MAX_COMPONENT_TYPES>;
+
+/**
+ * \brief Get the next unused component type id
+ * \return Component type id
+ */
+u32 next_component_type_id();
+
+/**
+ * \brief Get the type id for a component, ids are assigned in order of first use
+ * \tparam T The component type
+ * \return Component type id
+ */
+template <typename T>
+u32 component_type_id() {
+    static_assert(std::is_base_of<Component, T>(), "T is not a valid component");
+
+    static const u32 id = next_component_type_id();
+    return id;
+}
+
+/**
+ * \brief Get the mask for a set of component types
+ * \tparam Components Parameter pack of components
+ * \return Component mask with the bits for each component set
+ */
+template <typename... Components>
+ComponentMask component_mask() {
+    ComponentMask mask;
+    (mask.set(component_type_id<Components>()), ...);
+    return mask;
+}
+
+/**
+ * \brief Type erased array of components
+ */
+class ComponentPoolBase {
+public:
+    virtual ~ComponentPoolBase() = default;
+
+    /**
+     * \brief Create an empty pool that holds the same component type as this pool
+     * \return The new pool
+     */
+    [[nodiscard]] virtual std::unique_ptr<ComponentPoolBase> createEmpty() const = 0;
+
+    /**
+     * \brief Move a component to the end of another pool of the same type, this leaves a moved-from component behind
+     * \param row The index of the component to move
+     * \param dst The pool to move the component into
+     */
+    virtual void moveTo(u32 row, ComponentPoolBase &dst) = 0;
+
+    /**
+     * \brief Append copies of a component from another pool of the same type
+     * \param src The pool to copy from
+     * \param row The index of the component in src
+     * \param count The number of copies to append
+     */
+    virtual void appendCopies(const ComponentPoolBase &src, u32 row, u32 count) = 0;
+
+    /**
+     * \brief Remove a component by replacing it with the last component in the pool
+     * \param row The index of the component to remove
+     */
+    virtual void swapRemove(u32 row) = 0;
+
+    /**
+     * \brief Get the name of the component type stored in the pool
+     * \return Component name
+     */
+    [[nodiscard]] virtual std::string getComponentName() const = 0;
+
+    /**
+     * \brief Get the number of components in the pool
+     * \return Number of components
+     */
+    [[nodiscard]] virtual u32 size() const = 0;
+
+    /**
+     * \brief Reserve memory for a number of components
+     * \param capacity The number of components to reserve memory for
+     */
+    virtual void reserve(u32 capacity) = 0;
+};
+
+/**
+ * \brief Contiguous array of components of type T
+ * \tparam T The component type
+ */
+template <typename T>
+class ComponentPool final : public ComponentPoolBase {
+public:
+    static std::unique_ptr<ComponentPoolBase> create() {
+        return std::make_unique<ComponentPool<T>>();
+    }
+
+    [[nodiscard]] std::unique_ptr<ComponentPoolBase> createEmpty() const override {
+        return create();
+    }
+
+    void moveTo(u32 row, ComponentPoolBase &dst) override {
+        static_cast<ComponentPool<T> &>(dst).components_.emplace_back(std::move(components_[row]));
+    }
+
+    void appendCopies(const ComponentPoolBase &src, u32 row, u32 count) override {
+        components_.insert(components_.end(), count, static_cast<const ComponentPool<T> &>(src).components_[row]);
+    }
+
+    void swapRemove(u32 row) override {
+        if (row + 1 != components_.size()) {
+            components_[row] = std::move(components_.back());
+        }
+        components_.pop_back();
+    }
+
+    [[nodiscard]] std::string getComponentName() const override {
+        return T::getName();
+    }
+
+    [[nodiscard]] u32 size() const override {
+        return (u32) components_.size();
+    }
+
+    void reserve(u32 capacity) override {
+        components_.reserve(capacity);
+    }
+
+    [[nodiscard]] std::vector<T> &getComponents() {
+        return components_;
+    }
+
+    [[nodiscard]] const std::vector<T> &getComponents() const {
+        return components_;
+    }
+
+private:
+    std::vector<T> components_;
+};
+
+/**
+ * \brief Stores the components of all entities that have the exact same set of component types.
+ * Each component type is kept in its own contiguous array, and row i of every array belongs to the same entity.
+ */
+class Archetype {
+public:
+    explicit Archetype(const ComponentMask &mask)
+        : mask_(mask) {}
+
+    /**
+     * \brief Get the set of component types in this archetype
+     * \return Component mask
+     */
+    [[nodiscard]] const ComponentMask &getMask() const {
+        return mask_;
+    }
+
+    /**
+     * \brief Check if this archetype stores a component type
+     * \tparam T The component type
+     * \return Whether or not the component type is stored
+     */
+    template <typename T>
+    [[nodiscard]] bool hasComponent() const {
+        return mask_.test(component_type_id<T>());
+    }
+
+    /**
+     * \brief Get a component for an entity in this archetype
+     * \tparam T The component type
+     * \param row The row of the entity
+     * \return A pointer to the component if this archetype stores T, otherwise nullptr
+     */
+    template <typename T>
+    [[nodiscard]] T *getComponent(u32 row) {
+        ComponentPoolBase *pool = pools_[component_type_id<T>()].get();
+        return pool ? &static_cast<ComponentPool<T> *>(pool)->getComponents()[row] : nullptr;
+    }
+
+    /**
+     * \brief Get the pool for a component type, the archetype must store T
+     * \tparam T The component type
+     * \return The component pool
+     */
+    template <typename T>
+    [[nodiscard]] ComponentPool<T> &getPool() {
+        return static_cast<ComponentPool<T> &>(*pools_[component_type_id<T>()]);
+    }
+
+    /**
+     * \brief Get the pool for a component type id
+     * \param type_id The component type id
+     * \return The component pool if the archetype stores this type, otherwise nullptr
+     */
+    [[nodiscard]] ComponentPoolBase *getPool(u32 type_id) const {
+        return pools_[type_id].get();
+    }
+
+    /**
+     * \brief Set the pool for a component type id, should only be done when the archetype is created
+     * \param type_id The component type id
+     * \param pool The pool
+     */
+    void setPool(u32 type_id, std::unique_ptr<ComponentPoolBase> pool) {
+        pools_[type_id] = std::move(pool);
+    }
+
+    /**
+     * \brief Get the entity indices for each row in the archetype
+     * \return Vector of entity indices
+     */
+    [[nodiscard]] const std::vector<u32> &getEntities() const {
+        return entities_;
+    }
+
+    /**
+     * \brief Add an entity to the end of the archetype, the caller is responsible for adding its components
+     * \param entity_idx The index of the entity
+     * \return The row for the entity
+     */
+    u32 addEntity(u32 entity_idx);
+
+    /**
+     * \brief Add entities to the end of the archetype, the caller is responsible for adding their components
+     * \param entity_idxs The indices of the entities
+     * \param count The number of entities
+     * \return The row of the first entity, the rest follow in order
+     */
+    u32 addEntities(const u32 *entity_idxs, u32 count);
+
+    /**
+     * \brief Remove a row from the archetype by moving the last row into its place
+     * \param row The row to remove
+     * \return The index of the entity that was moved into row, or INVALID_ENTITY if nothing was moved
+     */
+    u32 removeRow(u32 row);
+
+    /**
+     * \brief Reserve memory for a number of entities
+     * \param capacity The number of entities to reserve memory for
+     */
+    void reserve(u32 capacity);
+
+    /**
+     * \brief Get the number of entities in the archetype
+     * \return Number of entities
+     */
+    [[nodiscard]] u32 size() const {
+        return (u32) entities_.size();
+    }
+
+    /**
+     * \brief Used as a return value when no entity is referenced
+     */
+    static constexpr u32 INVALID_ENTITY = ~0u;
+
+private:
+    ComponentMask mask_;
+    std::vector<u32> entities_;
+    std::array<std::unique_ptr<ComponentPoolBase>, MAX_COMPONENT_TYPES> pools_;
+};
+
+}
+
+#endif // IVY_ARCHETYPE_H
@@ -16,7 +16,7 @@ public:
     explicit Camera(f32 fov_y = glm::half_pi<f32>(), f32 near_plane = 0.1f, f32 far_plane = 100.0f)
         : fovY_(fov_y), nearPlane_(near_plane), farPlane_(far_plane) {}
 
-    [[nodiscard]] std::string getName() const override {
+    [[nodiscard]] static std::string getName() {
         return "Camera";
     }
 
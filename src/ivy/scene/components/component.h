@@ -6,11 +6,10 @@
 namespace ivy {
 
 /**
- * \brief Component base class
+ * \brief Component base class. Components provide a static getName() and have no virtual functions, components that
+ * are also trivially copyable can be stored in scene snapshots with a plain memory copy
  */
 class Component {
-public:
-    [[nodiscard]] virtual std::string getName() const = 0;
 };
 
 }
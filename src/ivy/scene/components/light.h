@@ -25,7 +25,7 @@ public:
         : direction_(direction), color_(color), intensity_(intensity),
           castsShadows_(casts_shadows), shadowBias_(shadow_bias) {}
 
-    [[nodiscard]] std::string getName() const override {
+    [[nodiscard]] static std::string getName() {
         return "DirectionalLight";
     }
 
@@ -79,6 +79,8 @@ public:
     }
 
 private:
+    friend class SceneSnapshot;
+
     glm::vec3 direction_;
     glm::vec3 color_;
     f32 intensity_;
@@ -95,7 +97,7 @@ public:
         : color_(color), intensity_(intensity), castsShadows_(casts_shadows), shadowBias_(shadow_bias),
           nearPlane_(near_plane), farPlane_(far_plane) {}
 
-    [[nodiscard]] std::string getName() const override {
+    [[nodiscard]] static std::string getName() {
         return "PointLight";
     }
 
@@ -148,6 +150,8 @@ public:
     }
 
 private:
+    friend class SceneSnapshot;
+
     glm::vec3 color_;
     f32 intensity_;
     bool castsShadows_;
@@ -4,6 +4,8 @@
 #include "ivy/scene/components/component.h"
 #include "ivy/resources/model_resource.h"
 #include "ivy/resources/resource_manager.h"
+#include "ivy/scene/components/transform.h"
+#include "ivy/math/bounds.h"
 
 namespace ivy {
 
@@ -15,17 +17,76 @@ public:
     explicit Model(const ModelResource &mesh_resource)
         : modelResource_(mesh_resource) {}
 
-    [[nodiscard]] std::string getName() const override {
+    [[nodiscard]] static std::string getName() {
         return "Model";
     }
 
     [[nodiscard]] const std::vector<gfx::Mesh> &getMeshes(u32 lod = 0) const {
-        lod = std::min(lod, ivy::ResourceManager::MAX_LOD);
-        return modelResource_.get().at(lod);
+        return getLodData(lod).meshes;
+    }
+
+    /**
+     * \brief Get the bounding box of every mesh in a LOD of the model, in model space. This is calculated when the
+     * model is loaded, so it is empty until an asynchronously loaded model has finished loading.
+     * \param lod The LOD level
+     * \return Bounding box
+     */
+    [[nodiscard]] const AABB &getBounds(u32 lod = 0) const {
+        return getLodData(lod).bounds;
+    }
+
+    /**
+     * \brief Get the bounding sphere of every mesh in a LOD of the model, in model space
+     * \param lod The LOD level
+     * \return Bounding sphere
+     */
+    [[nodiscard]] const Sphere &getBoundingSphere(u32 lod = 0) const {
+        return getLodData(lod).boundingSphere;
+    }
+
+    /**
+     * \brief Get the bounding box of a LOD of the model in world space
+     * \param transform The transform of the entity, its world matrix must be up to date
+     * \param lod The LOD level
+     * \return Bounding box
+     */
+    [[nodiscard]] AABB getWorldBounds(const Transform &transform, u32 lod = 0) const {
+        return getBounds(lod).transformed(transform.getModelMatrix());
+    }
+
+    /**
+     * \brief Get the bounding sphere of a LOD of the model in world space
+     * \param transform The transform of the entity, its world matrix must be up to date
+     * \param lod The LOD level
+     * \return Bounding sphere
+     */
+    [[nodiscard]] Sphere getWorldBoundingSphere(const Transform &transform, u32 lod = 0) const {
+        return getBoundingSphere(lod).transformed(transform.getModelMatrix());
+    }
+
+    /**
+     * \brief Get the LOD level the model was last drawn with, LOD selection uses it to avoid switching back and forth
+     * \return LOD level
+     */
+    [[nodiscard]] u32 getLod() const {
+        return lod_;
+    }
+
+    void setLod(u32 lod) {
+        lod_ = std::min(lod, ResourceManager::MAX_LOD);
+    }
+
+    [[nodiscard]] const ModelResource &getModelResource() const {
+        return modelResource_;
     }
 
 private:
+    [[nodiscard]] const ModelLod &getLodData(u32 lod) const {
+        return modelResource_.get().at(std::min(lod, ResourceManager::MAX_LOD));
+    }
+
     ModelResource modelResource_;
+    u32 lod_ = 0;
     // TODO: shadow options, lighting options, etc.
 };
 
@@ -1,6 +1,7 @@
 #ifndef IVY_TRANSFORM_H
 #define IVY_TRANSFORM_H
 
+#include "ivy/types.h"
 #include "ivy/scene/components/component.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -9,31 +10,84 @@
 namespace ivy {
 
 /**
- * \brief Entity component with transformation data
+ * \brief Entity component with transformation data. Position, rotation and scale are relative to the parent transform
+ * if there is one. The local, world and normal matrices are cached and only recomputed by Scene::updateTransforms when
+ * the transform or one of its ancestors has changed.
  */
 class Transform : public Component {
 public:
     explicit Transform(glm::vec3 position = glm::vec3(0),
                        glm::vec3 rotation = glm::vec3(0),
                        glm::vec3 scale = glm::vec3(1))
-        : position_(position), rotation_(rotation), scale_(scale) {}
+        : position_(position), rotation_(rotation), orientation_(rotation), scale_(scale) {}
 
-    [[nodiscard]] std::string getName() const override {
+    [[nodiscard]] static std::string getName() {
         return "Transform";
     }
 
-    [[nodiscard]] glm::mat4 getModelMatrix() const {
+    /**
+     * \brief Calculate the matrix for this transform relative to its parent
+     * \return Local matrix
+     */
+    [[nodiscard]] glm::mat4 calculateLocalMatrix() const {
         return glm::translate(glm::mat4(1), position_) *
                glm::mat4_cast(getOrientation()) *
                glm::scale(glm::mat4(1), scale_);
     }
 
+    /**
+     * \brief Get the cached local to world matrix, as of the last Scene::updateTransforms
+     * \return Model matrix
+     */
+    [[nodiscard]] const glm::mat4 &getModelMatrix() const {
+        return worldMatrix_;
+    }
+
+    /**
+     * \brief Get the cached matrix for transforming normals to world space, as of the last Scene::updateTransforms
+     * \return Normal matrix
+     */
+    [[nodiscard]] const glm::mat4 &getNormalMatrix() const {
+        return normalMatrix_;
+    }
+
+    /**
+     * \brief Get the world space position, as of the last Scene::updateTransforms
+     * \return World position
+     */
+    [[nodiscard]] glm::vec3 getWorldPosition() const {
+        return worldMatrix_[3];
+    }
+
+    /**
+     * \brief Get a counter that is incremented every time Scene::updateTransforms changes the world matrix, used to
+     * find out if the world matrix changed since it was last looked at
+     * \return World matrix version
+     */
+    [[nodiscard]] u32 getWorldVersion() const {
+        return worldVersion_;
+    }
+
+    /**
+     * \return Whether or not the transform changed since the last Scene::updateTransforms
+     */
+    [[nodiscard]] bool isDirty() const {
+        return dirty_;
+    }
+
+    /**
+     * \return Whether or not this transform has a parent
+     */
+    [[nodiscard]] bool hasParent() const {
+        return parentIdx_ != NO_PARENT;
+    }
+
     [[nodiscard]] glm::vec3 getPosition() const {
         return position_;
     }
 
     [[nodiscard]] glm::quat getOrientation() const {
-        return glm::quat(getRotation());
+        return orientation_;
     }
 
     [[nodiscard]] glm::vec3 getRotation() const {
@@ -58,6 +112,7 @@ public:
 
     void setPosition(glm::vec3 position) {
         position_ = position;
+        dirty_ = true;
     }
 
     void setOrientation(glm::quat orientation) {
@@ -66,6 +121,8 @@ public:
 
     void setRotation(glm::vec3 rotation) {
         rotation_ = glm::mod(rotation, glm::vec3(glm::two_pi<f32>()));
+        orientation_ = glm::quat(rotation_);
+        dirty_ = true;
     }
 
     void addRotation(glm::vec3 rotation) {
@@ -74,6 +131,7 @@ public:
 
     void setScale(glm::vec3 scale) {
         scale_ = scale;
+        dirty_ = true;
     }
 
     void addPosition(glm::vec3 position) {
@@ -85,9 +143,24 @@ public:
     constexpr static glm::vec3 RIGHT   = glm::vec3(1, 0, 0);
 
 private:
+    friend class Scene;
+
+    static constexpr u32 NO_PARENT = ~0u;
+
     glm::vec3 position_;
     glm::vec3 rotation_;
+    glm::quat orientation_; // Kept in sync with rotation_ so it isn't rebuilt from Euler angles every use
     glm::vec3 scale_;
+
+    // Parent entity, set through Scene::setParent
+    u32 parentIdx_ = NO_PARENT;
+    u32 parentVersion_ = 0;
+
+    bool dirty_ = true;
+    glm::mat4 localMatrix_ = glm::mat4(1);
+    glm::mat4 worldMatrix_ = glm::mat4(1);
+    glm::mat4 normalMatrix_ = glm::mat4(1);
+    u32 worldVersion_ = 0;
 };
 
 }
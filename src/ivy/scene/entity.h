@@ -1,16 +1,25 @@
 #ifndef IVY_ENTITY_H
 #define IVY_ENTITY_H
 
+#include "ivy/types.h"
 #include "ivy/scene/components/component.h"
-#include <unordered_map>
-#include <memory>
-#include <typeindex>
+#include "ivy/scene/tag.h"
 #include <ostream>
+#include <string>
 
 namespace ivy {
 
+class Scene;
+class Archetype;
+
+/**
+ * \brief An entity record, the components themselves are stored in the archetype tables of the parent scene.
+ * Pointers to components are invalidated when any entity in the scene gains or loses a component, or is deleted.
+ */
 class Entity {
 public:
+    Entity() = default;
+
     /**
      * \brief Search for and get a certain component from the entity
      * \tparam T The component type
@@ -28,7 +37,7 @@ public:
     const T *getComponentConst() const;
 
     /**
-     * \brief Set a component for the entity
+     * \brief Set a component for the entity, this moves the entity to another archetype if it didn't have T
      * \tparam T The component type
      * \param component The data to set for the component
      */
@@ -36,7 +45,7 @@ public:
     void setComponent(const T &component = T{});
 
     /**
-     * \brief Remove a component from the entity
+     * \brief Remove a component from the entity, this moves the entity to another archetype if it had T
      * \tparam T The component type
      */
     template <typename T>
@@ -58,23 +67,48 @@ public:
     template <typename... Components>
     bool hasAnyComponents() const;
 
-    void setTag(const std::string &tag) {
-        tag_ = tag;
+    /**
+     * \brief Replace the entity's tags with a single tag
+     * \param tag The tag
+     */
+    void setTag(Tag tag);
+
+    /**
+     * \brief Add a tag to the entity, an entity can have up to TagSet::MAX_TAGS tags
+     * \param tag The tag
+     */
+    void addTag(Tag tag);
+
+    /**
+     * \brief Remove a tag from the entity
+     * \param tag The tag
+     */
+    void removeTag(Tag tag);
+
+    [[nodiscard]] bool hasTag(Tag tag) const {
+        return tags_.contains(tag);
     }
 
-    bool hasTag(const std::string &tag) const {
-        return tag_ == tag;
+    [[nodiscard]] const TagSet &getTags() const {
+        return tags_;
     }
 
     friend std::ostream &operator<<(std::ostream &os, const Entity &entity);
 
 private:
-    std::string tag_;
-    std::unordered_map<std::type_index, std::shared_ptr<Component>> components_;
+    friend class Scene;
+    friend class SceneSnapshot;
+
+    Entity(Scene *scene, u32 entity_idx)
+        : scene_(scene), entityIdx_(entity_idx) {}
+
+    Scene *scene_ = nullptr;
+    Archetype *archetype_ = nullptr;
+    u32 entityIdx_ = 0;
+    u32 row_ = 0;
+    TagSet tags_;
 };
 
 }
 
-#include "entity.inl"
-
 #endif // IVY_ENTITY_H
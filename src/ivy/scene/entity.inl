@@ -1,4 +1,5 @@
 #include "entity.h"
+#include "scene.h"
 
 namespace ivy {
 
@@ -6,60 +7,72 @@ template<typename T>
 T *Entity::getComponent() const {
     static_assert(std::is_base_of<Component, T>(), "T is not a valid component");
 
-    auto it = components_.find(typeid(T));
-    if (it != components_.end()) {
-        return static_cast<T*>(it->second.get());
-    }
-
-    return nullptr;
+    return archetype_->getComponent<T>(row_);
 }
 
 template<typename T>
 const T *Entity::getComponentConst() const {
     static_assert(std::is_base_of<Component, T>(), "T is not a valid component");
 
-    auto it = components_.find(typeid(T));
-    if (it != components_.end()) {
-        return static_cast<T*>(it->second.get());
-    }
-
-    return nullptr;
+    return archetype_->getComponent<T>(row_);
 }
 
 template<typename T>
 void Entity::setComponent(const T &component) {
     static_assert(std::is_base_of<Component, T>(), "T is not a valid component");
 
-    components_[typeid(T)] = std::make_shared<T>(component);
+    scene_->setComponent(*this, component);
 }
 
 template<typename T>
 void Entity::removeComponent() {
     static_assert(std::is_base_of<Component, T>(), "T is not a valid component");
 
-    components_.erase(typeid(T));
+    scene_->removeComponent<T>(*this);
 }
 
 template<typename... Components>
 bool Entity::hasAllComponents() const {
-    return (... && getComponent<Components>());
+    return (... && archetype_->hasComponent<Components>());
 }
 
 template<typename... Components>
 bool Entity::hasAnyComponents() const {
-    return (... || getComponent<Components>());
+    return (... || archetype_->hasComponent<Components>());
+}
+
+inline void Entity::setTag(Tag tag) {
+    scene_->clearTags(*this);
+    scene_->addTag(*this, tag);
+}
+
+inline void Entity::addTag(Tag tag) {
+    scene_->addTag(*this, tag);
+}
+
+inline void Entity::removeTag(Tag tag) {
+    scene_->removeTag(*this, tag);
 }
 
 inline std::ostream &operator<<(std::ostream &os, const Entity &entity) {
-    os << "[ tag: " << entity.tag_ << ", components: [ ";
+    os << "[ tags: [ ";
+    for (u32 i = 0; i < entity.tags_.size(); ++i) {
+        os << (i == 0 ? "" : ", ") << entity.tags_[i].getName();
+    }
+    os << " ], components: [ ";
 
     bool first = true;
-    for (auto &c : entity.components_) {
+    for (u32 typeId = 0; typeId < MAX_COMPONENT_TYPES; ++typeId) {
+        const ComponentPoolBase *pool = entity.archetype_->getPool(typeId);
+        if (!pool) {
+            continue;
+        }
+
         if (first) {
-            os << c.second->getName();
+            os << pool->getComponentName();
             first = false;
         } else {
-            os << ", " << c.second->getName();
+            os << ", " << pool->getComponentName();
         }
     }
     os << " ] ]";
@@ -0,0 +1,74 @@
+#include "entity_command_buffer.h"
+
+namespace ivy {
+
+DeferredEntity EntityCommandBuffer::createEntity() {
+    Command command = {};
+    command.type = CommandType::CREATE_ENTITY;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    commands_.emplace_back(command);
+
+    return DeferredEntity{numCreated_++};
+}
+
+void EntityCommandBuffer::deleteEntity(EntityHandle entity) {
+    Command command = {};
+    command.type = CommandType::DELETE_ENTITY;
+    command.deferred = false;
+    command.entityIdx = entity.entityIdx_;
+    command.version = entity.version_;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    commands_.emplace_back(command);
+}
+
+std::vector<EntityHandle> EntityCommandBuffer::playback(Scene &scene) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Make room for all the new entities at once
+    std::vector<EntityHandle> created;
+    created.reserve(numCreated_);
+    scene.reserve(numCreated_);
+
+    for (const Command &command : commands_) {
+        if (command.type == CommandType::CREATE_ENTITY) {
+            created.emplace_back(scene.createEntity());
+            continue;
+        }
+
+        EntityHandle entity = command.deferred ? created[command.entityIdx]
+                              : EntityHandle(scene, command.entityIdx, command.version);
+
+        switch (command.type) {
+            case CommandType::DELETE_ENTITY:
+                scene.deleteEntity(entity);
+                break;
+            case CommandType::SET_COMPONENT:
+                if (Entity *e = *entity) {
+                    command.setComponent(*e, *componentData_[command.typeId], command.componentIdx);
+                }
+                break;
+            case CommandType::REMOVE_COMPONENT:
+                if (Entity *e = *entity) {
+                    command.removeComponent(*e);
+                }
+                break;
+            case CommandType::CREATE_ENTITY:
+                break;
+        }
+    }
+
+    commands_.clear();
+    componentData_.clear();
+    numCreated_ = 0;
+
+    return created;
+}
+
+bool EntityCommandBuffer::empty() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return commands_.empty();
+}
+
+}
@@ -0,0 +1,127 @@
+#ifndef IVY_ENTITY_COMMAND_BUFFER_H
+#define IVY_ENTITY_COMMAND_BUFFER_H
+
+#include "ivy/types.h"
+#include "ivy/scene/scene.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ivy {
+
+/**
+ * \brief Refers to an entity that will be created when an entity command buffer is played back
+ */
+struct DeferredEntity {
+    u32 id;
+};
+
+/**
+ * \brief Records structural changes to a scene so they can be applied later in one batch, for example after iterating
+ * over the scene. Commands can be recorded from any thread, and are applied in the order they were recorded.
+ */
+class EntityCommandBuffer {
+public:
+    EntityCommandBuffer() = default;
+    EntityCommandBuffer(const EntityCommandBuffer &) = delete;
+    EntityCommandBuffer &operator=(const EntityCommandBuffer &) = delete;
+
+    /**
+     * \brief Record the creation of an entity
+     * \return A reference to the entity that can be used to record more commands for it
+     */
+    DeferredEntity createEntity();
+
+    /**
+     * \brief Record the deletion of an entity
+     * \param entity The entity to delete
+     */
+    void deleteEntity(EntityHandle entity);
+
+    /**
+     * \brief Record setting a component for an existing entity, the component is copied into the command buffer
+     * \tparam T The component type
+     * \param entity The entity
+     * \param component The data to set for the component
+     */
+    template <typename T>
+    void setComponent(EntityHandle entity, const T &component = T{});
+
+    /**
+     * \brief Record setting a component for an entity created by this command buffer
+     * \tparam T The component type
+     * \param entity The entity
+     * \param component The data to set for the component
+     */
+    template <typename T>
+    void setComponent(DeferredEntity entity, const T &component = T{});
+
+    /**
+     * \brief Record removing a component from an existing entity
+     * \tparam T The component type
+     * \param entity The entity
+     */
+    template <typename T>
+    void removeComponent(EntityHandle entity);
+
+    /**
+     * \brief Apply every recorded command to the scene and clear the command buffer. Must not be called while the scene
+     * is being iterated over.
+     * \param scene The scene the commands were recorded for
+     * \return Handles to the created entities, in the order they were recorded
+     */
+    std::vector<EntityHandle> playback(Scene &scene);
+
+    /**
+     * \return Whether or not there are no recorded commands
+     */
+    [[nodiscard]] bool empty();
+
+private:
+    enum class CommandType {
+        CREATE_ENTITY,
+        DELETE_ENTITY,
+        SET_COMPONENT,
+        REMOVE_COMPONENT
+    };
+
+    using SetComponentFunc_t = void (*)(Entity &entity, ComponentPoolBase &pool, u32 component_idx);
+    using RemoveComponentFunc_t = void (*)(Entity &entity);
+
+    struct Command {
+        CommandType type;
+        bool deferred;       // Whether entityIdx is a DeferredEntity id or an entity index
+        u32 entityIdx;
+        u32 version;
+        u32 typeId;          // Component type for SET_COMPONENT
+        u32 componentIdx;    // Index of the component data in its pool for SET_COMPONENT
+        SetComponentFunc_t setComponent;
+        RemoveComponentFunc_t removeComponent;
+    };
+
+    /**
+     * \brief Record a command that sets a component
+     * \tparam T The component type
+     * \param command The command with the entity filled in
+     * \param component The data to set for the component
+     */
+    template <typename T>
+    void recordSetComponent(Command command, const T &component);
+
+    template <typename T>
+    static void setComponentFromPool(Entity &entity, ComponentPoolBase &pool, u32 component_idx);
+
+    template <typename T>
+    static void removeComponentFromEntity(Entity &entity);
+
+    std::mutex mutex_;
+    std::vector<Command> commands_;
+    std::vector<std::unique_ptr<ComponentPoolBase>> componentData_;
+    u32 numCreated_ = 0;
+};
+
+}
+
+#include "entity_command_buffer.inl"
+
+#endif // IVY_ENTITY_COMMAND_BUFFER_H
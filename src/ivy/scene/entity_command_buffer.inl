@@ -0,0 +1,75 @@
+#include "entity_command_buffer.h"
+
+namespace ivy {
+
+template<typename T>
+void EntityCommandBuffer::setComponent(EntityHandle entity, const T &component) {
+    static_assert(std::is_base_of<Component, T>(), "T is not a valid component");
+
+    Command command = {};
+    command.type = CommandType::SET_COMPONENT;
+    command.deferred = false;
+    command.entityIdx = entity.entityIdx_;
+    command.version = entity.version_;
+    recordSetComponent(command, component);
+}
+
+template<typename T>
+void EntityCommandBuffer::setComponent(DeferredEntity entity, const T &component) {
+    static_assert(std::is_base_of<Component, T>(), "T is not a valid component");
+
+    Command command = {};
+    command.type = CommandType::SET_COMPONENT;
+    command.deferred = true;
+    command.entityIdx = entity.id;
+    recordSetComponent(command, component);
+}
+
+template<typename T>
+void EntityCommandBuffer::removeComponent(EntityHandle entity) {
+    static_assert(std::is_base_of<Component, T>(), "T is not a valid component");
+
+    Command command = {};
+    command.type = CommandType::REMOVE_COMPONENT;
+    command.deferred = false;
+    command.entityIdx = entity.entityIdx_;
+    command.version = entity.version_;
+    command.removeComponent = &removeComponentFromEntity<T>;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    commands_.emplace_back(command);
+}
+
+template<typename T>
+void EntityCommandBuffer::recordSetComponent(Command command, const T &component) {
+    command.typeId = component_type_id<T>();
+    command.setComponent = &setComponentFromPool<T>;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Component data is kept in one pool per type so recording doesn't allocate per command
+    if (componentData_.size() <= command.typeId) {
+        componentData_.resize(command.typeId + 1);
+    }
+    if (!componentData_[command.typeId]) {
+        componentData_[command.typeId] = ComponentPool<T>::create();
+    }
+
+    auto &components = static_cast<ComponentPool<T> &>(*componentData_[command.typeId]).getComponents();
+    command.componentIdx = (u32) components.size();
+    components.emplace_back(component);
+
+    commands_.emplace_back(command);
+}
+
+template<typename T>
+void EntityCommandBuffer::setComponentFromPool(Entity &entity, ComponentPoolBase &pool, u32 component_idx) {
+    entity.setComponent(static_cast<ComponentPool<T> &>(pool).getComponents()[component_idx]);
+}
+
+template<typename T>
+void EntityCommandBuffer::removeComponentFromEntity(Entity &entity) {
+    entity.removeComponent<T>();
+}
+
+}
@@ -0,0 +1,34 @@
+#include "prefab.h"
+
+namespace ivy {
+
+Prefab::Prefab()
+    : archetype_(std::make_unique<Archetype>(ComponentMask())) {
+    archetype_->addEntity(0);
+}
+
+void Prefab::changeMask(const ComponentMask &mask, std::unique_ptr<ComponentPoolBase> (*create_pool)()) {
+    if (mask == getMask()) {
+        return;
+    }
+
+    auto archetype = std::make_unique<Archetype>(mask);
+    for (u32 typeId = 0; typeId < MAX_COMPONENT_TYPES; ++typeId) {
+        if (!mask.test(typeId)) {
+            continue;
+        }
+
+        if (ComponentPoolBase *pool = archetype_->getPool(typeId)) {
+            std::unique_ptr<ComponentPoolBase> newPool = pool->createEmpty();
+            pool->moveTo(0, *newPool);
+            archetype->setPool(typeId, std::move(newPool));
+        } else if (create_pool) {
+            archetype->setPool(typeId, create_pool());
+        }
+    }
+
+    archetype->addEntity(0);
+    archetype_ = std::move(archetype);
+}
+
+}
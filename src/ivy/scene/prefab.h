@@ -0,0 +1,88 @@
+#ifndef IVY_PREFAB_H
+#define IVY_PREFAB_H
+
+#include "ivy/scene/archetype.h"
+#include "ivy/scene/tag.h"
+#include <memory>
+#include <vector>
+
+namespace ivy {
+
+/**
+ * \brief A template for creating many entities with the same components, see Scene::createEntities
+ */
+class Prefab {
+public:
+    Prefab();
+
+    Prefab(const Prefab &) = delete;
+    Prefab &operator=(const Prefab &) = delete;
+
+    /**
+     * \brief Get a component from the prefab
+     * \tparam T The component type
+     * \return A pointer to the component if found, otherwise nullptr
+     */
+    template <typename T>
+    T *getComponent();
+
+    /**
+     * \brief Set a component for the prefab
+     * \tparam T The component type
+     * \param component The data to set for the component
+     */
+    template <typename T>
+    void setComponent(const T &component = T{});
+
+    /**
+     * \brief Remove a component from the prefab
+     * \tparam T The component type
+     */
+    template <typename T>
+    void removeComponent();
+
+    /**
+     * \brief Replace the prefab's tags with a single tag
+     * \param tag The tag
+     */
+    void setTag(Tag tag) {
+        tags_.clear();
+        tags_.emplace_back(tag);
+    }
+
+    void addTag(Tag tag) {
+        tags_.emplace_back(tag);
+    }
+
+    [[nodiscard]] const std::vector<Tag> &getTags() const {
+        return tags_;
+    }
+
+    /**
+     * \brief Get the set of component types in the prefab
+     * \return Component mask
+     */
+    [[nodiscard]] const ComponentMask &getMask() const {
+        return archetype_->getMask();
+    }
+
+private:
+    friend class Scene;
+
+    /**
+     * \brief Move the components into an archetype with a different set of component types
+     * \param mask The new component mask
+     * \param create_pool Used to create the pool for a component type that isn't in the prefab yet, can be nullptr
+     */
+    void changeMask(const ComponentMask &mask, std::unique_ptr<ComponentPoolBase> (*create_pool)());
+
+    // Holds a single row with the prefab's components
+    std::unique_ptr<Archetype> archetype_;
+    std::vector<Tag> tags_;
+};
+
+}
+
+#include "prefab.inl"
+
+#endif // IVY_PREFAB_H
@@ -0,0 +1,36 @@
+#include "prefab.h"
+
+namespace ivy {
+
+template<typename T>
+T *Prefab::getComponent() {
+    static_assert(std::is_base_of<Component, T>(), "T is not a valid component");
+
+    return archetype_->getComponent<T>(0);
+}
+
+template<typename T>
+void Prefab::setComponent(const T &component) {
+    static_assert(std::is_base_of<Component, T>(), "T is not a valid component");
+
+    if (T *existing = getComponent<T>()) {
+        *existing = component;
+        return;
+    }
+
+    ComponentMask mask = getMask();
+    mask.set(component_type_id<T>());
+    changeMask(mask, &ComponentPool<T>::create);
+    archetype_->getPool<T>().getComponents().emplace_back(component);
+}
+
+template<typename T>
+void Prefab::removeComponent() {
+    static_assert(std::is_base_of<Component, T>(), "T is not a valid component");
+
+    ComponentMask mask = getMask();
+    mask.reset(component_type_id<T>());
+    changeMask(mask, nullptr);
+}
+
+}
@@ -1,8 +1,26 @@
 #include "scene.h"
 #include "ivy/log.h"
+#include "ivy/scene/components/transform.h"
+#include <algorithm>
 
 namespace ivy {
 
+/**
+ * \brief Calculate the normal matrix (inverse transpose of the upper 3x3) of a translate * rotate * scale matrix
+ * \param local The matrix, its first three columns must be orthogonal
+ * \return The normal matrix
+ */
+static glm::mat4 calculate_normal_matrix(const glm::mat4 &local) {
+    // Column i is rotation column i times scale i, so dividing by its squared length gives rotation column i / scale i
+    glm::mat4 normal(1);
+    for (u32 i = 0; i < 3; ++i) {
+        glm::vec3 column = local[i];
+        normal[i] = glm::vec4(column / glm::dot(column, column), 0);
+    }
+
+    return normal;
+}
+
 EntityHandle::EntityHandle(Scene &scene)
     : scene_(scene), entityIdx_(-1), version_(Scene::VERSION_INVALID_BIT) {}
 
@@ -61,44 +79,521 @@ EntityHandle SceneIterator::operator*() {
     return EntityHandle(scene_, entityIdx_, scene_.versions_.at(entityIdx_));
 }
 
+Scene::Scene() {
+    // Every entity starts out in the empty archetype
+    archetypes_.emplace_back(std::make_unique<Archetype>(ComponentMask()));
+    archetypeIndices_[ComponentMask()] = 0;
+}
+
+SceneViewIterator::SceneViewIterator(const SceneView &view, u32 archetype_idx, u32 row)
+    : view_(&view), archetypeIdx_(archetype_idx), row_(row) {
+    skipEmptyArchetypes();
+}
+
+SceneViewIterator &SceneViewIterator::operator++() {
+    ++row_;
+    skipEmptyArchetypes();
+
+    return *this;
+}
+
+EntityHandle SceneViewIterator::operator*() {
+    u32 entityIdx = view_->archetypes_[archetypeIdx_]->getEntities()[row_];
+    return EntityHandle(view_->scene_, entityIdx, view_->scene_.versions_[entityIdx]);
+}
+
+void SceneViewIterator::skipEmptyArchetypes() {
+    while (archetypeIdx_ < view_->archetypes_.size() &&
+           row_ >= view_->archetypes_[archetypeIdx_]->size()) {
+        ++archetypeIdx_;
+        row_ = 0;
+    }
+}
+
+bool SceneView::matches(const ComponentMask &mask) const {
+    if (match_ == Match::ALL) {
+        return (mask & mask_) == mask_;
+    } else {
+        return (mask & mask_).any();
+    }
+}
+
+SceneViewIterator SceneView::begin() const {
+    return SceneViewIterator(*this, 0, 0);
+}
+
+SceneViewIterator SceneView::end() const {
+    return SceneViewIterator(*this, archetypes_.size(), 0);
+}
+
+size_t SceneView::size() const {
+    size_t count = 0;
+    for (const Archetype *archetype : archetypes_) {
+        count += archetype->size();
+    }
+
+    return count;
+}
+
+bool SceneView::empty() const {
+    return begin() == end();
+}
+
 EntityHandle Scene::createEntity() {
+    checkStructuralChangeAllowed();
+
+    u32 idx = allocateEntity();
+
+    Archetype &archetype = *archetypes_.front();
+    entities_[idx].archetype_ = &archetype;
+    entities_[idx].row_ = archetype.addEntity(idx);
+
+    notifyEntityChanged(idx);
+
+    return EntityHandle(*this, idx, versions_[idx]);
+}
+
+Span<EntityHandle> Scene::createEntities(u32 count, const Prefab &prefab) {
+    checkStructuralChangeAllowed();
+
+    reserve(count);
+    createdEntities_.clear();
+    createdEntities_.reserve(count);
+
+    // Copy the components into the archetype one pool at a time
+    Archetype &archetype = getArchetype(prefab.getMask(), *prefab.archetype_, nullptr);
+    u32 firstRow = archetype.size();
+    archetype.reserve(firstRow + count);
+    for (u32 typeId = 0; typeId < MAX_COMPONENT_TYPES; ++typeId) {
+        if (ComponentPoolBase *pool = archetype.getPool(typeId)) {
+            pool->appendCopies(*prefab.archetype_->getPool(typeId), 0, count);
+        }
+    }
+
+    for (Tag tag : prefab.getTags()) {
+        if (tag.getId() >= taggedEntities_.size()) {
+            taggedEntities_.resize(tag.getId() + 1);
+        }
+        taggedEntities_[tag.getId()].reserve(taggedEntities_[tag.getId()].size() + count);
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        u32 idx = allocateEntity();
+
+        Entity &entity = entities_[idx];
+        entity.archetype_ = &archetype;
+        entity.row_ = archetype.addEntity(idx);
+        for (Tag tag : prefab.getTags()) {
+            addTag(entity, tag);
+        }
+
+        createdEntities_.emplace_back(*this, idx, versions_[idx]);
+        notifyEntityChanged(idx);
+    }
+
+    // Pools may have been reallocated
+    transformOrderDirty_ = true;
+
+    return Span<EntityHandle>(createdEntities_.data(), createdEntities_.size());
+}
+
+void Scene::reserve(u32 count) {
+    // Deleted entities are re-used before new ones are added
+    size_t needed = entities_.size() + count - std::min<size_t>(count, deletedIndices_.size());
+    if (needed > entities_.capacity()) {
+        needed = std::max(needed, entities_.capacity() * 2);
+        entities_.reserve(needed);
+        versions_.reserve(needed);
+    }
+}
+
+void Scene::deleteEntity(EntityHandle entity) {
+    checkStructuralChangeAllowed();
+
+    if (entity) {
+        deletedIndices_.emplace_back(entity.entityIdx_);
+        versions_[entity.entityIdx_] |= VERSION_INVALID_BIT;
+
+        Entity &e = entities_[entity.entityIdx_];
+        clearTags(e);
+        removeRow(*e.archetype_, e.row_);
+        e = Entity();
+
+        notifyEntityChanged(entity.entityIdx_);
+    }
+}
+
+std::vector<EntityHandle> Scene::findEntitiesWithTag(Tag tag) {
+    std::vector<EntityHandle> foundEntities;
+
+    if (tag.getId() < taggedEntities_.size()) {
+        foundEntities.reserve(taggedEntities_[tag.getId()].size());
+        forEachWithTag(tag, [&](EntityHandle entity) {
+            foundEntities.emplace_back(entity);
+        });
+    }
+
+    return foundEntities;
+}
+
+void Scene::addTag(Entity &entity, Tag tag) {
+    TagSet &tags = entity.tags_;
+    if (tags.contains(tag)) {
+        return;
+    }
+
+    if (tags.count_ >= TagSet::MAX_TAGS) {
+        Log::warn("Can't add tag '%', entities can have at most % tags", tag.getName(), TagSet::MAX_TAGS);
+        return;
+    }
+
+    if (tag.getId() >= taggedEntities_.size()) {
+        taggedEntities_.resize(tag.getId() + 1);
+    }
+
+    std::vector<u32> &tagged = taggedEntities_[tag.getId()];
+    tags.entries_[tags.count_++] = {tag.getId(), (u32) tagged.size()};
+    tagged.emplace_back(entity.entityIdx_);
+}
+
+void Scene::removeTag(Entity &entity, Tag tag) {
+    TagSet &tags = entity.tags_;
+    u32 i = tags.find(tag);
+    if (i == tags.count_) {
+        return;
+    }
+
+    // Swap remove from the tag's entity list and fix up the slot of the entity that was moved
+    std::vector<u32> &tagged = taggedEntities_[tag.getId()];
+    u32 slot = tags.entries_[i].slot;
+    if (slot + 1 != tagged.size()) {
+        u32 movedIdx = tagged.back();
+        tagged[slot] = movedIdx;
+
+        TagSet &movedTags = entities_[movedIdx].tags_;
+        movedTags.entries_[movedTags.find(tag)].slot = slot;
+    }
+    tagged.pop_back();
+
+    tags.entries_[i] = tags.entries_[--tags.count_];
+}
+
+void Scene::clearTags(Entity &entity) {
+    while (!entity.tags_.empty()) {
+        removeTag(entity, entity.tags_[0]);
+    }
+}
+
+void Scene::addListener(SceneListener *listener) {
+    listeners_.emplace_back(listener);
+}
+
+void Scene::removeListener(SceneListener *listener) {
+    listeners_.erase(std::remove(listeners_.begin(), listeners_.end(), listener), listeners_.end());
+}
+
+void Scene::notifyEntityChanged(u32 entity_idx) {
+    for (SceneListener *listener : listeners_) {
+        listener->onEntityChanged(EntityHandle(*this, entity_idx, versions_[entity_idx]));
+    }
+}
+
+void Scene::notifyWorldTransformChanged(u32 entity_idx) {
+    for (SceneListener *listener : listeners_) {
+        listener->onWorldTransformChanged(EntityHandle(*this, entity_idx, versions_[entity_idx]));
+    }
+}
+
+u32 Scene::allocateEntity() {
     u32 idx;
-    u32 version;
     if (!deletedIndices_.empty()) {
         // Re-use the memory of a deleted entity
         idx = deletedIndices_.back();
         deletedIndices_.pop_back();
         versions_[idx] = (versions_[idx] & ~VERSION_INVALID_BIT) + 1;
-        version = versions_[idx];
+        entities_[idx] = Entity(this, idx);
     } else {
         idx = entities_.size();
-        version = 0;
 
-        entities_.emplace_back();
+        entities_.push_back(Entity(this, idx));
         versions_.emplace_back();
     }
 
-    return EntityHandle(*this, idx, version);
+    return idx;
 }
 
-void Scene::deleteEntity(EntityHandle entity) {
-    if (entity) {
-        deletedIndices_.emplace_back(entity.entityIdx_);
-        versions_[entity.entityIdx_] |= VERSION_INVALID_BIT;
-        entities_[entity.entityIdx_] = Entity();
+Archetype &Scene::getArchetype(const ComponentMask &mask, const Archetype &src, PoolFactory_t create_pool) {
+    auto it = archetypeIndices_.find(mask);
+    if (it != archetypeIndices_.end()) {
+        return *archetypes_[it->second];
+    }
+
+    auto archetype = std::make_unique<Archetype>(mask);
+    for (u32 typeId = 0; typeId < MAX_COMPONENT_TYPES; ++typeId) {
+        if (!mask.test(typeId)) {
+            continue;
+        }
+
+        if (ComponentPoolBase *pool = src.getPool(typeId)) {
+            archetype->setPool(typeId, pool->createEmpty());
+        } else if (create_pool) {
+            archetype->setPool(typeId, create_pool());
+        } else {
+            Log::fatal("No component pool available for component type id %", typeId);
+        }
+    }
+
+    // Add the new archetype to any views that match it
+    for (auto *views : {&viewsWithAll_, &viewsWithAny_}) {
+        for (auto &view : *views) {
+            if (view.second->matches(mask)) {
+                view.second->archetypes_.emplace_back(archetype.get());
+            }
+        }
     }
+
+    archetypeIndices_[mask] = archetypes_.size();
+    archetypes_.emplace_back(std::move(archetype));
+
+    return *archetypes_.back();
 }
 
-std::vector<EntityHandle> Scene::findEntitiesWithTag(const std::string &tag) {
-    std::vector<EntityHandle> foundEntities;
+const SceneView &Scene::getView(const ComponentMask &mask, SceneView::Match match) {
+    auto &views = match == SceneView::Match::ALL ? viewsWithAll_ : viewsWithAny_;
 
-    for (EntityHandle entity : *this) {
-        if (entity->hasTag(tag)) {
-            foundEntities.emplace_back(entity);
+    auto it = views.find(mask);
+    if (it != views.end()) {
+        return *it->second;
+    }
+
+    // Create the view and fill it with the archetypes that already exist
+    auto view = std::make_unique<SceneView>(*this, mask, match);
+    for (auto &archetype : archetypes_) {
+        if (view->matches(archetype->getMask())) {
+            view->archetypes_.emplace_back(archetype.get());
         }
     }
 
-    return foundEntities;
+    return *(views[mask] = std::move(view));
+}
+
+void Scene::moveEntity(Entity &entity, Archetype &dst) {
+    Archetype &src = *entity.archetype_;
+    u32 srcRow = entity.row_;
+
+    // Move over the components that both archetypes share
+    ComponentMask shared = src.getMask() & dst.getMask();
+    for (u32 typeId = 0; typeId < MAX_COMPONENT_TYPES; ++typeId) {
+        if (shared.test(typeId)) {
+            src.getPool(typeId)->moveTo(srcRow, *dst.getPool(typeId));
+        }
+    }
+
+    entity.archetype_ = &dst;
+    entity.row_ = dst.addEntity(entity.entityIdx_);
+
+    removeRow(src, srcRow);
+}
+
+void Scene::removeRow(Archetype &archetype, u32 row) {
+    // Components moved around, so the pointers in the transform order are out of date
+    transformOrderDirty_ = true;
+
+    u32 movedEntityIdx = archetype.removeRow(row);
+    if (movedEntityIdx != Archetype::INVALID_ENTITY) {
+        entities_[movedEntityIdx].row_ = row;
+    }
+}
+
+void Scene::setParent(EntityHandle child, EntityHandle parent) {
+    Transform *childTransform = child ? child->getComponent<Transform>() : nullptr;
+    if (!childTransform) {
+        Log::warn("Can't set the parent of an entity without a Transform component");
+        return;
+    }
+
+    if (!parent) {
+        childTransform->parentIdx_ = Transform::NO_PARENT;
+    } else {
+        if (!parent->getComponent<Transform>()) {
+            Log::warn("Can't parent an entity to an entity without a Transform component");
+            return;
+        }
+
+        // Walk up from the parent to make sure we don't create a cycle
+        for (u32 idx = parent.entityIdx_; idx != Transform::NO_PARENT;) {
+            if (idx == child.entityIdx_) {
+                Log::warn("Can't parent an entity to one of its descendants");
+                return;
+            }
+
+            Entity &ancestor = entities_[idx];
+            Transform *transform = ancestor.archetype_ ? ancestor.getComponent<Transform>() : nullptr;
+            idx = transform ? transform->parentIdx_ : Transform::NO_PARENT;
+        }
+
+        childTransform->parentIdx_ = parent.entityIdx_;
+        childTransform->parentVersion_ = parent.version_;
+    }
+
+    childTransform->dirty_ = true;
+    transformOrderDirty_ = true;
+}
+
+EntityHandle Scene::getParent(EntityHandle child) {
+    Transform *childTransform = child ? child->getComponent<Transform>() : nullptr;
+    if (!childTransform || !childTransform->hasParent()) {
+        return EntityHandle(*this);
+    }
+
+    return EntityHandle(*this, childTransform->parentIdx_, childTransform->parentVersion_);
+}
+
+void Scene::updateTransforms() {
+    bool updateAll = transformOrderDirty_;
+    if (transformOrderDirty_) {
+        rebuildTransformOrder();
+    }
+
+    // Gather every dirty transform so the local matrices can be computed as a batch
+    // transformChanged_ is 1 for dirty transforms and 2 for transforms that changed because of an ancestor
+    std::fill(transformChanged_.begin(), transformChanged_.end(), 0);
+    transformBatch_.clear();
+    dirtyTransformSlots_.clear();
+    for (u32 slot = 0; slot < transformOrder_.size(); ++slot) {
+        const TransformNode &node = transformOrder_[slot];
+        Transform &transform = *node.transform;
+
+        // The parent was changed by overwriting the transform, so the order is out of date
+        if (transform.parentIdx_ != node.parentIdx) {
+            transformOrderDirty_ = true;
+            updateTransforms();
+            return;
+        }
+
+        if (transform.dirty_) {
+            transformBatch_.add(transform.position_, transform.orientation_, transform.scale_);
+            dirtyTransformSlots_.emplace_back(slot);
+            transformChanged_[slot] = 1;
+        }
+    }
+
+    batchModelMatrices_.resize(transformBatch_.size());
+    batchNormalMatrices_.resize(transformBatch_.size());
+    compute_transform_matrices(transformBatch_, batchModelMatrices_.data(), batchNormalMatrices_.data());
+
+    for (u32 i = 0; i < dirtyTransformSlots_.size(); ++i) {
+        const TransformNode &node = transformOrder_[dirtyTransformSlots_[i]];
+        Transform &transform = *node.transform;
+
+        transform.localMatrix_ = batchModelMatrices_[i];
+        transform.dirty_ = false;
+
+        // Without a parent the local matrices are the world matrices
+        if (node.parentSlot == Transform::NO_PARENT) {
+            transform.worldMatrix_ = batchModelMatrices_[i];
+            transform.normalMatrix_ = batchNormalMatrices_[i];
+            ++transform.worldVersion_;
+            notifyWorldTransformChanged(node.entityIdx);
+        }
+    }
+
+    // Propagate down the hierarchy, parents always come before their children
+    for (u32 slot = 0; slot < transformOrder_.size(); ++slot) {
+        const TransformNode &node = transformOrder_[slot];
+        Transform &transform = *node.transform;
+        bool hasParent = node.parentSlot != Transform::NO_PARENT;
+
+        if (!hasParent) {
+            // Dirty roots are already done, but everything is recomputed after the order is rebuilt. Only the
+            // transforms whose world matrix actually moved count as changed, so rebuilding the order doesn't look like
+            // the whole scene moved.
+            if (updateAll && transformChanged_[slot] == 0 && transform.worldMatrix_ != transform.localMatrix_) {
+                transform.worldMatrix_ = transform.localMatrix_;
+                transform.normalMatrix_ = calculate_normal_matrix(transform.localMatrix_);
+                ++transform.worldVersion_;
+                notifyWorldTransformChanged(node.entityIdx);
+                transformChanged_[slot] = 2;
+            }
+            continue;
+        }
+
+        if (!updateAll && transformChanged_[slot] == 0 && transformChanged_[node.parentSlot] == 0) {
+            continue;
+        }
+
+        // The inverse transpose of a product is the product of the inverse transposes
+        const Transform &parent = *transformOrder_[node.parentSlot].transform;
+        glm::mat4 worldMatrix = parent.worldMatrix_ * transform.localMatrix_;
+        if (transformChanged_[slot] == 0 && transformChanged_[node.parentSlot] == 0 &&
+            worldMatrix == transform.worldMatrix_) {
+            continue;
+        }
+
+        transform.worldMatrix_ = worldMatrix;
+        transform.normalMatrix_ = parent.normalMatrix_ * calculate_normal_matrix(transform.localMatrix_);
+        ++transform.worldVersion_;
+        notifyWorldTransformChanged(node.entityIdx);
+        transformChanged_[slot] = std::max<u8>(transformChanged_[slot], 2);
+    }
+}
+
+void Scene::rebuildTransformOrder() {
+    transformOrder_.clear();
+    transformOrderDirty_ = false;
+
+    // Find the transform of every entity and drop parents that no longer exist
+    std::vector<Transform *> transforms(entities_.size(), nullptr);
+    forEach<Transform>([&](EntityHandle entity, Transform &transform) {
+        transforms[entity.entityIdx_] = &transform;
+    });
+
+    // Count the children of each entity, childStart[i] ends up as the first index of entity i's children
+    std::vector<u32> childStart(entities_.size() + 1, 0);
+    for (Transform *transform : transforms) {
+        if (!transform || !transform->hasParent()) {
+            continue;
+        }
+
+        u32 parentIdx = transform->parentIdx_;
+        if (parentIdx >= entities_.size() || versions_[parentIdx] != transform->parentVersion_ ||
+            !transforms[parentIdx]) {
+            transform->parentIdx_ = Transform::NO_PARENT;
+            transform->dirty_ = true;
+            continue;
+        }
+
+        ++childStart[parentIdx + 1];
+    }
+
+    for (u32 i = 1; i < childStart.size(); ++i) {
+        childStart[i] += childStart[i - 1];
+    }
+
+    std::vector<u32> children(childStart.back());
+    std::vector<u32> childCount(entities_.size(), 0);
+    for (u32 idx = 0; idx < transforms.size(); ++idx) {
+        if (transforms[idx] && transforms[idx]->hasParent()) {
+            u32 parentIdx = transforms[idx]->parentIdx_;
+            children[childStart[parentIdx] + childCount[parentIdx]++] = idx;
+        }
+    }
+
+    // Roots first, then breadth first through the children
+    for (u32 idx = 0; idx < transforms.size(); ++idx) {
+        if (transforms[idx] && !transforms[idx]->hasParent()) {
+            transformOrder_.push_back({transforms[idx], idx, Transform::NO_PARENT, Transform::NO_PARENT});
+        }
+    }
+
+    for (u32 slot = 0; slot < transformOrder_.size(); ++slot) {
+        u32 entityIdx = transformOrder_[slot].entityIdx;
+        for (u32 i = childStart[entityIdx]; i < childStart[entityIdx + 1]; ++i) {
+            transformOrder_.push_back({transforms[children[i]], children[i], entityIdx, slot});
+        }
+    }
+
+    transformChanged_.assign(transformOrder_.size(), 0);
 }
 
 SceneIterator Scene::begin() {
@@ -2,12 +2,25 @@
 #define IVY_SCENE_H
 
 #include "ivy/types.h"
+#include "ivy/consts.h"
+#include "ivy/log.h"
 #include "ivy/scene/entity.h"
+#include "ivy/scene/archetype.h"
+#include "ivy/scene/prefab.h"
+#include "ivy/utils/span.h"
+#include "ivy/math/batch_transform.h"
+#include "ivy/utils/thread_pool.h"
+#include <algorithm>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace ivy {
 
 class Scene;
+class Transform;
 
 class EntityHandle {
 public:
@@ -38,8 +51,23 @@ public:
 
     Entity *operator ->();
 
+    /**
+     * \return The index of the entity in its scene, indices of deleted entities are reused
+     */
+    [[nodiscard]] u32 getIndex() const {
+        return entityIdx_;
+    }
+
+    /**
+     * \return The version of the entity, together with the index this identifies the entity
+     */
+    [[nodiscard]] u32 getVersion() const {
+        return version_;
+    }
+
 private:
     friend class Scene;
+    friend class EntityCommandBuffer;
 
     Scene &scene_;
     u32 entityIdx_;
@@ -68,17 +96,135 @@ private:
     u32 entityIdx_;
 };
 
+class SceneView;
+
+class SceneViewIterator {
+public:
+    SceneViewIterator(const SceneView &view, u32 archetype_idx, u32 row);
+
+    bool operator==(const SceneViewIterator &rhs) const {
+        return view_ == rhs.view_ && archetypeIdx_ == rhs.archetypeIdx_ && row_ == rhs.row_;
+    }
+
+    bool operator!=(const SceneViewIterator &rhs) const {
+        return !(rhs == *this);
+    }
+
+    SceneViewIterator &operator++();
+
+    EntityHandle operator*();
+
+private:
+    /**
+     * \brief Move forward until the iterator points at an entity or the end of the view
+     */
+    void skipEmptyArchetypes();
+
+    const SceneView *view_;
+    u32 archetypeIdx_;
+    u32 row_;
+};
+
+/**
+ * \brief A cached query that keeps track of every archetype matching a set of components. Since entities are stored in
+ * their archetypes, the view stays up to date as components are set or removed and entities are deleted, and
+ * iterating it only visits matching entities. Adding or removing components or deleting entities invalidates iterators.
+ */
+class SceneView {
+public:
+    enum class Match {
+        ALL,
+        ANY
+    };
+
+    SceneView(Scene &scene, const ComponentMask &mask, Match match)
+        : scene_(scene), mask_(mask), match_(match) {}
+
+    /**
+     * \brief Check if an archetype with a given component mask belongs in this view
+     * \param mask The component mask of the archetype
+     * \return Whether or not it matches
+     */
+    [[nodiscard]] bool matches(const ComponentMask &mask) const;
+
+    /**
+     * \brief Get the archetypes in this view
+     * \return Vector of archetypes
+     */
+    [[nodiscard]] const std::vector<Archetype *> &getArchetypes() const {
+        return archetypes_;
+    }
+
+    [[nodiscard]] SceneViewIterator begin() const;
+    [[nodiscard]] SceneViewIterator end() const;
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] bool empty() const;
+
+private:
+    friend class Scene;
+    friend class SceneViewIterator;
+
+    Scene &scene_;
+    ComponentMask mask_;
+    Match match_;
+    std::vector<Archetype *> archetypes_;
+};
+
+/**
+ * \brief Gets told about changes to the entities in a scene, so that systems keeping their own data about entities can
+ * update just the entities that changed instead of scanning the scene. Listeners must not change the scene from inside
+ * the callbacks.
+ */
+class SceneListener {
+public:
+    virtual ~SceneListener() = default;
+
+    /**
+     * \brief Called when an entity is created or deleted, or has a component added or removed. Overwriting a component
+     * that the entity already has is not a change.
+     * \param entity The entity, the handle is invalid if the entity was deleted
+     */
+    virtual void onEntityChanged(EntityHandle entity) = 0;
+
+    /**
+     * \brief Called from Scene::updateTransforms for every entity whose world matrix changed
+     * \param entity The entity
+     */
+    virtual void onWorldTransformChanged(EntityHandle entity) = 0;
+};
+
 /**
  * \brief Provides an interface to interact with entities in a scene
  */
 class Scene {
 public:
+    Scene();
+
+    // Entities keep a pointer to their scene, so a scene can't be copied or moved
+    Scene(const Scene &) = delete;
+    Scene &operator=(const Scene &) = delete;
+
     /**
      * \brief Create an entity, this might invalidate any scene iterators
      * \return A handle to the newly added entity
      */
     EntityHandle createEntity();
 
+    /**
+     * \brief Create many entities with copies of a prefab's components, the components are copied into contiguous
+     * storage in a single pass. This might invalidate any scene iterators.
+     * \param count The number of entities to create
+     * \param prefab The components and tag for the new entities
+     * \return Handles to the new entities, only valid until the next call to createEntities
+     */
+    Span<EntityHandle> createEntities(u32 count, const Prefab &prefab);
+
+    /**
+     * \brief Reserve memory for a number of entities on top of the ones already in the scene
+     * \param count The number of entities that will be created
+     */
+    void reserve(u32 count);
+
     /**
      * \brief Delete an entity from the scene, this does not invalidate scene iterators
      * \param entity The handle to the entity to delete
@@ -110,11 +256,102 @@ public:
     [[nodiscard]] std::vector<EntityHandle> findEntitiesWithAnyComponents();
 
     /**
-     * \brief Find the entities with a given tag
+     * \brief Get a cached view of the entities that have all of the given components, the view is created on first use
+     * \tparam Components The components the entities must have
+     * \return The scene view
+     */
+    template <typename... Components>
+    [[nodiscard]] const SceneView &getViewWithAllComponents();
+
+    /**
+     * \brief Get a cached view of the entities that have any of the given components, the view is created on first use
+     * \tparam Components The components the entities can have
+     * \return The scene view
+     */
+    template <typename... Components>
+    [[nodiscard]] const SceneView &getViewWithAnyComponents();
+
+    /**
+     * \brief Call a function for every entity that has all of the given components. The function receives references
+     * to the components, optionally preceded by an EntityHandle: fn(Components &...) or fn(EntityHandle, Components &...).
+     * Components must not be added or removed and entities must not be created or deleted from inside fn.
+     * \tparam Components The components the entities must have
+     * \tparam Func The function type
+     * \param fn The function to call for every entity
+     */
+    template <typename... Components, typename Func>
+    void forEach(Func &&fn);
+
+    /**
+     * \brief Call a function for every entity that has all of the given components, spread over a thread pool.
+     * Entities are split into chunks that fit in cache and each chunk is a task. The same rules as forEach apply, and:
+     * - A component listed as const T is read only, a component listed as T may be written
+     * - fn may only access the components it is given, which belong to a single entity
+     * - fn is called from several threads at once, so anything else it touches must be safe to share between threads
+     * Structural changes are caught while a parallel iteration is running in debug builds.
+     * \tparam Components The components the entities must have
+     * \tparam Func The function type
+     * \param pool The thread pool to run on
+     * \param fn The function to call for every entity
+     */
+    template <typename... Components, typename Func>
+    void parallelForEach(ThreadPool &pool, Func &&fn);
+
+    /**
+     * \brief The target size of the components in a single parallelForEach task
+     */
+    static constexpr u32 PARALLEL_CHUNK_BYTES = 16 * 1024;
+
+    /**
+     * \brief Set the parent of an entity's transform, the child's transform becomes relative to the parent's.
+     * Both entities need a Transform component. Overwriting the child's Transform with setComponent also overwrites
+     * its parent.
+     * \param child The child entity
+     * \param parent The parent entity, or an invalid handle to detach the child from its parent
+     */
+    void setParent(EntityHandle child, EntityHandle parent);
+
+    /**
+     * \brief Get the parent of an entity's transform
+     * \param child The child entity
+     * \return The parent entity, or an invalid handle if there is no parent
+     */
+    [[nodiscard]] EntityHandle getParent(EntityHandle child);
+
+    /**
+     * \brief Recompute the cached matrices of every Transform that changed, or whose ancestors changed, since the last
+     * call. Parents are always updated before their children.
+     */
+    void updateTransforms();
+
+    /**
+     * \brief Find the entities with a given tag, this only visits the entities that have the tag
      * \param tag The tag the entities must have
      * \return A vector of entity handles
      */
-    [[nodiscard]] std::vector<EntityHandle> findEntitiesWithTag(const std::string &tag);
+    [[nodiscard]] std::vector<EntityHandle> findEntitiesWithTag(Tag tag);
+
+    /**
+     * \brief Call fn(EntityHandle) for every entity with a given tag, this only visits the entities that have the tag.
+     * Tags must not be added or removed and entities must not be created or deleted from inside fn.
+     * \tparam Func The function type
+     * \param tag The tag the entities must have
+     * \param fn The function to call
+     */
+    template <typename Func>
+    void forEachWithTag(Tag tag, Func &&fn);
+
+    /**
+     * \brief Start sending changes to a listener, it must be removed before it is destroyed
+     * \param listener The listener
+     */
+    void addListener(SceneListener *listener);
+
+    /**
+     * \brief Stop sending changes to a listener
+     * \param listener The listener
+     */
+    void removeListener(SceneListener *listener);
 
     [[nodiscard]] SceneIterator begin();
     [[nodiscard]] SceneIterator end();
@@ -128,16 +365,169 @@ public:
     static constexpr u32 VERSION_INVALID_BIT = 1u << 31;
 
 private:
+    friend class Entity;
     friend class EntityHandle;
     friend class SceneIterator;
+    friend class SceneViewIterator;
+    friend class SceneSnapshot;
+
+    using PoolFactory_t = std::unique_ptr<ComponentPoolBase> (*)();
+
+    /**
+     * \brief Call a function for a range of rows in an archetype, see forEach
+     * \tparam Components The components to pass to the function
+     * \tparam Func The function type
+     * \param archetype The archetype
+     * \param begin The first row
+     * \param end One past the last row
+     * \param fn The function to call
+     */
+    template <typename... Components, typename Func>
+    void forEachInRows(Archetype &archetype, u32 begin, u32 end, Func &fn);
+
+    /**
+     * \brief Rebuild the breadth first order that transforms are updated in
+     */
+    void rebuildTransformOrder();
+
+    /**
+     * \brief Make sure that the structure of the scene isn't changed while a parallel iteration is running
+     */
+    void checkStructuralChangeAllowed() const {
+        if constexpr (consts::DEBUG) {
+            if (parallelIterations_ > 0) {
+                Log::fatal("Entities or components can't be added or removed during Scene::parallelForEach");
+            }
+        }
+    }
+
+    /**
+     * \brief Set a component for an entity, moving it to a new archetype if needed
+     * \tparam T The component type
+     * \param entity The entity
+     * \param component The data to set for the component
+     */
+    template <typename T>
+    void setComponent(Entity &entity, const T &component);
+
+    /**
+     * \brief Remove a component from an entity, moving it to a new archetype if needed
+     * \tparam T The component type
+     * \param entity The entity
+     */
+    template <typename T>
+    void removeComponent(Entity &entity);
+
+    /**
+     * \brief Add a tag to an entity and to the tag's entity list
+     * \param entity The entity
+     * \param tag The tag
+     */
+    void addTag(Entity &entity, Tag tag);
+
+    /**
+     * \brief Remove a tag from an entity and from the tag's entity list
+     * \param entity The entity
+     * \param tag The tag
+     */
+    void removeTag(Entity &entity, Tag tag);
+
+    /**
+     * \brief Remove all tags from an entity
+     * \param entity The entity
+     */
+    void clearTags(Entity &entity);
+
+    /**
+     * \brief Tell the listeners that an entity was created or deleted or had its components changed
+     * \param entity_idx The entity index
+     */
+    void notifyEntityChanged(u32 entity_idx);
+
+    /**
+     * \brief Tell the listeners that the world matrix of an entity changed
+     * \param entity_idx The entity index
+     */
+    void notifyWorldTransformChanged(u32 entity_idx);
+
+    /**
+     * \brief Get an index for a new entity and set up its record and version, the entity isn't in any archetype yet
+     * \return The entity index
+     */
+    u32 allocateEntity();
+
+    /**
+     * \brief Get the archetype for a mask, creating it if it doesn't exist yet
+     * \param mask The component mask of the archetype
+     * \param src An archetype to copy component pool types from
+     * \param create_pool Used to create the pool for a component type that is in mask but not in src, can be nullptr
+     * \return The archetype
+     */
+    Archetype &getArchetype(const ComponentMask &mask, const Archetype &src, PoolFactory_t create_pool);
+
+    /**
+     * \brief Get the view for a mask and match type, creating it if it doesn't exist yet
+     * \param mask The component mask
+     * \param match How the mask is matched against archetypes
+     * \return The scene view
+     */
+    const SceneView &getView(const ComponentMask &mask, SceneView::Match match);
+
+    /**
+     * \brief Move an entity into another archetype, components that aren't in dst are destroyed.
+     * Components that are in dst but not in the entity's current archetype must be added by the caller.
+     * \param entity The entity to move
+     * \param dst The archetype to move the entity into
+     */
+    void moveEntity(Entity &entity, Archetype &dst);
+
+    /**
+     * \brief Remove a row from an archetype and update the entity that took its place
+     * \param archetype The archetype
+     * \param row The row to remove
+     */
+    void removeRow(Archetype &archetype, u32 row);
+
+    std::vector<std::unique_ptr<Archetype>> archetypes_;
+    std::unordered_map<ComponentMask, u32> archetypeIndices_;
+    std::unordered_map<ComponentMask, std::unique_ptr<SceneView>> viewsWithAll_;
+    std::unordered_map<ComponentMask, std::unique_ptr<SceneView>> viewsWithAny_;
+
+    u32 parallelIterations_ = 0;
+
+    struct TransformNode {
+        Transform *transform;
+        u32 entityIdx;
+        u32 parentIdx;  // Parent entity index when the order was built
+        u32 parentSlot; // Index of the parent in transformOrder_
+    };
+
+    // Every transform in breadth first order, parents always come before their children
+    std::vector<TransformNode> transformOrder_;
+    std::vector<u8> transformChanged_;
+    bool transformOrderDirty_ = true;
+
+    // Scratch memory for computing the local matrices of dirty transforms
+    TransformBatch transformBatch_;
+    std::vector<u32> dirtyTransformSlots_;
+    std::vector<glm::mat4> batchModelMatrices_;
+    std::vector<glm::mat4> batchNormalMatrices_;
 
     std::vector<Entity> entities_;
     std::vector<u32> versions_;
     std::vector<u32> deletedIndices_;
+    std::vector<EntityHandle> createdEntities_;
+
+    // Indices of the entities with each tag, indexed by tag id
+    std::vector<std::vector<u32>> taggedEntities_;
+
+    std::vector<SceneListener *> listeners_;
 };
 
 #include "scene.inl"
 
 }
 
+#include "entity.inl"
+
 #endif // IVY_SCENE_H
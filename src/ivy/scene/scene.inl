@@ -2,10 +2,11 @@
 
 template <typename ... Components>
 EntityHandle Scene::findEntityWithAllComponents() {
-    for (EntityHandle entity : *this) {
-        if (entity->hasAllComponents<Components...>()) {
-            return entity;
-        }
+    const SceneView &view = getViewWithAllComponents<Components...>();
+
+    auto it = view.begin();
+    if (it != view.end()) {
+        return *it;
     }
 
     // Otherwise, couldn't find any entities with these components so return invalid entity handle
@@ -14,12 +15,12 @@ EntityHandle Scene::findEntityWithAllComponents() {
 
 template<typename... Components>
 std::vector<EntityHandle> Scene::findEntitiesWithAllComponents() {
+    const SceneView &view = getViewWithAllComponents<Components...>();
     std::vector<EntityHandle> foundEntities;
+    foundEntities.reserve(view.size());
 
-    for (EntityHandle entity : *this) {
-        if (entity->hasAllComponents<Components...>()) {
-            foundEntities.emplace_back(entity);
-        }
+    for (EntityHandle entity : view) {
+        foundEntities.emplace_back(entity);
     }
 
     return foundEntities;
@@ -27,13 +28,126 @@ std::vector<EntityHandle> Scene::findEntitiesWithAllComponents() {
 
 template<typename... Components>
 std::vector<EntityHandle> Scene::findEntitiesWithAnyComponents() {
+    const SceneView &view = getViewWithAnyComponents<Components...>();
     std::vector<EntityHandle> foundEntities;
+    foundEntities.reserve(view.size());
 
-    for (EntityHandle entity : *this) {
-        if (entity->hasAnyComponents<Components...>()) {
-            foundEntities.emplace_back(entity);
-        }
+    for (EntityHandle entity : view) {
+        foundEntities.emplace_back(entity);
     }
 
     return foundEntities;
 }
+
+template<typename... Components>
+const SceneView &Scene::getViewWithAllComponents() {
+    return getView(component_mask<Components...>(), SceneView::Match::ALL);
+}
+
+template<typename... Components>
+const SceneView &Scene::getViewWithAnyComponents() {
+    return getView(component_mask<Components...>(), SceneView::Match::ANY);
+}
+
+template<typename... Components, typename Func>
+void Scene::forEach(Func &&fn) {
+    static_assert(sizeof...(Components) > 0, "forEach needs at least one component");
+
+    for (Archetype *archetype : getViewWithAllComponents<std::remove_const_t<Components>...>().getArchetypes()) {
+        forEachInRows<Components...>(*archetype, 0, archetype->size(), fn);
+    }
+}
+
+template<typename... Components, typename Func>
+void Scene::parallelForEach(ThreadPool &pool, Func &&fn) {
+    static_assert(sizeof...(Components) > 0, "parallelForEach needs at least one component");
+
+    constexpr u32 chunkSize = std::max(1u, PARALLEL_CHUNK_BYTES / (u32) (sizeof(Components) + ...));
+
+    ++parallelIterations_;
+
+    TaskGroup group;
+    for (Archetype *archetype : getViewWithAllComponents<std::remove_const_t<Components>...>().getArchetypes()) {
+        for (u32 begin = 0; begin < archetype->size(); begin += chunkSize) {
+            u32 end = std::min(archetype->size(), begin + chunkSize);
+            pool.submit(group, [this, archetype, begin, end, &fn]() {
+                forEachInRows<Components...>(*archetype, begin, end, fn);
+            });
+        }
+    }
+    pool.wait(group);
+
+    --parallelIterations_;
+}
+
+template<typename... Components, typename Func>
+void Scene::forEachInRows(Archetype &archetype, u32 begin, u32 end, Func &fn) {
+    const std::vector<u32> &entities = archetype.getEntities();
+    std::tuple<Components *...> components(
+        archetype.getPool<std::remove_const_t<Components>>().getComponents().data()...);
+
+    for (u32 row = begin; row < end; ++row) {
+        if constexpr (std::is_invocable_v<Func &, EntityHandle, Components &...>) {
+            u32 entityIdx = entities[row];
+            fn(EntityHandle(*this, entityIdx, versions_[entityIdx]), std::get<Components *>(components)[row]...);
+        } else {
+            fn(std::get<Components *>(components)[row]...);
+        }
+    }
+}
+
+template<typename Func>
+void Scene::forEachWithTag(Tag tag, Func &&fn) {
+    if (tag.getId() >= taggedEntities_.size()) {
+        return;
+    }
+
+    for (u32 entityIdx : taggedEntities_[tag.getId()]) {
+        fn(EntityHandle(*this, entityIdx, versions_[entityIdx]));
+    }
+}
+
+template <typename T>
+void Scene::setComponent(Entity &entity, const T &component) {
+    checkStructuralChangeAllowed();
+
+    u32 typeId = component_type_id<T>();
+    Archetype &src = *entity.archetype_;
+
+    if (src.getMask().test(typeId)) {
+        // Entity already has this component, just overwrite it
+        src.getPool<T>().getComponents()[entity.row_] = component;
+        return;
+    }
+
+    // Copy first, component might be stored in a pool that is about to be resized
+    T copy = component;
+
+    ComponentMask mask = src.getMask();
+    mask.set(typeId);
+
+    Archetype &dst = getArchetype(mask, src, &ComponentPool<T>::create);
+    moveEntity(entity, dst);
+    dst.getPool<T>().getComponents().emplace_back(std::move(copy));
+
+    notifyEntityChanged(entity.entityIdx_);
+}
+
+template <typename T>
+void Scene::removeComponent(Entity &entity) {
+    checkStructuralChangeAllowed();
+
+    u32 typeId = component_type_id<T>();
+    Archetype &src = *entity.archetype_;
+
+    if (!src.getMask().test(typeId)) {
+        return;
+    }
+
+    ComponentMask mask = src.getMask();
+    mask.reset(typeId);
+
+    moveEntity(entity, getArchetype(mask, src, nullptr));
+
+    notifyEntityChanged(entity.entityIdx_);
+}
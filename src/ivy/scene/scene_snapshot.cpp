@@ -0,0 +1,417 @@
+#include "scene_snapshot.h"
+#include "ivy/log.h"
+#include "ivy/utils/binary_sections.h"
+#include "ivy/scene/components/transform.h"
+#include "ivy/scene/components/camera.h"
+#include "ivy/scene/components/light.h"
+#include "ivy/scene/components/model.h"
+#include "ivy/resources/resource_manager.h"
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+namespace ivy {
+
+/*
+ * File layout, every section starts at a multiple of SECTION_ALIGNMENT:
+ *   SnapshotHeader
+ *   u32 versions[numEntities]
+ *   u32 deletedIndices[numDeletedEntities]
+ *   per archetype: u32 entityIndices[numEntities], then the data of each of its pools
+ *   per tag: u32 entityIndices[numEntities]
+ *   string characters
+ *   SnapshotArchetype[numArchetypes], SnapshotPool[numPools], SnapshotComponentType[numComponentTypes],
+ *   SnapshotTag[numTags], SnapshotString[numStrings]
+ */
+
+constexpr char SNAPSHOT_MAGIC[4] = {'I', 'V', 'Y', 'S'};
+
+struct SnapshotHeader {
+    char magic[4];
+    u32 version;
+    u32 numEntities;
+    u32 numDeletedEntities;
+    u32 numArchetypes;
+    u32 numPools;
+    u32 numComponentTypes;
+    u32 numTags;
+    u32 numStrings;
+    u32 padding;
+    u64 versionsOffset;
+    u64 deletedIndicesOffset;
+    u64 archetypesOffset;
+    u64 poolsOffset;
+    u64 componentTypesOffset;
+    u64 tagsOffset;
+    u64 stringsOffset;
+};
+
+struct SnapshotArchetype {
+    u64 entitiesOffset;
+    u32 numEntities;
+    u32 firstPool;
+    u32 numPools;
+    u32 padding;
+};
+
+struct SnapshotPool {
+    u64 dataOffset;
+    u32 componentType;
+    u32 padding;
+};
+
+struct SnapshotComponentType {
+    u32 nameIdx;
+    u32 elementSize;
+};
+
+struct SnapshotTag {
+    u64 entitiesOffset;
+    u32 nameIdx;
+    u32 numEntities;
+};
+
+struct SnapshotString {
+    u64 offset;
+    u32 length;
+    u32 padding;
+};
+
+SceneSnapshot::SceneSnapshot(ResourceManager &resource_manager) {
+    registerComponent<Transform>();
+    registerComponent<Camera>();
+    registerComponent<DirectionalLight>({offsetof(DirectionalLight, castsShadows_)});
+    registerComponent<PointLight>({offsetof(PointLight, castsShadows_)});
+    registerResourceComponent<Model>([](const Model &model) {
+        return model.getModelResource().getName();
+    }, [&resource_manager](const std::string &name) {
+        // Don't block the load on model imports, a missing file only leaves the model empty
+        return Model(resource_manager.getModelAsync(name));
+    });
+}
+
+bool SceneSnapshot::save(const Scene &scene, const std::string &path) const {
+    std::vector<u8> file(sizeof(SnapshotHeader));
+    StringTable strings;
+
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.numEntities = (u32) scene.entities_.size();
+    header.numDeletedEntities = (u32) scene.deletedIndices_.size();
+    header.versionsOffset = append_section(file, scene.versions_);
+    header.deletedIndicesOffset = append_section(file, scene.deletedIndices_);
+
+    std::vector<SnapshotArchetype> archetypes;
+    std::vector<SnapshotPool> pools;
+    std::vector<SnapshotComponentType> componentTypes;
+    std::unordered_map<u32, u32> componentTypeIndices;
+
+    for (const auto &archetype : scene.archetypes_) {
+        if (archetype->size() == 0) {
+            continue;
+        }
+
+        SnapshotArchetype &snapshotArchetype = archetypes.emplace_back();
+        snapshotArchetype.entitiesOffset = append_section(file, archetype->getEntities());
+        snapshotArchetype.numEntities = archetype->size();
+        snapshotArchetype.firstPool = (u32) pools.size();
+
+        for (u32 typeId = 0; typeId < MAX_COMPONENT_TYPES; ++typeId) {
+            const ComponentPoolBase *pool = archetype->getPool(typeId);
+            if (!pool) {
+                continue;
+            }
+
+            auto codecIt = codecsByTypeId_.find(typeId);
+            if (codecIt == codecsByTypeId_.end()) {
+                Log::warn("Failed to save scene '%', component '%' is not registered", path,
+                          pool->getComponentName());
+                return false;
+            }
+            const ComponentCodec &codec = codecs_[codecIt->second];
+
+            auto typeIt = componentTypeIndices.find(typeId);
+            if (typeIt == componentTypeIndices.end()) {
+                typeIt = componentTypeIndices.emplace(typeId, (u32) componentTypes.size()).first;
+                componentTypes.push_back({strings.add(codec.name), codec.elementSize});
+            }
+
+            SnapshotPool &snapshotPool = pools.emplace_back();
+            snapshotPool.dataOffset = begin_section(file);
+            snapshotPool.componentType = typeIt->second;
+            codec.save(*pool, file, strings);
+        }
+
+        snapshotArchetype.numPools = (u32) pools.size() - snapshotArchetype.firstPool;
+    }
+
+    std::vector<SnapshotTag> tags;
+    for (u32 tagId = 0; tagId < scene.taggedEntities_.size(); ++tagId) {
+        const std::vector<u32> &taggedEntities = scene.taggedEntities_[tagId];
+        if (taggedEntities.empty()) {
+            continue;
+        }
+
+        SnapshotTag &snapshotTag = tags.emplace_back();
+        snapshotTag.entitiesOffset = append_section(file, taggedEntities);
+        snapshotTag.nameIdx = strings.add(Tag(tagId).getName());
+        snapshotTag.numEntities = (u32) taggedEntities.size();
+    }
+
+    std::vector<SnapshotString> snapshotStrings;
+    for (const std::string &str : strings.getStrings()) {
+        snapshotStrings.push_back({append_section(file, str.data(), str.size()), (u32) str.size(), 0});
+    }
+
+    header.numArchetypes = (u32) archetypes.size();
+    header.numPools = (u32) pools.size();
+    header.numComponentTypes = (u32) componentTypes.size();
+    header.numTags = (u32) tags.size();
+    header.numStrings = (u32) snapshotStrings.size();
+    header.archetypesOffset = append_section(file, archetypes);
+    header.poolsOffset = append_section(file, pools);
+    header.componentTypesOffset = append_section(file, componentTypes);
+    header.tagsOffset = append_section(file, tags);
+    header.stringsOffset = append_section(file, snapshotStrings);
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.write(reinterpret_cast<const char *>(file.data()), (std::streamsize) file.size())) {
+        Log::warn("Failed to write scene '%'", path);
+        return false;
+    }
+
+    return true;
+}
+
+bool SceneSnapshot::load(Scene &scene, const std::string &path) const {
+    if (!scene.entities_.empty()) {
+        Log::warn("Failed to load scene '%', the scene already has entities", path);
+        return false;
+    }
+
+    MappedFile file;
+    if (!file.open(path)) {
+        Log::warn("Failed to open scene '%'", path);
+        return false;
+    }
+
+    // Validate everything before touching the scene so that a bad file leaves the scene empty
+    const auto *header = get_section<SnapshotHeader>(file, 0, 1);
+    if (!header || std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        Log::warn("Failed to load scene '%', not a scene file", path);
+        return false;
+    }
+
+    if (header->version != VERSION) {
+        Log::warn("Failed to load scene '%', file version is % but expected version %", path, header->version,
+                  VERSION);
+        return false;
+    }
+
+    const u32 numEntities = header->numEntities;
+    const auto *versions = get_section<u32>(file, header->versionsOffset, numEntities);
+    const auto *deletedIndices = get_section<u32>(file, header->deletedIndicesOffset, header->numDeletedEntities);
+    const auto *archetypes = get_section<SnapshotArchetype>(file, header->archetypesOffset, header->numArchetypes);
+    const auto *pools = get_section<SnapshotPool>(file, header->poolsOffset, header->numPools);
+    const auto *componentTypes = get_section<SnapshotComponentType>(file, header->componentTypesOffset,
+                                                                    header->numComponentTypes);
+    const auto *tags = get_section<SnapshotTag>(file, header->tagsOffset, header->numTags);
+    const auto *snapshotStrings = get_section<SnapshotString>(file, header->stringsOffset, header->numStrings);
+    if (!versions || !deletedIndices || !archetypes || !pools || !componentTypes || !tags || !snapshotStrings) {
+        Log::warn("Failed to load scene '%', the file is truncated", path);
+        return false;
+    }
+
+    std::vector<std::string> strings;
+    strings.reserve(header->numStrings);
+    for (u32 i = 0; i < header->numStrings; ++i) {
+        if (snapshotStrings[i].offset > file.getSize() ||
+            snapshotStrings[i].length > file.getSize() - snapshotStrings[i].offset) {
+            Log::warn("Failed to load scene '%', the file is truncated", path);
+            return false;
+        }
+
+        strings.emplace_back(reinterpret_cast<const char *>(file.getData() + snapshotStrings[i].offset),
+                             snapshotStrings[i].length);
+    }
+
+    std::vector<const ComponentCodec *> codecs(header->numComponentTypes);
+    for (u32 i = 0; i < header->numComponentTypes; ++i) {
+        if (componentTypes[i].nameIdx >= strings.size()) {
+            Log::warn("Failed to load scene '%', invalid component name", path);
+            return false;
+        }
+
+        const std::string &name = strings[componentTypes[i].nameIdx];
+        auto it = codecsByName_.find(name);
+        if (it == codecsByName_.end()) {
+            Log::warn("Failed to load scene '%', component '%' is not registered", path, name);
+            return false;
+        }
+
+        codecs[i] = &codecs_[it->second];
+        if (codecs[i]->elementSize != componentTypes[i].elementSize) {
+            Log::warn("Failed to load scene '%', the layout of component '%' has changed", path, name);
+            return false;
+        }
+    }
+
+    // Every live entity must be in exactly one archetype
+    std::vector<u8> entityState(numEntities, 0);
+    for (u32 i = 0; i < numEntities; ++i) {
+        entityState[i] = (versions[i] & Scene::VERSION_INVALID_BIT) ? 2 : 0;
+    }
+
+    for (u32 i = 0; i < header->numDeletedEntities; ++i) {
+        if (deletedIndices[i] >= numEntities || entityState[deletedIndices[i]] != 2) {
+            Log::warn("Failed to load scene '%', invalid deleted entity", path);
+            return false;
+        }
+    }
+
+    std::vector<const u32 *> archetypeEntities(header->numArchetypes);
+    for (u32 i = 0; i < header->numArchetypes; ++i) {
+        const SnapshotArchetype &archetype = archetypes[i];
+        archetypeEntities[i] = get_section<u32>(file, archetype.entitiesOffset, archetype.numEntities);
+        if (!archetypeEntities[i] || archetype.firstPool > header->numPools ||
+            archetype.numPools > header->numPools - archetype.firstPool) {
+            Log::warn("Failed to load scene '%', the file is truncated", path);
+            return false;
+        }
+
+        for (u32 row = 0; row < archetype.numEntities; ++row) {
+            u32 entityIdx = archetypeEntities[i][row];
+            if (entityIdx >= numEntities || entityState[entityIdx] != 0) {
+                Log::warn("Failed to load scene '%', invalid entity", path);
+                return false;
+            }
+            entityState[entityIdx] = 1;
+        }
+
+        ComponentMask mask;
+        for (u32 p = archetype.firstPool; p < archetype.firstPool + archetype.numPools; ++p) {
+            if (pools[p].componentType >= header->numComponentTypes) {
+                Log::warn("Failed to load scene '%', invalid component type", path);
+                return false;
+            }
+
+            const ComponentCodec &codec = *codecs[pools[p].componentType];
+            u64 dataSize = (u64) archetype.numEntities * codec.elementSize;
+            const u8 *data = get_section<u8>(file, pools[p].dataOffset, dataSize);
+            if (mask.test(codec.typeId) || !data ||
+                !codec.validate(data, archetype.numEntities, header->numStrings)) {
+                Log::warn("Failed to load scene '%', invalid component data", path);
+                return false;
+            }
+            mask.set(codec.typeId);
+        }
+    }
+
+    for (u32 i = 0; i < numEntities; ++i) {
+        if (entityState[i] == 0) {
+            Log::warn("Failed to load scene '%', entity % is not in an archetype", path, i);
+            return false;
+        }
+    }
+
+    for (u32 i = 0; i < header->numTags; ++i) {
+        const u32 *taggedEntities = get_section<u32>(file, tags[i].entitiesOffset, tags[i].numEntities);
+        if (!taggedEntities || tags[i].nameIdx >= strings.size()) {
+            Log::warn("Failed to load scene '%', invalid tag", path);
+            return false;
+        }
+
+        for (u32 j = 0; j < tags[i].numEntities; ++j) {
+            if (taggedEntities[j] >= numEntities || entityState[taggedEntities[j]] != 1) {
+                Log::warn("Failed to load scene '%', invalid tagged entity", path);
+                return false;
+            }
+        }
+    }
+
+    // Entity records, the bookkeeping is copied in bulk
+    scene.versions_.assign(versions, versions + numEntities);
+    scene.deletedIndices_.assign(deletedIndices, deletedIndices + header->numDeletedEntities);
+    scene.entities_.reserve(numEntities);
+    for (u32 i = 0; i < numEntities; ++i) {
+        scene.entities_.push_back(entityState[i] == 1 ? Entity(&scene, i) : Entity());
+    }
+
+    // Component data, one bulk copy per pool
+    for (u32 i = 0; i < header->numArchetypes; ++i) {
+        const SnapshotArchetype &snapshotArchetype = archetypes[i];
+
+        ComponentMask mask;
+        Archetype poolTypes(mask);
+        for (u32 p = snapshotArchetype.firstPool; p < snapshotArchetype.firstPool + snapshotArchetype.numPools; ++p) {
+            const ComponentCodec &codec = *codecs[pools[p].componentType];
+            mask.set(codec.typeId);
+            poolTypes.setPool(codec.typeId, codec.createPool());
+        }
+
+        Archetype &archetype = scene.getArchetype(mask, poolTypes, nullptr);
+        archetype.reserve(archetype.size() + snapshotArchetype.numEntities);
+
+        u32 firstRow = archetype.addEntities(archetypeEntities[i], snapshotArchetype.numEntities);
+        for (u32 row = 0; row < snapshotArchetype.numEntities; ++row) {
+            Entity &entity = scene.entities_[archetypeEntities[i][row]];
+            entity.archetype_ = &archetype;
+            entity.row_ = firstRow + row;
+        }
+
+        for (u32 p = snapshotArchetype.firstPool; p < snapshotArchetype.firstPool + snapshotArchetype.numPools; ++p) {
+            const ComponentCodec &codec = *codecs[pools[p].componentType];
+            codec.load(*archetype.getPool(codec.typeId), file.getData() + pools[p].dataOffset,
+                       snapshotArchetype.numEntities, strings);
+        }
+
+        for (u32 row = 0; row < snapshotArchetype.numEntities; ++row) {
+            scene.notifyEntityChanged(archetypeEntities[i][row]);
+        }
+    }
+
+    for (u32 i = 0; i < header->numTags; ++i) {
+        const u32 *taggedEntities = get_section<u32>(file, tags[i].entitiesOffset, tags[i].numEntities);
+        Tag tag(strings[tags[i].nameIdx]);
+
+        if (tag.getId() >= scene.taggedEntities_.size()) {
+            scene.taggedEntities_.resize(tag.getId() + 1);
+        }
+        scene.taggedEntities_[tag.getId()].reserve(tags[i].numEntities);
+
+        for (u32 j = 0; j < tags[i].numEntities; ++j) {
+            scene.addTag(scene.entities_[taggedEntities[j]], tag);
+        }
+    }
+
+    scene.transformOrderDirty_ = true;
+
+    return true;
+}
+
+u32 SceneSnapshot::StringTable::add(const std::string &str) {
+    auto it = indices_.find(str);
+    if (it != indices_.end()) {
+        return it->second;
+    }
+
+    u32 idx = (u32) strings_.size();
+    strings_.emplace_back(str);
+    indices_.emplace(str, idx);
+
+    return idx;
+}
+
+void SceneSnapshot::addCodec(ComponentCodec codec) {
+    if (codecsByName_.count(codec.name) || codecsByTypeId_.count(codec.typeId)) {
+        Log::fatal("Component '%' is already registered", codec.name);
+    }
+
+    codecsByName_[codec.name] = (u32) codecs_.size();
+    codecsByTypeId_[codec.typeId] = (u32) codecs_.size();
+    codecs_.emplace_back(std::move(codec));
+}
+
+}
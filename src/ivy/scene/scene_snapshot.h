@@ -0,0 +1,113 @@
+#ifndef IVY_SCENE_SNAPSHOT_H
+#define IVY_SCENE_SNAPSHOT_H
+
+#include "ivy/types.h"
+#include "ivy/scene/scene.h"
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ivy {
+
+class ResourceManager;
+
+/**
+ * \brief Saves scenes to and loads scenes from a versioned binary file.
+ *
+ * The file stores each archetype's component arrays in their in-memory layout, so loading maps the file and copies
+ * every array with a single bulk copy instead of parsing fields. Components that reference resources are stored as
+ * resource names and are resolved through the resource manager on load, models are loaded asynchronously and fill in
+ * when ResourceManager::update() finishes them. Entity indices and versions are preserved, so handles and transform
+ * parents stay valid across a save and load.
+ */
+class SceneSnapshot {
+public:
+    /**
+     * \brief The version of the file format, files with a different version are rejected
+     */
+    static constexpr u32 VERSION = 1;
+
+    /**
+     * \brief Create a snapshot serializer that knows about the built in components
+     * \param resource_manager The resource manager used to resolve resource references when loading
+     */
+    explicit SceneSnapshot(ResourceManager &resource_manager);
+
+    /**
+     * \brief Register a component type that is stored with a plain memory copy
+     * \tparam T The component type, must be trivially copyable and must not reference memory outside of itself
+     * \param bool_offsets The offsets of T's bool members, files are rejected if these don't hold 0 or 1. Every other
+     * member must be valid for any bytes.
+     */
+    template <typename T>
+    void registerComponent(std::vector<size_t> bool_offsets = {});
+
+    /**
+     * \brief Register a component type that only refers to a single resource and is stored by resource name
+     * \tparam T The component type
+     * \param get_name Get the resource name for a component
+     * \param create Create a component from a resource name
+     */
+    template <typename T>
+    void registerResourceComponent(std::function<std::string(const T &)> get_name,
+                                   std::function<T(const std::string &)> create);
+
+    /**
+     * \brief Save a scene to a file, all of the scene's component types must be registered
+     * \param scene The scene to save
+     * \param path The path of the file to write
+     * \return Whether or not the scene was saved successfully
+     */
+    bool save(const Scene &scene, const std::string &path) const;
+
+    /**
+     * \brief Load a scene from a file into an empty scene
+     * \param scene The scene to load into, no entities must have been created in it yet
+     * \param path The path of the file to read
+     * \return Whether or not the scene was loaded successfully
+     */
+    bool load(Scene &scene, const std::string &path) const;
+
+private:
+    class StringTable {
+    public:
+        u32 add(const std::string &str);
+
+        [[nodiscard]] const std::vector<std::string> &getStrings() const {
+            return strings_;
+        }
+
+    private:
+        std::vector<std::string> strings_;
+        std::unordered_map<std::string, u32> indices_;
+    };
+
+    using PoolFactory_t = std::unique_ptr<ComponentPoolBase> (*)();
+    using SaveFunc_t = std::function<void(const ComponentPoolBase &pool, std::vector<u8> &out, StringTable &strings)>;
+    using ValidateFunc_t = std::function<bool(const u8 *data, u32 count, u32 num_strings)>;
+    using LoadFunc_t = std::function<void(ComponentPoolBase &pool, const u8 *data, u32 count,
+                                          const std::vector<std::string> &strings)>;
+
+    struct ComponentCodec {
+        std::string name;
+        u32 typeId;
+        u32 elementSize; // Bytes stored per component
+        PoolFactory_t createPool;
+        SaveFunc_t save;
+        ValidateFunc_t validate; // Checks stored data before anything is loaded, load can't fail if this passes
+        LoadFunc_t load;
+    };
+
+    void addCodec(ComponentCodec codec);
+
+    std::vector<ComponentCodec> codecs_;
+    std::unordered_map<std::string, u32> codecsByName_;
+    std::unordered_map<u32, u32> codecsByTypeId_;
+};
+
+}
+
+#include "scene_snapshot.inl"
+
+#endif // IVY_SCENE_SNAPSHOT_H
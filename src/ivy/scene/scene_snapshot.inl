@@ -0,0 +1,104 @@
+#include "scene_snapshot.h"
+#include <cstring>
+#include <type_traits>
+
+namespace ivy {
+
+template<typename T>
+void SceneSnapshot::registerComponent(std::vector<size_t> bool_offsets) {
+    static_assert(std::is_trivially_copyable<T>(), "T must be trivially copyable to be stored with a memory copy");
+    static_assert(alignof(T) <= 16, "T is aligned more strictly than the snapshot sections");
+    static_assert(sizeof(bool) == 1, "bool members are validated as single bytes");
+
+    ComponentCodec codec = {};
+    codec.name = T::getName();
+    codec.typeId = component_type_id<T>();
+    codec.elementSize = sizeof(T);
+    codec.createPool = &ComponentPool<T>::create;
+
+    codec.save = [](const ComponentPoolBase &pool, std::vector<u8> &out, StringTable &) {
+        const std::vector<T> &components = static_cast<const ComponentPool<T> &>(pool).getComponents();
+
+        size_t offset = out.size();
+        out.resize(offset + components.size() * sizeof(T));
+        std::memcpy(out.data() + offset, components.data(), components.size() * sizeof(T));
+    };
+
+    // Bytes other than 0 and 1 aren't valid bools, every other member accepts any bytes
+    codec.validate = [bool_offsets](const u8 *data, u32 count, u32) {
+        for (u32 i = 0; i < count; ++i) {
+            for (size_t offset : bool_offsets) {
+                if (data[i * sizeof(T) + offset] > 1) {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    };
+
+    codec.load = [](ComponentPoolBase &pool, const u8 *data, u32 count, const std::vector<std::string> &) {
+        std::vector<T> &components = static_cast<ComponentPool<T> &>(pool).getComponents();
+
+        // Sections are aligned for T, so this is a single bulk copy of the mapped memory
+        const T *first = reinterpret_cast<const T *>(data);
+        components.insert(components.end(), first, first + count);
+    };
+
+    addCodec(std::move(codec));
+}
+
+template<typename T>
+void SceneSnapshot::registerResourceComponent(std::function<std::string(const T &)> get_name,
+                                              std::function<T(const std::string &)> create) {
+    ComponentCodec codec = {};
+    codec.name = T::getName();
+    codec.typeId = component_type_id<T>();
+    codec.elementSize = sizeof(u32);
+    codec.createPool = &ComponentPool<T>::create;
+
+    codec.save = [get_name](const ComponentPoolBase &pool, std::vector<u8> &out, StringTable &strings) {
+        const std::vector<T> &components = static_cast<const ComponentPool<T> &>(pool).getComponents();
+
+        size_t offset = out.size();
+        out.resize(offset + components.size() * sizeof(u32));
+        for (const T &component : components) {
+            u32 nameIdx = strings.add(get_name(component));
+            std::memcpy(out.data() + offset, &nameIdx, sizeof(u32));
+            offset += sizeof(u32);
+        }
+    };
+
+    codec.validate = [](const u8 *data, u32 count, u32 num_strings) {
+        const u32 *nameIdxs = reinterpret_cast<const u32 *>(data);
+        for (u32 i = 0; i < count; ++i) {
+            if (nameIdxs[i] >= num_strings) {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    codec.load = [create](ComponentPoolBase &pool, const u8 *data, u32 count, const std::vector<std::string> &strings) {
+        std::vector<T> &components = static_cast<ComponentPool<T> &>(pool).getComponents();
+        const u32 *nameIdxs = reinterpret_cast<const u32 *>(data);
+        components.reserve(components.size() + count);
+
+        // Many components share a resource, so only resolve each name once
+        std::unordered_map<u32, u32> firstUse;
+        for (u32 i = 0; i < count; ++i) {
+            auto it = firstUse.find(nameIdxs[i]);
+            if (it == firstUse.end()) {
+                firstUse.emplace(nameIdxs[i], (u32) components.size());
+                components.emplace_back(create(strings[nameIdxs[i]]));
+            } else {
+                components.emplace_back(components[it->second]);
+            }
+        }
+    };
+
+    addCodec(std::move(codec));
+}
+
+}
@@ -0,0 +1,137 @@
+#include "spatial_index.h"
+#include "ivy/scene/components/transform.h"
+#include "ivy/scene/components/camera.h"
+#include "ivy/scene/components/light.h"
+#include "ivy/scene/components/model.h"
+
+namespace ivy {
+
+SpatialIndex::SpatialIndex(Scene &scene, f32 margin)
+    : scene_(scene), layers_{LayerData(margin), LayerData(margin)} {
+    // Entities that already exist are added on the first update, after that only changes are looked at
+    for (EntityHandle entity : scene_.getViewWithAllComponents<Transform>()) {
+        markChanged(entity);
+    }
+
+    scene_.addListener(this);
+}
+
+SpatialIndex::~SpatialIndex() {
+    scene_.removeListener(this);
+}
+
+void SpatialIndex::update() {
+    for (EntityHandle entity : changedEntities_) {
+        changedSlots_[entity.getIndex()] = NOT_CHANGED;
+        updateEntity(entity);
+    }
+    changedEntities_.clear();
+
+    // Models that are still loading are queued before any changes from the scene so newer handles replace them
+    for (EntityHandle entity : loadingModels_) {
+        markChanged(entity);
+    }
+    loadingModels_.clear();
+}
+
+void SpatialIndex::onEntityChanged(EntityHandle entity) {
+    markChanged(entity);
+}
+
+void SpatialIndex::onWorldTransformChanged(EntityHandle entity) {
+    markChanged(entity);
+}
+
+void SpatialIndex::markChanged(EntityHandle entity) {
+    u32 entityIdx = entity.getIndex();
+    if (entityIdx >= changedSlots_.size()) {
+        changedSlots_.resize(entityIdx + 1, NOT_CHANGED);
+    }
+
+    // The latest handle for an index is the entity that is using it now, or an invalid handle if it was deleted
+    if (changedSlots_[entityIdx] != NOT_CHANGED) {
+        changedEntities_[changedSlots_[entityIdx]] = entity;
+    } else {
+        changedSlots_[entityIdx] = (u32) changedEntities_.size();
+        changedEntities_.emplace_back(entity);
+    }
+}
+
+void SpatialIndex::updateEntity(EntityHandle entity) {
+    LayerData &models = layers_[(u32) Layer::MODELS];
+    LayerData &pointLights = layers_[(u32) Layer::POINT_LIGHTS];
+
+    const Transform *transform = entity ? entity->getComponent<Transform>() : nullptr;
+    if (!transform) {
+        remove(models, entity.getIndex());
+        remove(pointLights, entity.getIndex());
+        return;
+    }
+
+    // Models without meshes have no bounds, they are added once they finish loading
+    const Model *model = entity->getComponent<Model>();
+    if (model && model->getModelResource().isLoaded()) {
+        sync(models, entity, transform->getWorldVersion(), [&]() {
+            return model->getWorldBounds(*transform);
+        });
+    } else {
+        remove(models, entity.getIndex());
+        if (model) {
+            loadingModels_.emplace_back(entity);
+        }
+    }
+
+    if (entity->getComponent<PointLight>()) {
+        sync(pointLights, entity, transform->getWorldVersion(), [&]() {
+            glm::vec3 position = transform->getWorldPosition();
+            return AABB(position, position);
+        });
+    } else {
+        remove(pointLights, entity.getIndex());
+    }
+}
+
+void SpatialIndex::remove(LayerData &layer, u32 entity_idx) {
+    if (entity_idx < layer.entries.size() && layer.entries[entity_idx].proxy != DynamicBVH::NULL_NODE) {
+        layer.bvh.remove(layer.entries[entity_idx].proxy);
+        layer.entries[entity_idx].proxy = DynamicBVH::NULL_NODE;
+    }
+}
+
+EntityHandle SpatialIndex::raycast(Layer layer, const Ray &ray, f32 max_t, f32 *out_t) {
+    const LayerData &data = layers_[(u32) layer];
+
+    f32 t;
+    u32 proxy = data.bvh.raycast(ray, max_t, t);
+    if (proxy == DynamicBVH::NULL_NODE) {
+        return EntityHandle(scene_);
+    }
+
+    if (out_t) {
+        *out_t = t;
+    }
+
+    return getEntity(data, proxy);
+}
+
+std::vector<EntityHandle> SpatialIndex::findNearest(Layer layer, const glm::vec3 &point, u32 k, f32 max_distance) {
+    const LayerData &data = layers_[(u32) layer];
+
+    std::vector<u32> proxies;
+    data.bvh.findNearest(point, k, proxies, max_distance);
+
+    std::vector<EntityHandle> entities;
+    entities.reserve(proxies.size());
+    for (u32 proxy : proxies) {
+        entities.emplace_back(getEntity(data, proxy));
+    }
+
+    return entities;
+}
+
+EntityHandle SpatialIndex::getEntity(const LayerData &layer, u32 proxy) {
+    u32 entityIdx = layer.bvh.getUserData(proxy);
+    return EntityHandle(scene_, entityIdx, layer.entries[entityIdx].entityVersion);
+}
+
+}
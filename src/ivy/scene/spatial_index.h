@@ -0,0 +1,184 @@
+#ifndef IVY_SPATIAL_INDEX_H
+#define IVY_SPATIAL_INDEX_H
+
+#include "ivy/types.h"
+#include "ivy/math/bvh.h"
+#include "ivy/scene/scene.h"
+#include <array>
+#include <vector>
+
+namespace ivy {
+
+/**
+ * \brief Keeps the world space bounds of the model entities and point lights in a scene in bounding volume
+ * hierarchies, so that culling and gameplay queries don't have to look at every entity.
+ *
+ * The index listens to the scene, and update() only visits the entities that were created, deleted, had components
+ * added or removed or had their world matrix changed since the last update. Models are indexed by the world bounds of
+ * their meshes and point lights by their position.
+ */
+class SpatialIndex : private SceneListener {
+public:
+    /**
+     * \brief The kinds of entities that are indexed, each is kept in its own hierarchy
+     */
+    enum class Layer {
+        MODELS,       // Entities with a Transform and a Model
+        POINT_LIGHTS, // Entities with a Transform and a PointLight
+        NUM_LAYERS
+    };
+
+    /**
+     * \param scene The scene to index
+     * \param margin How far an entity can move before it has to be moved in the hierarchy
+     */
+    explicit SpatialIndex(Scene &scene, f32 margin = 0.25f);
+
+    ~SpatialIndex() override;
+
+    SpatialIndex(const SpatialIndex &) = delete;
+    SpatialIndex &operator=(const SpatialIndex &) = delete;
+
+    /**
+     * \brief Bring the index up to date with the scene, should be called after Scene::updateTransforms.
+     * Changing the model of an entity without changing its transform is not picked up until the transform changes,
+     * models that are still loading aren't indexed until they have loaded.
+     */
+    void update();
+
+    /**
+     * \brief Call fn(EntityHandle) for every entity in a layer whose bounds intersect a box
+     * \tparam Func The function type
+     * \param layer The layer to search
+     * \param bounds The box
+     * \param fn The function to call
+     */
+    template <typename Func>
+    void query(Layer layer, const AABB &bounds, Func &&fn);
+
+    /**
+     * \brief Call fn(EntityHandle) for every entity in a layer whose bounds intersect a sphere
+     * \tparam Func The function type
+     * \param layer The layer to search
+     * \param sphere The sphere
+     * \param fn The function to call
+     */
+    template <typename Func>
+    void query(Layer layer, const Sphere &sphere, Func &&fn);
+
+    /**
+     * \brief Call fn(EntityHandle) for every entity in a layer whose bounds might be inside of a frustum
+     * \tparam Func The function type
+     * \param layer The layer to search
+     * \param frustum The frustum
+     * \param fn The function to call
+     */
+    template <typename Func>
+    void query(Layer layer, const Frustum &frustum, Func &&fn);
+
+    /**
+     * \brief Find the first entity in a layer whose bounds are hit by a ray
+     * \param layer The layer to search
+     * \param ray The ray
+     * \param max_t The maximum distance along the ray
+     * \param out_t If not nullptr, the distance to the hit is written here
+     * \return The entity that was hit, or an invalid handle if nothing was hit
+     */
+    EntityHandle raycast(Layer layer, const Ray &ray, f32 max_t = std::numeric_limits<f32>::max(),
+                         f32 *out_t = nullptr);
+
+    /**
+     * \brief Find the entities in a layer that are closest to a point
+     * \param layer The layer to search
+     * \param point The point
+     * \param k The maximum number of entities to find
+     * \param max_distance Entities further away than this are ignored
+     * \return The entities sorted from closest to furthest
+     */
+    std::vector<EntityHandle> findNearest(Layer layer, const glm::vec3 &point, u32 k,
+                                          f32 max_distance = std::numeric_limits<f32>::max());
+
+    /**
+     * \brief Get the hierarchy for a layer, the user data of each proxy is the entity index
+     * \param layer The layer
+     * \return The hierarchy
+     */
+    [[nodiscard]] const DynamicBVH &getHierarchy(Layer layer) const {
+        return layers_[(u32) layer].bvh;
+    }
+
+private:
+    struct Entry {
+        u32 proxy = DynamicBVH::NULL_NODE;
+        u32 entityVersion = 0;
+        u32 worldVersion = 0;
+    };
+
+    struct LayerData {
+        explicit LayerData(f32 margin)
+            : bvh(margin) {}
+
+        DynamicBVH bvh;
+        std::vector<Entry> entries; // Indexed by entity index
+    };
+
+    void onEntityChanged(EntityHandle entity) override;
+
+    void onWorldTransformChanged(EntityHandle entity) override;
+
+    /**
+     * \brief Queue an entity to be brought up to date in the next update, only the latest handle for an index is kept
+     * \param entity The entity
+     */
+    void markChanged(EntityHandle entity);
+
+    /**
+     * \brief Bring the entries of an entity up to date with its components
+     * \param entity The entity, if it is invalid the entity is removed from every layer
+     */
+    void updateEntity(EntityHandle entity);
+
+    /**
+     * \brief Remove whatever entity is using an index from a layer
+     * \param layer The layer
+     * \param entity_idx The entity index
+     */
+    void remove(LayerData &layer, u32 entity_idx);
+
+    /**
+     * \brief Add an entity to a layer or refit it if it is already there
+     * \tparam GetBounds The function type
+     * \param layer The layer
+     * \param entity The entity
+     * \param world_version The world version of the entity's transform
+     * \param get_bounds Returns the world bounds of the entity, only called when they might have changed
+     */
+    template <typename GetBounds>
+    void sync(LayerData &layer, EntityHandle entity, u32 world_version, GetBounds &&get_bounds);
+
+    /**
+     * \brief Get a handle to the entity of a proxy
+     * \param layer The layer
+     * \param proxy The proxy id
+     * \return The entity handle
+     */
+    EntityHandle getEntity(const LayerData &layer, u32 proxy);
+
+    static constexpr u32 NOT_CHANGED = ~0u;
+
+    Scene &scene_;
+    std::array<LayerData, (u32) Layer::NUM_LAYERS> layers_;
+
+    // Entities to update in the next update, changedSlots_ has the position of each entity index in changedEntities_
+    std::vector<EntityHandle> changedEntities_;
+    std::vector<u32> changedSlots_;
+
+    // Entities with models that hadn't loaded yet, they are checked again next update
+    std::vector<EntityHandle> loadingModels_;
+};
+
+}
+
+#include "spatial_index.inl"
+
+#endif // IVY_SPATIAL_INDEX_H
@@ -0,0 +1,54 @@
+#include "spatial_index.h"
+
+namespace ivy {
+
+template<typename Func>
+void SpatialIndex::query(Layer layer, const AABB &bounds, Func &&fn) {
+    const LayerData &data = layers_[(u32) layer];
+    data.bvh.query(bounds, [&](u32 proxy) {
+        fn(getEntity(data, proxy));
+    });
+}
+
+template<typename Func>
+void SpatialIndex::query(Layer layer, const Sphere &sphere, Func &&fn) {
+    const LayerData &data = layers_[(u32) layer];
+    data.bvh.query(sphere, [&](u32 proxy) {
+        fn(getEntity(data, proxy));
+    });
+}
+
+template<typename Func>
+void SpatialIndex::query(Layer layer, const Frustum &frustum, Func &&fn) {
+    const LayerData &data = layers_[(u32) layer];
+    data.bvh.query(frustum, [&](u32 proxy) {
+        fn(getEntity(data, proxy));
+    });
+}
+
+template<typename GetBounds>
+void SpatialIndex::sync(LayerData &layer, EntityHandle entity, u32 world_version, GetBounds &&get_bounds) {
+    u32 entityIdx = entity.getIndex();
+    if (entityIdx >= layer.entries.size()) {
+        layer.entries.resize(entityIdx + 1);
+    }
+
+    Entry &entry = layer.entries[entityIdx];
+
+    // The index was reused by a new entity since the last update
+    if (entry.proxy != DynamicBVH::NULL_NODE && entry.entityVersion != entity.getVersion()) {
+        layer.bvh.remove(entry.proxy);
+        entry.proxy = DynamicBVH::NULL_NODE;
+    }
+
+    if (entry.proxy == DynamicBVH::NULL_NODE) {
+        entry.proxy = layer.bvh.insert(get_bounds(), entityIdx);
+        entry.entityVersion = entity.getVersion();
+        entry.worldVersion = world_version;
+    } else if (entry.worldVersion != world_version) {
+        layer.bvh.update(entry.proxy, get_bounds());
+        entry.worldVersion = world_version;
+    }
+}
+
+}
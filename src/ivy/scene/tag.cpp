@@ -0,0 +1,51 @@
+#include "tag.h"
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ivy {
+
+/**
+ * \brief Names of every tag, the index is the tag id
+ */
+class TagRegistry {
+public:
+    static TagRegistry &get() {
+        static TagRegistry registry;
+        return registry;
+    }
+
+    u32 intern(const std::string &name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = ids_.find(name);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+
+        u32 id = (u32) names_.size();
+        names_.emplace_back(name);
+        ids_.emplace(name, id);
+
+        return id;
+    }
+
+    std::string getName(u32 id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return names_.at(id);
+    }
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<std::string, u32> ids_;
+    std::vector<std::string> names_;
+};
+
+Tag::Tag(const std::string &name)
+    : id_(TagRegistry::get().intern(name)) {}
+
+std::string Tag::getName() const {
+    return TagRegistry::get().getName(id_);
+}
+
+}
@@ -0,0 +1,109 @@
+#ifndef IVY_TAG_H
+#define IVY_TAG_H
+
+#include "ivy/types.h"
+#include <array>
+#include <string>
+
+namespace ivy {
+
+/**
+ * \brief An interned entity tag. Creating a tag looks its name up once, after that tags are compared by integer id.
+ * Tags are meant to be created once and stored, for example as static constants.
+ */
+class Tag {
+public:
+    /**
+     * \brief Get the tag for a name, the same name always gives the same tag
+     * \param name The name of the tag
+     */
+    explicit Tag(const std::string &name);
+
+    [[nodiscard]] u32 getId() const {
+        return id_;
+    }
+
+    /**
+     * \brief Get the name the tag was created with
+     * \return Tag name
+     */
+    [[nodiscard]] std::string getName() const;
+
+    bool operator==(const Tag &rhs) const {
+        return id_ == rhs.id_;
+    }
+
+    bool operator!=(const Tag &rhs) const {
+        return !(rhs == *this);
+    }
+
+private:
+    friend class TagSet;
+    friend class SceneSnapshot;
+
+    explicit Tag(u32 id)
+        : id_(id) {}
+
+    u32 id_;
+};
+
+/**
+ * \brief A small set of tags stored inline, used for the tags of a single entity
+ */
+class TagSet {
+public:
+    /**
+     * \brief The maximum number of tags in a set
+     */
+    static constexpr u32 MAX_TAGS = 4;
+
+    /**
+     * \brief Check if a tag is in the set
+     * \param tag The tag
+     * \return Whether or not the tag is in the set
+     */
+    [[nodiscard]] bool contains(Tag tag) const {
+        return find(tag) != count_;
+    }
+
+    [[nodiscard]] u32 size() const {
+        return count_;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return count_ == 0;
+    }
+
+    [[nodiscard]] Tag operator[](u32 idx) const {
+        return Tag(entries_[idx].tagId);
+    }
+
+private:
+    friend class Scene;
+
+    struct Entry {
+        u32 tagId;
+        u32 slot; // Position of the entity in the scene's list of entities with this tag
+    };
+
+    /**
+     * \brief Find a tag in the set
+     * \param tag The tag
+     * \return The index of the tag or size() if not found
+     */
+    [[nodiscard]] u32 find(Tag tag) const {
+        u32 i = 0;
+        while (i < count_ && entries_[i].tagId != tag.getId()) {
+            ++i;
+        }
+
+        return i;
+    }
+
+    std::array<Entry, MAX_TAGS> entries_ = {};
+    u32 count_ = 0;
+};
+
+}
+
+#endif // IVY_TAG_H
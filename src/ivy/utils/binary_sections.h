@@ -0,0 +1,69 @@
+#ifndef IVY_BINARY_SECTIONS_H
+#define IVY_BINARY_SECTIONS_H
+
+#include "ivy/types.h"
+#include "ivy/utils/mapped_file.h"
+#include <cstring>
+#include <vector>
+
+namespace ivy {
+
+/*
+ * Helpers for binary files that are made of sections which are read in place from a mapped file. Every section starts
+ * at a multiple of SECTION_ALIGNMENT, so the structs and arrays in them can be used without copying.
+ */
+
+constexpr u64 SECTION_ALIGNMENT = 16;
+
+/**
+ * \brief Pad the file to the start of the next section
+ * \param file The file contents
+ * \return The offset of the section
+ */
+inline u64 begin_section(std::vector<u8> &file) {
+    file.resize((file.size() + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1));
+    return file.size();
+}
+
+/**
+ * \brief Append a section to the file
+ * \param file The file contents
+ * \param data The data of the section
+ * \param size The size of the data in bytes
+ * \return The offset of the section
+ */
+inline u64 append_section(std::vector<u8> &file, const void *data, u64 size) {
+    u64 offset = begin_section(file);
+    file.resize(offset + size);
+    if (size > 0) {
+        std::memcpy(file.data() + offset, data, size);
+    }
+
+    return offset;
+}
+
+template <typename T>
+u64 append_section(std::vector<u8> &file, const std::vector<T> &data) {
+    return append_section(file, data.data(), data.size() * sizeof(T));
+}
+
+/**
+ * \brief Get a section of the mapped file as an array
+ * \param file The mapped file
+ * \param offset The offset of the section
+ * \param count The number of elements in the section
+ * \return Pointer to the first element, or nullptr if the section isn't aligned or doesn't fit in the file
+ */
+template <typename T>
+const T *get_section(const MappedFile &file, u64 offset, u64 count) {
+    if (offset % SECTION_ALIGNMENT != 0 || offset > file.getSize() ||
+        count > (file.getSize() - offset) / sizeof(T)) {
+        return nullptr;
+    }
+
+    return reinterpret_cast<const T *>(file.getData() + offset);
+}
+
+}
+
+#endif // IVY_BINARY_SECTIONS_H
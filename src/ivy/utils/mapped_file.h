@@ -0,0 +1,62 @@
+#ifndef IVY_MAPPED_FILE_H
+#define IVY_MAPPED_FILE_H
+
+#include "ivy/types.h"
+#include <string>
+
+namespace ivy {
+
+/**
+ * \brief A read-only view of a whole file mapped into memory. Pages are loaded by the OS on first access, so nothing
+ * is read up front.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * \brief Map a file into memory, any previously mapped file is unmapped
+     * \param path The path to the file
+     * \return Whether or not the file was mapped successfully, empty files can't be mapped
+     */
+    bool open(const std::string &path);
+
+    /**
+     * \brief Unmap the file
+     */
+    void close();
+
+    [[nodiscard]] bool isOpen() const {
+        return data_ != nullptr;
+    }
+
+    /**
+     * \brief Get the contents of the file, the pointer is page aligned
+     * \return Pointer to the file data or nullptr if no file is mapped
+     */
+    [[nodiscard]] const u8 *getData() const {
+        return data_;
+    }
+
+    [[nodiscard]] u64 getSize() const {
+        return size_;
+    }
+
+private:
+    const u8 *data_ = nullptr;
+    u64 size_ = 0;
+
+#ifdef _WIN32
+    void *fileHandle_ = nullptr;
+    void *mappingHandle_ = nullptr;
+#endif
+};
+
+}
+
+#endif // IVY_MAPPED_FILE_H
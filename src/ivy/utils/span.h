@@ -0,0 +1,51 @@
+#ifndef IVY_SPAN_H
+#define IVY_SPAN_H
+
+#include <cstddef>
+
+namespace ivy {
+
+/**
+ * \brief A non-owning view of a contiguous array
+ * \tparam T Element type
+ */
+template <typename T>
+class Span {
+public:
+    Span() = default;
+
+    Span(T *data, size_t size)
+        : data_(data), size_(size) {}
+
+    [[nodiscard]] T *begin() const {
+        return data_;
+    }
+
+    [[nodiscard]] T *end() const {
+        return data_ + size_;
+    }
+
+    [[nodiscard]] T *data() const {
+        return data_;
+    }
+
+    [[nodiscard]] size_t size() const {
+        return size_;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return size_ == 0;
+    }
+
+    T &operator[](size_t idx) const {
+        return data_[idx];
+    }
+
+private:
+    T *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}
+
+#endif // IVY_SPAN_H
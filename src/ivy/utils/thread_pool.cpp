@@ -0,0 +1,170 @@
+#include "thread_pool.h"
+#include "ivy/log.h"
+#include <algorithm>
+
+namespace ivy {
+
+// The pool and queue the current thread belongs to, only set on worker threads
+thread_local const ThreadPool *tlsPool = nullptr;
+thread_local u32 tlsQueueIdx = 0;
+
+ThreadPool::ThreadPool(u32 num_workers) {
+    if (num_workers == 0) {
+        num_workers = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    for (u32 i = 0; i < num_workers; ++i) {
+        queues_.emplace_back(std::make_unique<TaskQueue>());
+    }
+
+    for (u32 i = 0; i < num_workers; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+
+    Log::debug("Created thread pool with % workers", num_workers);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        running_ = false;
+    }
+    sleepCondition_.notify_all();
+
+    for (std::thread &worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(TaskGroup &group, std::function<void()> task) {
+    group.pending_.fetch_add(1, std::memory_order_relaxed);
+
+    // Count the task before it can be taken, otherwise the worker that runs it could decrement the count first. Take
+    // the sleep lock so a worker can't miss the wake up between checking for tasks and going to sleep.
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        numQueuedTasks_.fetch_add(1, std::memory_order_release);
+    }
+
+    TaskQueue &queue = *queues_[getQueueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back({std::move(task), &group});
+    }
+    sleepCondition_.notify_one();
+}
+
+void ThreadPool::wait(TaskGroup &group) {
+    u32 queueIdx = getQueueIndex();
+
+    while (!group.isDone()) {
+        if (!tryRunTask(queueIdx)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(u32 count, u32 chunk_size, const std::function<void(u32, u32)> &fn) {
+    chunk_size = std::max(1u, chunk_size);
+
+    // Not worth the overhead of going wide
+    if (count <= chunk_size) {
+        fn(0, count);
+        return;
+    }
+
+    TaskGroup group;
+    for (u32 begin = 0; begin < count; begin += chunk_size) {
+        u32 end = std::min(count, begin + chunk_size);
+        submit(group, [&fn, begin, end]() {
+            fn(begin, end);
+        });
+    }
+
+    wait(group);
+}
+
+void ThreadPool::workerLoop(u32 queue_idx) {
+    tlsPool = this;
+    tlsQueueIdx = queue_idx;
+
+    while (true) {
+        if (tryRunTask(queue_idx)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleepCondition_.wait(lock, [this]() {
+            return !running_ || numQueuedTasks_.load(std::memory_order_acquire) > 0;
+        });
+
+        if (!running_) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::tryRunTask(u32 queue_idx) {
+    Task task;
+    bool found = false;
+
+    // Newest task from our own queue, it's most likely to still be in cache
+    {
+        TaskQueue &queue = *queues_[queue_idx];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            found = true;
+        }
+    }
+
+    // Otherwise steal the oldest task from another queue. Queues that are locked are skipped at first, if nothing was
+    // found they are waited on in a final pass so that a busy queue isn't mistaken for an empty one.
+    bool skippedQueue = false;
+    for (u32 pass = 0; !found && pass < 2; ++pass) {
+        if (pass == 1 && !skippedQueue) {
+            break;
+        }
+
+        for (u32 i = 1; !found && i < queues_.size(); ++i) {
+            TaskQueue &queue = *queues_[(queue_idx + i) % queues_.size()];
+            std::unique_lock<std::mutex> lock(queue.mutex, std::defer_lock);
+            if (pass == 0) {
+                if (!lock.try_lock()) {
+                    skippedQueue = true;
+                    continue;
+                }
+            } else {
+                lock.lock();
+            }
+
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                found = true;
+            }
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    numQueuedTasks_.fetch_sub(1, std::memory_order_relaxed);
+    task.func();
+    task.group->pending_.fetch_sub(1, std::memory_order_release);
+
+    return true;
+}
+
+u32 ThreadPool::getQueueIndex() {
+    if (tlsPool == this) {
+        return tlsQueueIdx;
+    }
+
+    // Threads outside of the pool spread their tasks over the worker queues
+    return nextExternalQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+}
+
+}
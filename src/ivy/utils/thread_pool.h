@@ -0,0 +1,126 @@
+#ifndef IVY_THREAD_POOL_H
+#define IVY_THREAD_POOL_H
+
+#include "ivy/types.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ivy {
+
+/**
+ * \brief Tracks a set of tasks submitted to a thread pool so they can be waited on together
+ */
+class TaskGroup {
+public:
+    TaskGroup() = default;
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    /**
+     * \return Whether or not every task in the group has finished
+     */
+    [[nodiscard]] bool isDone() const {
+        return pending_.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    friend class ThreadPool;
+
+    std::atomic<u32> pending_ = 0;
+};
+
+/**
+ * \brief A pool of worker threads. Each worker has its own task queue, and idle workers steal tasks from the other
+ * queues so uneven workloads still spread out over every thread.
+ */
+class ThreadPool {
+public:
+    /**
+     * \brief Create a thread pool
+     * \param num_workers The number of worker threads, 0 uses the number of hardware threads minus one
+     */
+    explicit ThreadPool(u32 num_workers = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * \brief Queue a task to be run on a worker thread
+     * \param group The task group the task belongs to
+     * \param task The task
+     */
+    void submit(TaskGroup &group, std::function<void()> task);
+
+    /**
+     * \brief Wait until every task in a group is done, the calling thread runs queued tasks while it waits
+     * \param group The task group to wait for
+     */
+    void wait(TaskGroup &group);
+
+    /**
+     * \brief Run fn(begin, end) over [0, count) split into ranges of at most chunk_size and wait for all of them
+     * \param count The number of items
+     * \param chunk_size The maximum number of items in a single task
+     * \param fn The function to call for each range
+     */
+    void parallelFor(u32 count, u32 chunk_size, const std::function<void(u32, u32)> &fn);
+
+    /**
+     * \brief Get the number of worker threads, this doesn't include threads that help out while waiting
+     * \return Number of worker threads
+     */
+    [[nodiscard]] u32 getNumWorkers() const {
+        return (u32) workers_.size();
+    }
+
+private:
+    struct Task {
+        std::function<void()> func;
+        TaskGroup *group;
+    };
+
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /**
+     * \brief Worker thread entry point
+     * \param queue_idx The index of the worker's own queue
+     */
+    void workerLoop(u32 queue_idx);
+
+    /**
+     * \brief Run a single queued task, trying our own queue first and then stealing from the others
+     * \param queue_idx The index of the calling thread's queue
+     * \return Whether or not a task was run
+     */
+    bool tryRunTask(u32 queue_idx);
+
+    /**
+     * \brief Get the queue the calling thread should use
+     * \return Queue index
+     */
+    u32 getQueueIndex();
+
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::atomic<u32> numQueuedTasks_ = 0;
+    std::atomic<u32> nextExternalQueue_ = 0;
+    std::atomic<bool> running_ = true;
+
+    std::mutex sleepMutex_;
+    std::condition_variable sleepCondition_;
+};
+
+}
+
+#endif // IVY_THREAD_POOL_H
@@ -1,5 +1,8 @@
 #include "utils.h"
+#include "ivy/utils/mapped_file.h"
+#include <cstring>
 #include <ctime>
+#include <filesystem>
 #include <iomanip>
 #include <sstream>
 
@@ -24,4 +27,50 @@ std::string get_date_time_as_string() {
     return os.str();
 }
 
+u64 hash_bytes(const void *data, u64 size, u64 seed) {
+    constexpr u64 MULTIPLIER = 0xff51afd7ed558ccdull;
+    const u8 *bytes = static_cast<const u8 *>(data);
+
+    auto mix = [](u64 hash) {
+        hash ^= hash >> 33;
+        hash *= MULTIPLIER;
+        hash ^= hash >> 33;
+        return hash;
+    };
+
+    // Eight bytes at a time, files can be large
+    u64 hash = seed ^ (size * 0x9e3779b97f4a7c15ull);
+    u64 i = 0;
+    for (; i + sizeof(u64) <= size; i += sizeof(u64)) {
+        u64 word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = mix(hash ^ word) * MULTIPLIER;
+    }
+
+    if (i < size) {
+        u64 word = 0;
+        std::memcpy(&word, bytes + i, size - i);
+        hash = mix(hash ^ word) * MULTIPLIER;
+    }
+
+    return mix(hash);
+}
+
+bool hash_file(const std::string &path, u64 &out_hash) {
+    MappedFile file;
+    if (!file.open(path)) {
+        // Empty files can't be mapped
+        std::error_code error;
+        if (std::filesystem::is_regular_file(path, error) && std::filesystem::file_size(path, error) == 0) {
+            out_hash = hash_bytes(nullptr, 0);
+            return true;
+        }
+
+        return false;
+    }
+
+    out_hash = hash_bytes(file.getData(), file.getSize());
+    return true;
+}
+
 }
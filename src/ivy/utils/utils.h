@@ -1,6 +1,7 @@
 #ifndef IVY_UTILS_H
 #define IVY_UTILS_H
 
+#include "ivy/types.h"
 #include <glm/glm.hpp>
 #include <string>
 
@@ -12,6 +13,23 @@ namespace ivy {
  */
 std::string get_date_time_as_string();
 
+/**
+ * \brief Hash a block of memory, this is fast but not cryptographically secure
+ * \param data The data to hash
+ * \param size The size of the data in bytes
+ * \param seed Seed that is mixed into the hash, use it to chain hashes together
+ * \return The 64 bit hash
+ */
+u64 hash_bytes(const void *data, u64 size, u64 seed = 0);
+
+/**
+ * \brief Hash the contents of a file with hash_bytes
+ * \param path The path to the file
+ * \param out_hash The hash is written here
+ * \return Whether or not the file could be read
+ */
+bool hash_file(const std::string &path, u64 &out_hash);
+
 }
 
 /**
@@ -57,7 +57,9 @@ Renderer::Renderer(gfx::RenderDevice &render_device)
 
     // TODO: shader files should be a part of resource manager
 
-    linearSampler_ = device_.createSampler(VK_FILTER_LINEAR, VK_FILTER_LINEAR);
+    // Material textures have full mip chains, anisotropic filtering keeps surfaces at grazing angles sharp
+    linearSampler_ = device_.createSampler(VK_FILTER_LINEAR, VK_FILTER_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                                           VK_SAMPLER_ADDRESS_MODE_REPEAT, VK_SAMPLER_ADDRESS_MODE_REPEAT, 16.0f);
     nearestSampler_ = device_.createSampler(VK_FILTER_NEAREST, VK_FILTER_NEAREST);
 
     // Find best format for depth
@@ -94,8 +96,8 @@ Renderer::Renderer(gfx::RenderDevice &render_device)
                     // trivial fragment shader
                     .addVertexDescription(gfx::VertexP3N3T3B3UV2::getBindingDescriptions(),
                                           gfx::VertexP3N3T3B3UV2::getAttributeDescriptions())
-                    .addUniformBufferDescriptor(0, 0, VK_SHADER_STAGE_VERTEX_BIT)
-                    .addUniformBufferDescriptor(1, 0, VK_SHADER_STAGE_VERTEX_BIT)
+                    .addDynamicUniformBufferDescriptor(0, 0, VK_SHADER_STAGE_VERTEX_BIT)
+                    .addPushConstantRange(VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PerMeshShadowPass))
                     .addDepthAttachment("depth")
                     .build()
                    )
@@ -114,8 +116,9 @@ Renderer::Renderer(gfx::RenderDevice &render_device)
                     .addShader(gfx::Shader::StageEnum::FRAGMENT, "../assets/shaders/shadow_point.frag.spv")
                     .addVertexDescription(gfx::VertexP3N3T3B3UV2::getBindingDescriptions(),
                                           gfx::VertexP3N3T3B3UV2::getAttributeDescriptions())
-                    .addUniformBufferDescriptor(0, 0, VK_SHADER_STAGE_GEOMETRY_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
-                    .addUniformBufferDescriptor(1, 0, VK_SHADER_STAGE_VERTEX_BIT)
+                    .addDynamicUniformBufferDescriptor(0, 0,
+                                                       VK_SHADER_STAGE_GEOMETRY_BIT | VK_SHADER_STAGE_FRAGMENT_BIT)
+                    .addPushConstantRange(VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PerMeshShadowPass))
                     .addDepthAttachment("depth")
                     .build()
                    )
@@ -140,7 +143,7 @@ Renderer::Renderer(gfx::RenderDevice &render_device)
                     .addColorAttachment("normal", 1)
                     .addColorAttachment("occlusion_roughness_metallic", 2)
                     .addDepthAttachment("depth")
-                    .addUniformBufferDescriptor(0, 0, VK_SHADER_STAGE_VERTEX_BIT)
+                    .addDynamicUniformBufferDescriptor(0, 0, VK_SHADER_STAGE_VERTEX_BIT)
                     .addTextureDescriptor(1, 0, VK_SHADER_STAGE_FRAGMENT_BIT)
                     .addTextureDescriptor(1, 1, VK_SHADER_STAGE_FRAGMENT_BIT)
                     .addTextureDescriptor(1, 2, VK_SHADER_STAGE_FRAGMENT_BIT)
@@ -161,7 +164,7 @@ Renderer::Renderer(gfx::RenderDevice &render_device)
                     .addUniformBufferDescriptor(1, 0, VK_SHADER_STAGE_FRAGMENT_BIT)
                     .addTextureDescriptor(1, 1, VK_SHADER_STAGE_FRAGMENT_BIT)
                     .addTextureDescriptor(1, 2, VK_SHADER_STAGE_FRAGMENT_BIT)
-                    .addUniformBufferDescriptor(2, 0, VK_SHADER_STAGE_FRAGMENT_BIT)
+                    .addDynamicUniformBufferDescriptor(2, 0, VK_SHADER_STAGE_FRAGMENT_BIT)
                     .build()
                    )
         .addSubpassDependency(gfx::GraphicsPass::SwapchainName, "gbuffer_pass",
@@ -189,6 +192,9 @@ void Renderer::render(Scene &scene, DebugMode debug_mode) {
     gfx::GraphicsPass &shadowPassPoint = passes_.at(1);
     gfx::GraphicsPass &lightingPass = passes_.at(2);
 
+    // Make sure the cached model matrices are up to date
+    scene.updateTransforms();
+
     // Find camera in entities
     EntityHandle cameraEntity = scene.findEntityWithAllComponents<Camera, Transform>();
     Camera camera;
@@ -200,6 +206,10 @@ void Renderer::render(Scene &scene, DebugMode debug_mode) {
         cameraTransform = *cameraEntity->getComponent<Transform>();
     }
 
+    // Collect the meshes to cull for each view and pick the camera LOD of each model
+    gatherDraws(scene, cameraTransform.getPosition(), 1.0f / std::tan(camera.getFovY() * 0.5f),
+                (f32) lightingPass.getExtent().height);
+
     // Transition point shadow map back from previous frame for writing
     {
         VkImageMemoryBarrier memoryBarrier = {};
@@ -225,26 +235,17 @@ void Renderer::render(Scene &scene, DebugMode debug_mode) {
         cmd.bindGraphicsPipeline(shadowPassPoint, 0);
         cmd.setViewport(0, 0, (f32) shadowMapSizePoint_, (f32) shadowMapSizePoint_);
 
-        std::vector<EntityHandle> lightEntities = scene.findEntitiesWithAllComponents<Transform, PointLight>();
-        std::vector<EntityHandle> shadowCasters = scene.findEntitiesWithAllComponents<Transform, Model>();
-
         // TODO: sort by distance from camera
 
         // Render shadow maps
         numShadowsPoint_ = 0;
-        for (auto &lightEntity : lightEntities) {
-            if (numShadowsPoint_ >= maxShadowCastingPointLights_) {
-                break;
-            }
-
-            Transform *lightTransform = lightEntity->getComponent<Transform>();
-            PointLight *light = lightEntity->getComponent<PointLight>();
-            if (!light->castsShadows()) {
-                continue;
+        scene.forEach<Transform, PointLight>([&](Transform &lightTransform, PointLight &light) {
+            if (numShadowsPoint_ >= maxShadowCastingPointLights_ || !light.castsShadows()) {
+                return;
             }
 
             // View projection matrices
-            glm::vec3 p = lightTransform->getPosition();
+            glm::vec3 p = lightTransform.getWorldPosition();
             glm::mat4 vpMatrices[6] = {
                 glm::lookAt(p, p + glm::vec3( 1,  0,  0), glm::vec3(0, -1, 0)),
                 glm::lookAt(p, p + glm::vec3(-1,  0,  0), glm::vec3(0, -1, 0)),
@@ -254,7 +255,7 @@ void Renderer::render(Scene &scene, DebugMode debug_mode) {
                 glm::lookAt(p, p + glm::vec3( 0,  0, -1), glm::vec3(0, -1, 0)),
             };
 
-            glm::mat4 projection = glm::perspective(glm::half_pi<f32>(), 1.0f, light->getNearPlane(), light->getFarPlane());
+            glm::mat4 projection = glm::perspective(glm::half_pi<f32>(), 1.0f, light.getNearPlane(), light.getFarPlane());
 
             // Send view projection matrix for face to shader
             PerLightPointShadowPass perLight = {};
@@ -262,36 +263,34 @@ void Renderer::render(Scene &scene, DebugMode debug_mode) {
                 perLight.viewProjectionMatrices[i] = projection * vpMatrices[i];
             }
             perLight.lightPosition = p;
-            perLight.nearAndFarPlanes = glm::vec2(light->getNearPlane(), light->getFarPlane());
+            perLight.nearAndFarPlanes = glm::vec2(light.getNearPlane(), light.getFarPlane());
             perLight.lightIndex = numShadowsPoint_;
 
             gfx::DescriptorSet perLightSet(shadowPassPoint, 0, 0);
-            perLightSet.setUniformBuffer(0, perLight);
+            perLightSet.setDynamicUniformBuffer(0, perLight);
             cmd.setDescriptorSet(device_, shadowPassPoint, perLightSet);
 
-            // Render into shadow map
-            // TODO: set a max range
-            for (auto &caster : shadowCasters) {
-                Transform *transform = caster->getComponent<Transform>();
-                Model *model = caster->getComponent<Model>();
-
+            // Render into shadow map, only meshes in range of the light can cast a shadow
+            cull_bounds(drawBounds_, Sphere(p, light.getFarPlane()), visible_);
+            for (u32 drawIdx : visible_) {
+                const DrawItem &draw = draws_[drawIdx];
                 PerMeshShadowPass perMesh = {};
-                perMesh.model = transform->getModelMatrix();
+                perMesh.model = draw.transform->getModelMatrix();
 
-                // Iterate over meshes in model at max lod
-                for (const gfx::Mesh &mesh : model->getMeshes(ResourceManager::MAX_LOD)) {
-                    // Send to shader
-                    gfx::DescriptorSet perMeshSet(shadowPassPoint, 0, 1);
-                    perMeshSet.setUniformBuffer(0, perMesh);
-                    cmd.setDescriptorSet(device_, shadowPassPoint, perMeshSet);
+                // Each face is a 90 degree perspective view, so the projection scale is 1
+                u32 lod = shadowLodPolicy_.selectLod(
+                    gfx::LodPolicy::projectedSizePerspective(draw.modelBounds, p, 1.0f, (f32) shadowMapSizePoint_));
+                const gfx::Mesh &mesh = draw.model->getMeshes(lod).at(draw.meshIdx);
 
-                    // Draw this mesh
-                    mesh.getGeometry().draw(cmd);
-                }
+                // Send to shader
+                cmd.pushConstants(shadowPassPoint, 0, VK_SHADER_STAGE_VERTEX_BIT, perMesh);
+
+                // Draw this mesh
+                mesh.getGeometry().draw(cmd);
             }
 
             ++numShadowsPoint_;
-        }
+        });
     });
 
     // Transition point shadow map for reading
@@ -336,16 +335,13 @@ void Renderer::render(Scene &scene, DebugMode debug_mode) {
     cmd.executeGraphicsPass(device_, shadowPassDirectional, [&]() {
         cmd.bindGraphicsPipeline(shadowPassDirectional, 0);
 
-        std::vector<EntityHandle> lightEntities = scene.findEntitiesWithAnyComponents<DirectionalLight>();
-
         // Count number of shadow casting lights
         numShadowsDirectional_ = 0;
-        for (auto &lightEntity : lightEntities) {
-            DirectionalLight *light = lightEntity->getComponent<DirectionalLight>();
-            if (light && light->castsShadows()) {
+        scene.forEach<DirectionalLight>([&](DirectionalLight &light) {
+            if (light.castsShadows()) {
                 ++numShadowsDirectional_;
             }
-        }
+        });
 
         // No directional lights, return
         if (numShadowsDirectional_ == 0) {
@@ -357,10 +353,9 @@ void Renderer::render(Scene &scene, DebugMode debug_mode) {
         u32 shadowIdx = 0;
 
         // Render shadow maps
-        for (auto &lightEntity : lightEntities) {
-            DirectionalLight *light = lightEntity->getComponent<DirectionalLight>();
-            if (light && !light->castsShadows()) {
-                continue;
+        scene.forEach<DirectionalLight>([&](DirectionalLight &light) {
+            if (!light.castsShadows()) {
+                return;
             }
 
             // Calculate viewport
@@ -369,35 +364,32 @@ void Renderer::render(Scene &scene, DebugMode debug_mode) {
 
             // Light data
             PerLightDirectionalShadowPass perLight = {};
-            perLight.viewProjection = light->calculateViewProjectionMatrix(cameraTransform, camera);
+            perLight.viewProjection = light.calculateViewProjectionMatrix(cameraTransform, camera);
 
             // Send to shader
             gfx::DescriptorSet perLightSet(shadowPassDirectional, 0, 0);
-            perLightSet.setUniformBuffer(0, perLight);
+            perLightSet.setDynamicUniformBuffer(0, perLight);
             cmd.setDescriptorSet(device_, shadowPassDirectional, perLightSet);
 
-            // Go over entities and draw
-            for (EntityHandle &entity : scene.findEntitiesWithAllComponents<Transform, Model>()) {
-                Transform *transform = entity->getComponent<Transform>();
-                Model *model = entity->getComponent<Model>();
-
+            // Draw the meshes inside of the light's volume
+            cull_bounds(drawBounds_, Frustum(perLight.viewProjection), visible_);
+            for (u32 drawIdx : visible_) {
+                const DrawItem &draw = draws_[drawIdx];
                 PerMeshShadowPass perMesh = {};
-                perMesh.model = transform->getModelMatrix();
+                perMesh.model = draw.transform->getModelMatrix();
 
-                // Iterate over meshes in model
-                for (const gfx::Mesh &mesh : model->getMeshes()) {
-                    // Send to shader
-                    gfx::DescriptorSet perMeshSet(shadowPassDirectional, 0, 1);
-                    perMeshSet.setUniformBuffer(0, perMesh);
-                    cmd.setDescriptorSet(device_, shadowPassDirectional, perMeshSet);
+                // Send to shader
+                cmd.pushConstants(shadowPassDirectional, 0, VK_SHADER_STAGE_VERTEX_BIT, perMesh);
 
-                    // Draw this mesh
-                    mesh.getGeometry().draw(cmd);
-                }
+                // Draw this mesh with a LOD for the shadow map's texel density
+                u32 lod = shadowLodPolicy_.selectLod(
+                    gfx::LodPolicy::projectedSizeOrthographic(draw.modelBounds, perLight.viewProjection,
+                                                              (f32) shadowSizeDirectional_));
+                draw.model->getMeshes(lod).at(draw.meshIdx).getGeometry().draw(cmd);
             }
 
             ++shadowIdx;
-        }
+        });
     });
 
     // Transition directional shadow map for reading
@@ -438,35 +430,33 @@ void Renderer::render(Scene &scene, DebugMode debug_mode) {
             mvpData.view = glm::lookAt(cameraTransform.getPosition(),
                                        cameraTransform.getPosition() + cameraTransform.getForward(), Transform::UP);
 
-            // Go over entities and draw
-            for (EntityHandle &entity : scene.findEntitiesWithAllComponents<Transform, Model>()) {
-                Transform *transform = entity->getComponent<Transform>();
-                Model *model         = entity->getComponent<Model>();
+            // Draw the meshes the camera can see
+            cull_bounds(drawBounds_, Frustum(mvpData.proj * mvpData.view), visible_);
+            for (u32 drawIdx : visible_) {
+                const DrawItem &draw = draws_[drawIdx];
+                const gfx::Mesh &mesh = draw.model->getMeshes(draw.lod).at(draw.meshIdx);
 
                 // Set the model and normal matrix
-                mvpData.model = transform->getModelMatrix();
-                mvpData.normal = glm::inverse(glm::transpose(mvpData.model));
-
-                // Iterate over meshes in model
-                for (const gfx::Mesh &mesh : model->getMeshes()) {
-                    // Put MVP data in a descriptor set and bind it
-                    gfx::DescriptorSet mvpSet(lightingPass, subpassIdx, 0);
-                    mvpSet.setUniformBuffer(0, mvpData);
-                    cmd.setDescriptorSet(device_, lightingPass, mvpSet);
-
-                    // Material data
-                    const gfx::Material &mat = mesh.getMaterial();
-                    gfx::DescriptorSet materialSet(lightingPass, subpassIdx, 1);
-                    materialSet.setTexture(0, mat.getDiffuseTexture(), linearSampler_);
-                    materialSet.setTexture(1, mat.getNormalTexture(), linearSampler_);
-                    materialSet.setTexture(2, mat.getOcclusionTexture(), linearSampler_);
-                    materialSet.setTexture(3, mat.getRoughnessTexture(), linearSampler_);
-                    materialSet.setTexture(4, mat.getMetallicTexture(), linearSampler_);
-                    cmd.setDescriptorSet(device_, lightingPass, materialSet);
-
-                    // Draw this mesh
-                    mesh.getGeometry().draw(cmd);
-                }
+                mvpData.model = draw.transform->getModelMatrix();
+                mvpData.normal = draw.transform->getNormalMatrix();
+
+                // Put MVP data in a descriptor set and bind it
+                gfx::DescriptorSet mvpSet(lightingPass, subpassIdx, 0);
+                mvpSet.setDynamicUniformBuffer(0, mvpData);
+                cmd.setDescriptorSet(device_, lightingPass, mvpSet);
+
+                // Material data
+                const gfx::Material &mat = mesh.getMaterial();
+                gfx::DescriptorSet materialSet(lightingPass, subpassIdx, 1);
+                materialSet.setTexture(0, mat.getDiffuseTexture(), linearSampler_);
+                materialSet.setTexture(1, mat.getNormalTexture(), linearSampler_);
+                materialSet.setTexture(2, mat.getOcclusionTexture(), linearSampler_);
+                materialSet.setTexture(3, mat.getRoughnessTexture(), linearSampler_);
+                materialSet.setTexture(4, mat.getMetallicTexture(), linearSampler_);
+                cmd.setDescriptorSet(device_, lightingPass, materialSet);
+
+                // Draw this mesh
+                mesh.getGeometry().draw(cmd);
             }
         }
 
@@ -503,66 +493,89 @@ void Renderer::render(Scene &scene, DebugMode debug_mode) {
                 cmd.setDescriptorSet(device_, lightingPass, perFrameSet);
             }
 
-            // TODO: this depends on the order of lights being the same
-
-            // Draw lights
-            u32 dirShadowIdx = 0;
-            u32 pntShadowIdx = 0;
-            for (auto &lightEntity : scene.findEntitiesWithAnyComponents<DirectionalLight, PointLight>()) {
-                DirectionalLight *dirLight  = lightEntity->getComponent<DirectionalLight>();
-                PointLight       *pntLight  = lightEntity->getComponent<PointLight>();
-                Transform        *transform = lightEntity->getComponent<Transform>();
-
-                PerLightLightingPass perLight = {};
+            // Lights are visited in the same order as in the shadow passes, so the shadow indices line up
 
-                if (dirLight) {
-                    perLight.viewProjection = dirLight->calculateViewProjectionMatrix(cameraTransform, camera);
-                    perLight.directionAndShadowBias = glm::vec4(dirLight->getDirection(), dirLight->getShadowBias());
-                    perLight.colorAndIntensity = glm::vec4(dirLight->getColor(), dirLight->getIntensity());
-                    perLight.lightType = LightType::DIRECTIONAL;
-                    if (dirLight->castsShadows()) {
-                        perLight.shadowViewportNormalized = getShadowViewport(dirShadowIdx) / (f32) shadowMapSizeDirectional_;
-                        perLight.shadowIndex = dirShadowIdx;
-                        ++dirShadowIdx;
-                    } else {
-                        perLight.shadowIndex = (u32)(-1);
-                    }
-                } else if (pntLight && transform) {
-                    // TODO: better names for variables that are shared/interpreted differently depending on light type
-
-                    perLight.directionAndShadowBias = glm::vec4(transform->getPosition(), pntLight->getShadowBias());
-                    perLight.colorAndIntensity = glm::vec4(pntLight->getColor(), pntLight->getIntensity());
-                    perLight.shadowViewportNormalized = glm::vec4(pntLight->getNearPlane(), pntLight->getFarPlane(), 0, 0);
-                    perLight.lightType = LightType::POINT;
-                    if (pntLight->castsShadows() && pntShadowIdx < maxShadowCastingPointLights_) {
-                        perLight.shadowIndex = pntShadowIdx;
-                        ++pntShadowIdx;
-                    } else {
-                        perLight.shadowIndex = (u32)(-1);
-                    }
-                } else {
-                    continue;
+            // Draw a single light, if we're using a debug mode only the first light is drawn
+            // Otherwise, we additively blend debug rendering for each light
+            bool drewLight = false;
+            auto drawLight = [&](const PerLightLightingPass &perLight) {
+                if (drewLight && debug_mode != DebugMode::FULL) {
+                    return;
                 }
 
                 gfx::DescriptorSet perLightSet(lightingPass, subpassIdx, 2);
-                perLightSet.setUniformBuffer(0, perLight);
+                perLightSet.setDynamicUniformBuffer(0, perLight);
                 cmd.setDescriptorSet(device_, lightingPass, perLightSet);
 
                 // Draw our fullscreen triangle
                 cmd.draw(3, 1, 0, 0);
+                drewLight = true;
+            };
 
-                // If we're using a debug mode, only draw once
-                // Otherwise, we additively blend debug rendering for each light
-                if (debug_mode != DebugMode::FULL) {
-                    break;
+            // Draw directional lights
+            u32 dirShadowIdx = 0;
+            scene.forEach<DirectionalLight>([&](DirectionalLight &dirLight) {
+                PerLightLightingPass perLight = {};
+                perLight.viewProjection = dirLight.calculateViewProjectionMatrix(cameraTransform, camera);
+                perLight.directionAndShadowBias = glm::vec4(dirLight.getDirection(), dirLight.getShadowBias());
+                perLight.colorAndIntensity = glm::vec4(dirLight.getColor(), dirLight.getIntensity());
+                perLight.lightType = LightType::DIRECTIONAL;
+                if (dirLight.castsShadows()) {
+                    perLight.shadowViewportNormalized = getShadowViewport(dirShadowIdx) / (f32) shadowMapSizeDirectional_;
+                    perLight.shadowIndex = dirShadowIdx;
+                    ++dirShadowIdx;
+                } else {
+                    perLight.shadowIndex = (u32)(-1);
                 }
-            }
+
+                drawLight(perLight);
+            });
+
+            // Draw point lights
+            u32 pntShadowIdx = 0;
+            scene.forEach<Transform, PointLight>([&](Transform &transform, PointLight &pntLight) {
+                // TODO: better names for variables that are shared/interpreted differently depending on light type
+
+                PerLightLightingPass perLight = {};
+                perLight.directionAndShadowBias = glm::vec4(transform.getWorldPosition(), pntLight.getShadowBias());
+                perLight.colorAndIntensity = glm::vec4(pntLight.getColor(), pntLight.getIntensity());
+                perLight.shadowViewportNormalized = glm::vec4(pntLight.getNearPlane(), pntLight.getFarPlane(), 0, 0);
+                perLight.lightType = LightType::POINT;
+                if (pntLight.castsShadows() && pntShadowIdx < maxShadowCastingPointLights_) {
+                    perLight.shadowIndex = pntShadowIdx;
+                    ++pntShadowIdx;
+                } else {
+                    perLight.shadowIndex = (u32)(-1);
+                }
+
+                drawLight(perLight);
+            });
         }
     });
 
     device_.endFrame();
 }
 
+void Renderer::gatherDraws(Scene &scene, const glm::vec3 &camera_position, f32 projection_scale_y,
+                           f32 viewport_height) {
+    draws_.clear();
+    drawBounds_.clear();
+
+    scene.forEach<const Transform, Model>([&](const Transform &transform, Model &model) {
+        // The LOD is picked from the LOD0 sphere so that it doesn't depend on the current LOD
+        Sphere modelBounds = model.getWorldBoundingSphere(transform);
+        f32 projectedSize = gfx::LodPolicy::projectedSizePerspective(modelBounds, camera_position, projection_scale_y,
+                                                                     viewport_height);
+        model.setLod(cameraLodPolicy_.selectLod(projectedSize, model.getLod()));
+
+        const std::vector<gfx::Mesh> &meshes = model.getMeshes();
+        for (u32 i = 0; i < meshes.size(); ++i) {
+            draws_.push_back({&transform, &model, i, model.getLod(), modelBounds});
+            drawBounds_.add(meshes[i].getBounds().transformed(transform.getModelMatrix()));
+        }
+    });
+}
+
 glm::vec4 Renderer::getShadowViewport(ivy::u32 shadow_idx) const {
     return glm::vec4(
                (shadow_idx % shadowsPerSideDirectional_) * shadowSizeDirectional_,
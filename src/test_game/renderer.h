@@ -8,6 +8,10 @@
 #include "ivy/graphics/geometry.h"
 #include "ivy/graphics/texture.h"
 #include "ivy/scene/scene.h"
+#include "ivy/scene/components/transform.h"
+#include "ivy/scene/components/model.h"
+#include "ivy/graphics/lod_policy.h"
+#include "ivy/math/batch_cull.h"
 
 /**
  * \brief High level renderer
@@ -30,8 +34,30 @@ public:
     void render(ivy::Scene &scene, DebugMode debug_mode = DebugMode::FULL);
 
 private:
+    /**
+     * \brief A single mesh of a model that might be drawn this frame
+     */
+    struct DrawItem {
+        const ivy::Transform *transform;
+        const ivy::Model *model;
+        ivy::u32 meshIdx; // The same index is used for every LOD
+        ivy::u32 lod;     // LOD level for the camera
+        ivy::Sphere modelBounds; // World bounding sphere of the whole model, used for shadow LOD selection
+    };
+
     [[nodiscard]] glm::vec4 getShadowViewport(ivy::u32 shadow_idx) const;
 
+    /**
+     * \brief Collect every mesh in the scene and its world bounds and select the camera LOD of each model, should be
+     * called after the transforms are updated
+     * \param scene The scene
+     * \param camera_position The position of the camera in world space
+     * \param projection_scale_y The y scale of the camera's projection matrix
+     * \param viewport_height The height of the camera's viewport in pixels
+     */
+    void gatherDraws(ivy::Scene &scene, const glm::vec3 &camera_position, ivy::f32 projection_scale_y,
+                     ivy::f32 viewport_height);
+
     ivy::gfx::RenderDevice &device_;
     std::vector<ivy::gfx::GraphicsPass> passes_;
 
@@ -48,6 +74,14 @@ private:
     const ivy::u32 maxShadowCastingPointLights_ = 2;
     ivy::u32 numShadowsPoint_ = 0;
     std::optional<ivy::gfx::Texture> pointLightShadowAtlas_;
+
+    // Shadow maps are lower resolution than the screen and are only seen through lighting, so they use coarser LODs
+    const ivy::gfx::LodPolicy cameraLodPolicy_ = ivy::gfx::LodPolicy(512.0f);
+    const ivy::gfx::LodPolicy shadowLodPolicy_ = ivy::gfx::LodPolicy(256.0f);
+
+    std::vector<DrawItem> draws_;
+    ivy::BoundsBatch drawBounds_;   // World bounds of draws_ at LOD0, which contain the bounds of every other LOD
+    std::vector<ivy::u32> visible_; // Indices into draws_ that survived culling for the current view
 };
 
 #endif // IVY_RENDERER_H
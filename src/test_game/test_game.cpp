@@ -1,7 +1,7 @@
 #include "test_game.h"
 #include "ivy/types.h"
 #include "ivy/log.h"
-#include "ivy/scene/entity.h"
+#include "ivy/scene/scene.h"
 #include "ivy/scene/components/transform.h"
 #include "ivy/scene/components/model.h"
 #include "ivy/scene/components/camera.h"
@@ -13,8 +13,13 @@
 
 using namespace ivy;
 
+static const Tag HELMET_TAG("helmet");
+static const Tag POINT_LIGHT_TAG("pnt_light");
+static const Tag SPONZA_TAG("sponza");
+static const Tag CAMERA_TAG("camera");
+
 TestGame::TestGame()
-    : engine_(getOptions()), renderer_(engine_.getRenderDevice()) {
+    : engine_(getOptions()), renderer_(engine_.getRenderDevice()), spatialIndex_(scene_) {
 
     // Set logging level
     Log::logLevel = Log::LogLevel::DEBUG;
@@ -35,13 +40,20 @@ TestGame::TestGame()
 void TestGame::init() {
     ResourceManager &resourceManager = engine_.getResourceManager();
 
+    // Models are streamed in while the game runs, they aren't drawn until they have loaded
+
     // Add helmets
-    for (i32 i = 0; i < 10; ++i) {
-        EntityHandle helmet = scene_.createEntity();
-        helmet->setComponent(Transform(glm::vec3((i - 5) * 2, 1, 0), glm::vec3(0), glm::vec3(2)));
-        helmet->setTag("helmet");
-        helmet->setComponent(Model(
-                                 resourceManager.getModel("models/glTF-Sample-Models/2.0/FlightHelmet/glTF/FlightHelmet.gltf")));
+    {
+        Prefab helmetPrefab;
+        helmetPrefab.setComponent(Transform(glm::vec3(0), glm::vec3(0), glm::vec3(2)));
+        helmetPrefab.setTag(HELMET_TAG);
+        helmetPrefab.setComponent(Model(
+                                      resourceManager.getModelAsync("models/glTF-Sample-Models/2.0/FlightHelmet/glTF/FlightHelmet.gltf")));
+
+        Span<EntityHandle> helmets = scene_.createEntities(10, helmetPrefab);
+        for (u32 i = 0; i < helmets.size(); ++i) {
+            helmets[i]->getComponent<Transform>()->setPosition(glm::vec3(((i32) i - 5) * 2, 1, 0));
+        }
     }
 
     // Add lights
@@ -59,21 +71,21 @@ void TestGame::init() {
         EntityHandle light = scene_.createEntity();
         light->setComponent(Transform(glm::vec3(x, y, z)));
         light->setComponent(PointLight(colors[i], 400));
-        light->setTag("pnt_light");
+        light->setTag(POINT_LIGHT_TAG);
     }
 
     // Add sponza
     {
         EntityHandle sponza = scene_.createEntity();
-        sponza->setTag("sponza");
+        sponza->setTag(SPONZA_TAG);
         sponza->setComponent<Transform>();
-        sponza->setComponent(Model(resourceManager.getModel("models/sponza/sponza.obj")));
+        sponza->setComponent(Model(resourceManager.getModelAsync("models/sponza/sponza.obj")));
     }
 
     // Add camera
     {
         EntityHandle camera = scene_.createEntity();
-        camera->setTag("camera");
+        camera->setTag(CAMERA_TAG);
         camera->setComponent(Transform(glm::vec3(0.25, 2, -1), glm::vec3(6.2, 2.5, 0)));
         camera->setComponent<Camera>();
     }
@@ -107,24 +119,20 @@ void TestGame::update() {
         Log::debug("Rendering shadow map");
     }
 
+    // Bring the spatial index up to date with the changes from the last frame
+    scene_.updateTransforms();
+    spatialIndex_.update();
+
     // Delete nearest light
     if (input.isKeyPressed(GLFW_KEY_BACKSPACE)) {
         if (EntityHandle camera = scene_.findEntityWithAllComponents<Transform, Camera>()) {
-            Transform ct = *camera->getComponent<Transform>();
-
-            // Find nearest light
-            EntityHandle nearestEntity(scene_);
-            f32 nearest = 0.0f;
-            for (EntityHandle light : scene_.findEntitiesWithAllComponents<Transform, PointLight>()) {
-                Transform lt = *light->getComponent<Transform>();
-                f32 dist = glm::distance(lt.getPosition(), ct.getPosition());
-                if (!nearestEntity || dist < nearest) {
-                    nearest = dist;
-                    nearestEntity = light;
-                }
-            }
+            glm::vec3 cameraPosition = camera->getComponent<Transform>()->getWorldPosition();
 
-            scene_.deleteEntity(nearestEntity);
+            std::vector<EntityHandle> nearest = spatialIndex_.findNearest(SpatialIndex::Layer::POINT_LIGHTS,
+                                                                          cameraPosition, 1);
+            if (!nearest.empty()) {
+                scene_.deleteEntity(nearest.front());
+            }
         }
     }
 
@@ -137,59 +145,54 @@ void TestGame::update() {
         }
     }
 
-    // Update entities
+    // Update the rotation for the helmets
     f32 time = (f32) glfwGetTime();
-    for (EntityHandle entity : scene_) {
-        Transform *transform = entity->getComponent<Transform>();
-        if (!transform) {
-            continue;
-        }
-
-        // Update the rotation for the helmet
-        if (entity->hasTag("helmet")) {
-            transform->setRotation(glm::vec3(0, time * 0.5f, 0));
+    scene_.parallelForEach<Transform, const Model>(engine_.getThreadPool(),
+    [time](EntityHandle entity, Transform &transform, const Model &) {
+        if (entity->hasTag(HELMET_TAG)) {
+            transform.setRotation(glm::vec3(0, time * 0.5f, 0));
         }
+    });
 
-        // Update camera
-        if (entity->getComponent<Camera>()) {
-            f32 moveSpeed = 5.0f * dt;
-            f32 rotateSpeed = glm::half_pi<f32>() * dt;
+    // Update camera
+    scene_.forEach<Transform, Camera>([&](Transform &transform, Camera &) {
+        f32 moveSpeed = 5.0f * dt;
+        f32 rotateSpeed = glm::half_pi<f32>() * dt;
 
-            // Movement
-            if (input.isKeyDown(GLFW_KEY_W)) {
-                transform->addPosition(moveSpeed * transform->getForward());
-            }
-            if (input.isKeyDown(GLFW_KEY_S)) {
-                transform->addPosition(-moveSpeed * transform->getForward());
-            }
-            if (input.isKeyDown(GLFW_KEY_D)) {
-                transform->addPosition(moveSpeed * transform->getRight());
-            }
-            if (input.isKeyDown(GLFW_KEY_A)) {
-                transform->addPosition(-moveSpeed * transform->getRight());
-            }
-            if (input.isKeyDown(GLFW_KEY_SPACE)) {
-                transform->addPosition(moveSpeed * Transform::UP);
-            }
-            if (input.isKeyDown(GLFW_KEY_LEFT_CONTROL)) {
-                transform->addPosition(-moveSpeed * Transform::UP);
-            }
+        // Movement
+        if (input.isKeyDown(GLFW_KEY_W)) {
+            transform.addPosition(moveSpeed * transform.getForward());
+        }
+        if (input.isKeyDown(GLFW_KEY_S)) {
+            transform.addPosition(-moveSpeed * transform.getForward());
+        }
+        if (input.isKeyDown(GLFW_KEY_D)) {
+            transform.addPosition(moveSpeed * transform.getRight());
+        }
+        if (input.isKeyDown(GLFW_KEY_A)) {
+            transform.addPosition(-moveSpeed * transform.getRight());
+        }
+        if (input.isKeyDown(GLFW_KEY_SPACE)) {
+            transform.addPosition(moveSpeed * Transform::UP);
+        }
+        if (input.isKeyDown(GLFW_KEY_LEFT_CONTROL)) {
+            transform.addPosition(-moveSpeed * Transform::UP);
+        }
 
-            // Rotation
-            if (input.isKeyDown(GLFW_KEY_RIGHT)) {
-                transform->addRotation(Transform::UP * -rotateSpeed);
-            }
-            if (input.isKeyDown(GLFW_KEY_LEFT)) {
-                transform->addRotation(Transform::UP * rotateSpeed);
-            }
-            if (input.isKeyDown(GLFW_KEY_UP)) {
-                transform->addRotation(Transform::RIGHT * rotateSpeed);
-            }
-            if (input.isKeyDown(GLFW_KEY_DOWN)) {
-                transform->addRotation(Transform::RIGHT * -rotateSpeed);
-            }
+        // Rotation
+        if (input.isKeyDown(GLFW_KEY_RIGHT)) {
+            transform.addRotation(Transform::UP * -rotateSpeed);
         }
-    }
+        if (input.isKeyDown(GLFW_KEY_LEFT)) {
+            transform.addRotation(Transform::UP * rotateSpeed);
+        }
+        if (input.isKeyDown(GLFW_KEY_UP)) {
+            transform.addRotation(Transform::RIGHT * rotateSpeed);
+        }
+        if (input.isKeyDown(GLFW_KEY_DOWN)) {
+            transform.addRotation(Transform::RIGHT * -rotateSpeed);
+        }
+    });
 }
 
 void TestGame::render() {
@@ -2,6 +2,7 @@
 #define IVY_TEST_GAME_H
 
 #include "ivy/engine.h"
+#include "ivy/scene/spatial_index.h"
 #include "renderer.h"
 #include <vector>
 
@@ -21,6 +22,7 @@ private:
     ivy::Engine engine_;
     Renderer renderer_;
     ivy::Scene scene_;
+    ivy::SpatialIndex spatialIndex_;
 
     Renderer::DebugMode debugMode_ = Renderer::DebugMode::FULL;
 };